@@ -284,6 +284,7 @@ static consoleCommand_t commands[ ] =
   { "menu_team", CG_SpawnMenuTeam},
   { "nextframe", CG_TestModelNextFrame_f },
   { "nextskin", CG_TestModelNextSkin_f },
+  { "pmovebench", CG_PmoveBench_f },
   { "prevframe", CG_TestModelPrevFrame_f },
   { "prevskin", CG_TestModelPrevSkin_f },
   { "scoresDown", CG_scrollScoresDown_f },
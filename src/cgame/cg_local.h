@@ -1993,6 +1993,7 @@ void        CG_CapTrace(
   trace_t *result, const vec3_t start, const vec3_t mins, const vec3_t maxs,
   const vec3_t end, int skipNumber, qboolean clip_against_missiles,
   content_mask_t content_mask);
+void        CG_PmoveBench_f( void );
 void        CG_BiSphereTrace(
   trace_t *result, const vec3_t start, const vec3_t end,
   const float startRadius, const float endRadius, int skipNumber,
@@ -1707,3 +1707,116 @@ void CG_PredictPlayerState( void )
 
 
 }
+
+/*
+========================
+CG_PmoveBenchTrace
+
+Only the BSP, the same as the game's pmovebench
+========================
+*/
+static void CG_PmoveBenchTrace(
+  trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs,
+  const vec3_t end, int passEntityNum, qboolean clip_against_missiles,
+  const content_mask_t content_mask, traceType_t type) {
+  vec3_t zero = {0.0f, 0.0f, 0.0f};
+
+  if(!mins) {
+    mins = zero;
+  }
+  if(!maxs) {
+    maxs = zero;
+  }
+
+  switch(type) {
+    case TT_CAPSULE:
+      trap_CM_CapsuleTrace(
+        results, start, end, mins, maxs, 0, content_mask.include);
+      break;
+
+    case TT_BISPHERE:
+      trap_CM_BiSphereTrace(
+        results, start, end, mins[0], maxs[0], 0, content_mask.include);
+      break;
+
+    default:
+      trap_CM_BoxTrace(
+        results, start, end, mins, maxs, 0, content_mask.include);
+      break;
+  }
+
+  results->entityNum =
+    results->fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+}
+
+/*
+========================
+CG_PmoveBenchPointContents
+========================
+*/
+static int CG_PmoveBenchPointContents(
+  const vec3_t point, int passEntityNum) {
+  return trap_CM_PointContents(point, 0);
+}
+
+/*
+========================
+CG_PmoveBench_f
+
+Replays the streams the server's pmovebench wrote, so that the hashes
+of both can be compared
+========================
+*/
+void CG_PmoveBench_f(void) {
+  static pmoveReplay_t replay;
+  static const char    *defaultStreams[] = {"dretch", "marauder", "jetpack"};
+  bg_collision_funcs_t world;
+  pmoveReplayResult_t  result;
+  char                 buffer[MAX_TOKEN_CHARS];
+  char                 name[MAX_QPATH];
+  int                  runs, i, first, last;
+
+  trap_Argv(1, buffer, sizeof(buffer));
+  if(trap_Argc() > 1 && !Q_isanumber(buffer)) {
+    Com_Printf("usage: pmovebench [runs] [stream ...]\n");
+    return;
+  }
+
+  runs = trap_Argc() > 1 ? atoi(buffer) : 10;
+  if(runs < 1) {
+    runs = 1;
+  }
+
+  memset(&world, 0, sizeof(world));
+  world.trace = CG_PmoveBenchTrace;
+  world.pointcontents = CG_PmoveBenchPointContents;
+
+  first = trap_Argc() > 2 ? 2 : 0;
+  last = first ? trap_Argc() : ARRAY_LEN(defaultStreams);
+  for(i = first; i < last; i++) {
+    if(first) {
+      trap_Argv(i, name, sizeof(name));
+    } else {
+      Q_strncpyz(name, defaultStreams[i], sizeof(name));
+    }
+
+    if(!BG_PmoveReplayLoad(name, &replay)) {
+      Com_Printf("no pmove/%s.pmr, run pmovebench on the server first\n", name);
+      continue;
+    }
+
+    if(!replay.header.numCmds) {
+      continue;
+    }
+
+    BG_PmoveReplay(&replay, &world, runs, trap_Milliseconds, &result);
+
+    Com_Printf(
+      "%-12s %6d pmoves %8.0f ns/pmove %6.2f traces/pmove %6.2f contents/pmove "
+      "hash %08x end ( %.3f %.3f %.3f )\n", name, result.pmoves,
+      result.msec * 1000000.0 / result.pmoves,
+      (float)result.traces / result.pmoves,
+      (float)result.pointContents / result.pmoves,
+      result.hash, result.origin[0], result.origin[1], result.origin[2]);
+  }
+}
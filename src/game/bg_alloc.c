@@ -54,10 +54,22 @@ Use BG_StackPoolAlloc(), BG_StackPoolFree(), BG_StackPoolReset(), and
 BG_StackPoolMemoryInfo for the stack pool allocator, which is used for temporary
 allocation within function stacks.
 
+Use BG_FrameAlloc() for the frame arena, which holds allocations that are not
+needed past the frame they are made in.  Nothing is freed on its own, the whole
+arena is reset by BG_FrameArenaReset() at the start of every game frame.  A
+function that only needs its allocations for a while can take a mark with
+BG_FrameArenaMark() and give everything allocated since back with
+BG_FrameArenaRelease().  Marks must be released in the reverse order they were
+taken, and anything allocated after a mark is gone once it is released.
+
 For types that are frequently reallocated, custom allocators dedicated to
 specific types can be created using the allocator_protos() and allocator()
 macros.  Those two macros are located in bg_alloc.h
 
+Custom allocators that have to be used from more than one thread at once can
+be created with the allocator_mt_protos() and allocator_mt() macros instead,
+which are only available outside of the QVMs.
+
 For memory debugging, BG_MemoryInfo() gives a general overview of all the
 allocators, and each custom allocotor comes with its own memoryInfo_##name()
 function, so be sure to add a call to that function inside BG_MemoryInfo() when
@@ -87,6 +99,7 @@ macro wrappers.
 // Set the maximum memory usage for each module here.
 #ifdef GAME
 #define STACK_POOL_SIZE                  ( 64 * 1024 )
+#define FRAME_ARENA_SIZE                 ( 256 * 1024 )
 #define MAX_MEMORY_CLASS_00_NUM_OF_CHUNKS ( 4 * 1024 )
 #define MAX_MEMORY_CLASS_01_NUM_OF_CHUNKS ( 2 * 1024 )
 #define MAX_MEMORY_CLASS_02_NUM_OF_CHUNKS ( 2 * 1024 )
@@ -101,6 +114,7 @@ macro wrappers.
 #else
 #ifdef CGAME
 #define STACK_POOL_SIZE                  ( 64 * 1024 )
+#define FRAME_ARENA_SIZE                 ( 16 * 1024 )
 #define MAX_MEMORY_CLASS_00_NUM_OF_CHUNKS ( 4 * 1024 )
 #define MAX_MEMORY_CLASS_01_NUM_OF_CHUNKS ( 2 * 1024 )
 #define MAX_MEMORY_CLASS_02_NUM_OF_CHUNKS 1024
@@ -114,6 +128,7 @@ macro wrappers.
 #define MAX_MEMORY_CLASS_10_NUM_OF_CHUNKS 64
 #else // for the UI
 #define STACK_POOL_SIZE                   ( 32 * 1024 )
+#define FRAME_ARENA_SIZE                  ( 16 * 1024 )
 #define MAX_MEMORY_CLASS_00_NUM_OF_CHUNKS 1024
 #define MAX_MEMORY_CLASS_01_NUM_OF_CHUNKS 512
 #define MAX_MEMORY_CLASS_02_NUM_OF_CHUNKS 256
@@ -206,6 +221,8 @@ static const bgMemoryClass_t memClasses[ ] =
 
 #define NUMBER_OF_MEMORY_CLASSES ( ARRAY_LEN( memClasses ) )
 
+static void BG_FrameArenaClearStats( void );
+
 static const bgMemoryClass_t *memClassesSortedChunkSize[ NUMBER_OF_MEMORY_CLASSES ]; // used for BG_Alloc()
 static const bgMemoryClass_t *memClassesSortedBufferAddress[ NUMBER_OF_MEMORY_CLASSES ]; // used for BG_Free()
 
@@ -358,6 +375,10 @@ void  _BG_InitMemory( char *calledFile, int calledLine )
   // Init the memory stack pool
   BG_StackPoolReset( );
 
+  // Init the frame arena
+  BG_FrameArenaReset( );
+  BG_FrameArenaClearStats( );
+
   // Init the memory for custom allocators
   BG_Link_Init_Memory( calledFile, calledLine );
   BG_List_Init_Memory( calledFile, calledLine );
@@ -462,6 +483,7 @@ void BG_MemoryInfo( void )
     (*memClassesSortedChunkSize[ i ]).memoryInfo( );
 
   BG_StackPoolMemoryInfo( );
+  BG_FrameArenaMemoryInfo( );
 
   Com_Printf( "^5=================^7\n" );
   Com_Printf( "^3Custom Allocators^7\n"  );
@@ -574,3 +596,139 @@ void BG_StackPoolMemoryInfo( void )
               stack_pool, &stack_pool[STACK_POOL_SIZE - 1] );
   Com_Printf( "^5---------------------------------------------^7\n" );
 }
+
+/*
+-------------------------------------------------------------------------------
+Frame Arena
+
+For allocations that are not needed past the frame they are made in
+--------------------------------------------------------------------------------
+*/
+static uint8_t frame_arena[FRAME_ARENA_SIZE] __attribute__ ((aligned (16)));
+static uint8_t *frame_arena_ptr = frame_arena;
+
+static struct
+{
+  int    frames; // number of resets since BG_InitMemory()
+  int    allocs; // allocations in the current frame
+  int    lastAllocs;
+  size_t peak; // highest the arena has been in the current frame
+  size_t lastPeak;
+  size_t maxPeak; // highest peak of all the frames
+  int    maxPeakFrame;
+} frame_arena_stats;
+
+/*
+======================
+_BG_FrameAlloc
+
+Returns memory that stays valid until the end of the frame, or until a mark
+taken before it is released
+======================
+*/
+void *_BG_FrameAlloc( size_t size, char *calledFile, int calledLine )
+{
+  uint8_t *ptr = frame_arena_ptr;
+
+  size = PAD( size, (size_t)16 );
+  assertMemFrame( ( size > 0 ),
+                  "BG_FrameAlloc",
+                  calledFile, calledLine );
+  assertMemFrame( ( size <= (size_t)( ( frame_arena + FRAME_ARENA_SIZE ) - frame_arena_ptr ) ),
+                  "BG_FrameAlloc: out of memory", calledFile, calledLine );
+
+  frame_arena_ptr += size;
+
+  frame_arena_stats.allocs++;
+  if( (size_t)( frame_arena_ptr - frame_arena ) > frame_arena_stats.peak )
+    frame_arena_stats.peak = frame_arena_ptr - frame_arena;
+
+  return ptr;
+}
+
+/*
+======================
+BG_FrameArenaMark
+======================
+*/
+void *BG_FrameArenaMark( void )
+{
+  return frame_arena_ptr;
+}
+
+/*
+======================
+_BG_FrameArenaRelease
+
+Gives back everything allocated since the mark was taken
+======================
+*/
+void _BG_FrameArenaRelease( void *mark, char *calledFile, int calledLine )
+{
+  assertMemFrame( ( (uint8_t *)mark >= frame_arena &&
+                    (uint8_t *)mark <= frame_arena_ptr ),
+                  "BG_FrameArenaRelease: mark is not in use",
+                  calledFile, calledLine );
+
+  frame_arena_ptr = mark;
+}
+
+/*
+======================
+BG_FrameArenaReset
+
+Gives back everything in the arena, at the start of every game frame
+======================
+*/
+void BG_FrameArenaReset( void )
+{
+  frame_arena_ptr = frame_arena;
+
+  frame_arena_stats.frames++;
+  frame_arena_stats.lastAllocs = frame_arena_stats.allocs;
+  frame_arena_stats.lastPeak = frame_arena_stats.peak;
+  if( frame_arena_stats.peak > frame_arena_stats.maxPeak )
+  {
+    frame_arena_stats.maxPeak = frame_arena_stats.peak;
+    frame_arena_stats.maxPeakFrame = frame_arena_stats.frames;
+  }
+  frame_arena_stats.allocs = 0;
+  frame_arena_stats.peak = 0;
+}
+
+/*
+======================
+BG_FrameArenaClearStats
+======================
+*/
+static void BG_FrameArenaClearStats( void )
+{
+  memset( &frame_arena_stats, 0, sizeof( frame_arena_stats ) );
+}
+
+/*
+======================
+BG_FrameArenaMemoryInfo
+
+Used for debugging the frame arena
+======================
+*/
+void BG_FrameArenaMemoryInfo( void )
+{
+  Com_Printf( "^5===============================\n" );
+  Com_Printf( "^3Memory Info for the Frame Arena\n" );
+  Com_Printf( "^5===============================\n" );
+  Com_Printf( "^3Frame Arena Size: ^6%i bytes\n", FRAME_ARENA_SIZE );
+  Com_Printf( "^3Allocated Memory: ^6%i bytes\n",
+              (int)( frame_arena_ptr - frame_arena ) );
+  Com_Printf( "^3Peak This Frame: ^6%i bytes in %i allocations\n",
+              (int)frame_arena_stats.peak, frame_arena_stats.allocs );
+  Com_Printf( "^3Peak Last Frame: ^6%i bytes in %i allocations\n",
+              (int)frame_arena_stats.lastPeak, frame_arena_stats.lastAllocs );
+  Com_Printf( "^3Highest Peak: ^6%i bytes ^3in frame ^6%i ^3of ^6%i\n",
+              (int)frame_arena_stats.maxPeak, frame_arena_stats.maxPeakFrame,
+              frame_arena_stats.frames );
+  Com_Printf( "^3Frame Arena Address Range: from (^60x%p^3) to (^60x%p^3)\n",
+              frame_arena, &frame_arena[FRAME_ARENA_SIZE - 1] );
+  Com_Printf( "^5---------------------------------------------^7\n" );
+}
@@ -52,10 +52,22 @@ Use BG_StackPoolAlloc(), BG_StackPoolFree(), BG_StackPoolReset(), and
 BG_StackPoolMemoryInfo for the stack pool allocator, which is used for temporary
 allocation within function stacks.
 
+Use BG_FrameAlloc() for the frame arena, which holds allocations that are not
+needed past the frame they are made in.  Nothing is freed on its own, the whole
+arena is reset by BG_FrameArenaReset() at the start of every game frame.  A
+function that only needs its allocations for a while can take a mark with
+BG_FrameArenaMark() and give everything allocated since back with
+BG_FrameArenaRelease().  Marks must be released in the reverse order they were
+taken, and anything allocated after a mark is gone once it is released.
+
 For types that are frequently reallocated, custom allocators dedicated to
 specific types can be created using the allocator_protos() and allocator()
 macros.  Those two macros are located in bg_alloc.h
 
+Custom allocators that have to be used from more than one thread at once can
+be created with the allocator_mt_protos() and allocator_mt() macros instead,
+which are only available outside of the QVMs.
+
 For memory debugging, BG_MemoryInfo() gives a general overview of all the
 allocators, and each custom allocotor comes with its own memoryInfo_##name()
 function, so be sure to add a call to that function inside BG_MemoryInfo() when
@@ -83,6 +95,7 @@ macro wrappers.
   #define assertMemKindChunk( ignore, blank, nothing, calledFile, calledLine )((void) 0)
   #define assertMemStack(ignore, calledFile, calledLine)((void) 0)
   #define assertMemStackChunk(ignore, blank,nothing, calledFile, calledLine)((void) 0)
+  #define assertMemFrame(ignore, blank, calledFile, calledLine)((void) 0)
 #else
   #define BG_MemFuncCalledFrom( calledFile, calledLine ) \
     Com_Printf( "^3Called from: ^6%s^3:^6%d^7\n", calledFile, calledLine );
@@ -145,6 +158,13 @@ macro wrappers.
         Com_Error( ERR_DROP, "%s:%d: Assertion `%s' failed", \
                    __FILE__, __LINE__, #errString ); \
       }
+  #define assertMemFrame(expr, errString, calledFile, calledLine) \
+      if( !( expr ) ){ \
+        BG_MemoryInfo(); \
+        BG_MemFuncCalledFrom( calledFile, calledLine ); \
+        Com_Error( ERR_DROP, "%s:%d: Assertion `%s' failed", \
+                   __FILE__, __LINE__, #errString ); \
+      }
 #endif
 
 /*
@@ -259,6 +279,197 @@ inremented towards the end of unused_##name[].
     *stack_##name = ptr; \
   }
 
+#ifndef Q3_VM
+/*
+======================
+allocator_mt_protos
+
+The allocator_protos() of allocator_mt(), with flushCache_##name() added.
+======================
+*/
+#define allocator_mt_protos(name) \
+  static int unused_memory_chunks_##name(void); \
+  static void memoryInfo_##name(void); \
+  static void initPool_##name(char *calledFile, int calledLine); \
+  static void *alloc_##name(char *calledFile, int calledLine); \
+  static void free_##name(void *ptr, char *calledFile, int calledLine); \
+  static void flushCache_##name(void);
+
+#if defined( _MSC_VER )
+  #define BG_THREAD_LOCAL __declspec( thread )
+#else
+  #define BG_THREAD_LOCAL __thread
+#endif
+
+// the number of chunks each thread can keep for itself
+#define ALLOCATOR_MT_CACHE_SIZE 32
+
+/*
+======================
+allocator_mt
+
+A variant of the allocator macro that can be used from any number of threads
+at once, with the same memory pool layout, guard bytes and memoryInfo_##name()
+diagnostics.  It isn't available to the QVMs, which have no threads.
+
+Free chunks are kept on a shared lock-free stack, head_##name, linked by chunk
+index through next_##name[].  The stack's head holds a tag that is bumped on
+every change along with the index of the top chunk, so that a thread whose
+compare and swap raced with other threads popping and pushing back the same
+chunk fails instead of corrupting the stack.  Each thread also keeps up to
+ALLOCATOR_MT_CACHE_SIZE chunks of its own in cache_##name[], so most
+allocations and frees don't touch the shared stack at all.  A thread that runs
+out takes half a cache from the shared stack, and a thread whose cache is full
+gives half of it back.
+
+A thread that is about to exit must call flushCache_##name() to give the chunks
+it kept back.  initPool_##name() must only be called while no other thread is
+using the allocator, it makes every thread drop its cache the next time it
+allocates or frees.
+======================
+*/
+#define allocator_mt(name,size,count) \
+  static uint8_t buffer_##name[(count) * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16)] __attribute__ ((aligned (16))); \
+  static int next_##name[(count)]; \
+  static uint64_t head_##name; \
+  static int shared_##name; \
+  static int used_##name; \
+  static int generation_##name; \
+  static BG_THREAD_LOCAL int cacheGeneration_##name; \
+  static BG_THREAD_LOCAL int cacheCount_##name; \
+  static BG_THREAD_LOCAL int cache_##name[ALLOCATOR_MT_CACHE_SIZE]; \
+  static void push_##name(int first, int last, int num){ \
+    uint64_t old = __atomic_load_n(&head_##name, __ATOMIC_ACQUIRE); \
+    uint64_t new; \
+    do { \
+      __atomic_store_n(&next_##name[last], (int)(old & 0xFFFFFFFF) - 1, __ATOMIC_RELAXED); \
+      new = (((old >> 32) + 1) << 32) | (uint64_t)(first + 1); \
+    } while(!__atomic_compare_exchange_n(&head_##name, &old, new, qtrue, \
+                                         __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)); \
+    __atomic_add_fetch(&shared_##name, num, __ATOMIC_RELAXED); \
+  } \
+  static int pop_##name(void){ \
+    uint64_t old = __atomic_load_n(&head_##name, __ATOMIC_ACQUIRE); \
+    uint64_t new; \
+    int top; \
+    do { \
+      top = (int)(old & 0xFFFFFFFF) - 1; \
+      if(top < 0) \
+        return -1; \
+      new = (((old >> 32) + 1) << 32) | \
+            (uint64_t)(__atomic_load_n(&next_##name[top], __ATOMIC_RELAXED) + 1); \
+    } while(!__atomic_compare_exchange_n(&head_##name, &old, new, qtrue, \
+                                         __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)); \
+    __atomic_sub_fetch(&shared_##name, 1, __ATOMIC_RELAXED); \
+    return top; \
+  } \
+  static void checkCache_##name(void){ \
+    int generation = __atomic_load_n(&generation_##name, __ATOMIC_ACQUIRE); \
+    if(cacheGeneration_##name != generation) { \
+      cacheGeneration_##name = generation; \
+      cacheCount_##name = 0; \
+    } \
+  } \
+  static void giveBack_##name(int num){ \
+    int i, first = cacheCount_##name - num; \
+    if(num <= 0) \
+      return; \
+    for(i = first; i < cacheCount_##name - 1; i++) \
+      __atomic_store_n(&next_##name[cache_##name[i]], cache_##name[i + 1], __ATOMIC_RELAXED); \
+    push_##name(cache_##name[first], cache_##name[cacheCount_##name - 1], num); \
+    cacheCount_##name = first; \
+  } \
+  static void flushCache_##name(void){ \
+    checkCache_##name(); \
+    giveBack_##name(cacheCount_##name); \
+  } \
+  static int unused_memory_chunks_##name(void) { \
+    return (count) - __atomic_load_n(&used_##name, __ATOMIC_RELAXED); \
+  } \
+  static void memoryInfo_##name(void){ \
+    int used = __atomic_load_n(&used_##name, __ATOMIC_RELAXED); \
+    int shared = __atomic_load_n(&shared_##name, __ATOMIC_RELAXED); \
+    Com_Printf("^5---------------------------------------------^7\n"); \
+    Com_Printf("^3Memory Info for Allocator ( ^6" #name "^3 )^7\n"); \
+    Com_Printf("^5---------------------------------------------^7\n"); \
+    if(!__atomic_load_n(&generation_##name, __ATOMIC_RELAXED)) \
+    { \
+      Com_Printf("^3pool not initialized.^7\n"); \
+      Com_Printf("^5---------------------------------------------^7\n"); \
+      return; \
+    } \
+    Com_Printf("^3Memory Pool Size: ^6%i bytes^7\n", (int)((count) * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16))); \
+    Com_Printf("^3Free Memory: ^6%i bytes^7\n", \
+               (int)(((count) - used) * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16))); \
+    Com_Printf("^3Allocated Memory: ^6%i bytes^7\n", \
+               (int)(used * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16))); \
+    Com_Printf("^3Size of Chunks: ^6%i bytes^7\n", (int)(((size_t)(size) & ~((size_t)0xF)) + (size_t)16)); \
+    Com_Printf("^3Total Number of Chunks: ^6%i^7\n", (int)(count)); \
+    Com_Printf("^3Number of Unused Chunks: ^6%i^7\n", (count) - used); \
+    Com_Printf("^3Number of Unused Chunks in Thread Caches: ^6%i^7\n", \
+               (count) - used - shared); \
+    Com_Printf("^3Number of Used Chunks: ^6%i^7\n", used); \
+    Com_Printf("^3Memory Pool Address Range: from (^60x%p^3) to (^60x%p^3)^7\n", \
+               buffer_##name, &buffer_##name[ ARRAY_LEN( buffer_##name ) - 1 ]); \
+    Com_Printf("^5---------------------------------------------^7\n"); \
+  } \
+  static void initPool_##name(char *calledFile, int calledLine){ \
+    int i; \
+    uint8_t *temp = buffer_##name; \
+    assertMem(((size) > 0 && "size must be greater than 0."), calledFile, calledLine); \
+    assertMem(((count) > 0 && "count must be greater than 0."), calledFile, calledLine); \
+    for(i = 0;i < (count);i++,temp += (((size_t)(size) & ~((size_t)0xF)) + (size_t)16)){ \
+      *((uint8_t *)temp + (size)) = 0; \
+      next_##name[i] = i + 1 < (count) ? i + 1 : -1; \
+    } \
+    shared_##name = (count); \
+    used_##name = 0; \
+    head_##name = ((((head_##name >> 32) + 1) << 32) | 1); \
+    __atomic_add_fetch(&generation_##name, 1, __ATOMIC_RELEASE); \
+  } \
+  static void *alloc_##name(char *calledFile, int calledLine){ \
+    uint8_t *ptr; \
+    uint8_t guard; \
+    assertMem((__atomic_load_n(&generation_##name, __ATOMIC_RELAXED) && "pool not initialized."), calledFile, calledLine); \
+    checkCache_##name(); \
+    if(!cacheCount_##name) { \
+      while(cacheCount_##name < ALLOCATOR_MT_CACHE_SIZE / 2) { \
+        int chunk = pop_##name(); \
+        if(chunk < 0) \
+          break; \
+        cache_##name[cacheCount_##name++] = chunk; \
+      } \
+    } \
+    assertMemKind((cacheCount_##name > 0 && "out of memory."), name, calledFile, calledLine); \
+    ptr = buffer_##name + \
+          cache_##name[--cacheCount_##name] * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16); \
+    guard = __atomic_exchange_n((uint8_t *)ptr + (size), 0x1A, __ATOMIC_RELAXED); \
+    assertMemKind((guard == 0 && "invalid memory access"), name, calledFile, calledLine); \
+    (void)guard; \
+    __atomic_add_fetch(&used_##name, 1, __ATOMIC_RELAXED); \
+    return ptr; \
+  } \
+  static void free_##name(void *ptr, char *calledFile, int calledLine){ \
+    uint8_t guard; \
+    assertMemKindChunk(((uint8_t *)ptr >= buffer_##name &&  \
+                    (uint8_t *)ptr < buffer_##name + ((count) * (((size_t)(size) & ~((size_t)0xF)) + (size_t)16)) && \
+                    "out of bounds."), name, ptr, calledFile, calledLine); \
+    assertMemKindChunk((((uint8_t *)ptr - buffer_##name) % (((size_t)(size) & ~((size_t)0xF)) + (size_t)16) == 0 && \
+                    "not head of chunk."), name, ptr, calledFile, calledLine); \
+    guard = __atomic_exchange_n((uint8_t *)ptr + (size), 0, __ATOMIC_RELAXED); \
+    assertMemKindChunk((guard == 0x1A && \
+                       "invalid memory access or pointer freed more than once"), \
+                       name, ptr, calledFile, calledLine); \
+    (void)guard; \
+    checkCache_##name(); \
+    if(cacheCount_##name == ALLOCATOR_MT_CACHE_SIZE) \
+      giveBack_##name(ALLOCATOR_MT_CACHE_SIZE / 2); \
+    cache_##name[cacheCount_##name++] = \
+      (int)(((uint8_t *)ptr - buffer_##name) / (((size_t)(size) & ~((size_t)0xF)) + (size_t)16)); \
+    __atomic_sub_fetch(&used_##name, 1, __ATOMIC_RELAXED); \
+  }
+#endif
+
 // Used to init all BGAME memory allocators  
 void  _BG_InitMemory( char *calledFile, int calledLine );
 
@@ -303,6 +514,20 @@ void BG_StackPoolReset( void ); // BG_StackPoolReset is used in
                                         // use with caution.
 void BG_StackPoolMemoryInfo( void ); // Used for debugging the stack pool
                                      // allocator
+
+// for the frame arena, which holds allocations that are not needed past the
+// frame they are made in
+void *_BG_FrameAlloc( size_t size, char *calledFile, int calledLine ); // returns unitialized memory
+void *BG_FrameArenaMark( void );
+void _BG_FrameArenaRelease( void *mark, char *calledFile, int calledLine );
+
+#define BG_FrameAlloc( size ) _BG_FrameAlloc( size, __FILE__, __LINE__ )
+#define BG_FrameArenaRelease( mark ) _BG_FrameArenaRelease( mark, __FILE__, __LINE__ )
+
+void BG_FrameArenaReset( void ); // called at the start of every game frame, and
+                                 // in BG_InitMemory()
+void BG_FrameArenaMemoryInfo( void ); // shows the peak usage of the frames
+                                      // since BG_InitMemory()
 /*
 ================================================================================
 */
@@ -292,6 +292,15 @@ void BG_Init_Collision_Functions(bg_collision_funcs_t funcs) {
   bg_collision_funcs = funcs;
 }
 
+/*
+============
+BG_Collision_Functions
+============
+*/
+bg_collision_funcs_t BG_Collision_Functions(void) {
+  return bg_collision_funcs;
+}
+
 /*
 ============
 BG_Trace
@@ -36,6 +36,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #else
   int  FS_FOpenFileByMode( const char *qpath, fileHandle_t *f, fsMode_t mode );
   int  FS_Read2( void *buffer, int len, fileHandle_t f );
+  int  FS_Write( const void *buffer, int len, fileHandle_t f );
   void FS_FCloseFile( fileHandle_t f );
   int  FS_GetFileList(  const char *path, const char *extension, char *listbuf, int bufsize );
 #endif
@@ -78,12 +79,16 @@ qboolean BG_Check_Game_Mode_Name(
   }
 }
 
-static void BG_InitTeamConfigs(char *game_mode);
-static void BG_InitMODConfigs(char *game_mode);
-static void BG_InitClassConfigs(char *game_mode);
-static void BG_InitBuildableConfigs(char *game_mode);
-static void BG_InitUpgradeConfigs(char *game_mode);
-static void BG_InitWeaponConfigs(char *game_mode);
+static qboolean BG_InitTeamConfigs(char *game_mode);
+static qboolean BG_InitMODConfigs(char *game_mode);
+static qboolean BG_InitClassConfigs(char *game_mode);
+static qboolean BG_InitBuildableConfigs(char *game_mode);
+static qboolean BG_InitUpgradeConfigs(char *game_mode);
+static qboolean BG_InitWeaponConfigs(char *game_mode);
+
+static qboolean BG_LoadGameModeCache(const char *game_mode, unsigned int hash);
+static void BG_SaveGameModeCache(const char *game_mode, unsigned int hash);
+static unsigned int BG_GameModeSourceHash(const char *game_mode);
 
 static char game_mode[MAX_TOKEN_CHARS];
 
@@ -121,19 +126,36 @@ qboolean BG_Is_Current_Game_Mode(const char *game_mode_raw_check) {
 /*
 ================
 BG_Init_Game_Mode
+
+Fills in the config lists from the game mode's cache if the cache was built
+from the config files as they are now, otherwise from the config files.
 ================
 */
 void BG_Init_Game_Mode(char *game_mode_raw) {
+  unsigned int hash;
+  qboolean     parsed;
+
   if(!BG_Check_Game_Mode_Name(game_mode_raw, game_mode, MAX_TOKEN_CHARS)) {
     Q_strncpyz(game_mode, DEFAULT_GAME_MODE, MAX_TOKEN_CHARS);
   }
 
-  BG_InitTeamConfigs(game_mode);
-  BG_InitMODConfigs(game_mode);
-  BG_InitClassConfigs(game_mode);
-  BG_InitBuildableConfigs(game_mode);
-  BG_InitUpgradeConfigs(game_mode);
-  BG_InitWeaponConfigs(game_mode);
+  hash = BG_GameModeSourceHash(game_mode);
+  if(BG_LoadGameModeCache(game_mode, hash)) {
+    return;
+  }
+
+  parsed = qtrue;
+  parsed &= BG_InitTeamConfigs(game_mode);
+  parsed &= BG_InitMODConfigs(game_mode);
+  parsed &= BG_InitClassConfigs(game_mode);
+  parsed &= BG_InitBuildableConfigs(game_mode);
+  parsed &= BG_InitUpgradeConfigs(game_mode);
+  parsed &= BG_InitWeaponConfigs(game_mode);
+
+  // only cache a mode that parsed cleanly, so its errors keep being reported
+  if(parsed) {
+    BG_SaveGameModeCache(game_mode, hash);
+  }
 }
 
 /*
@@ -804,6 +826,15 @@ const teamConfig_t *BG_TeamConfig(team_t team) {
   return &bg_teamConfigList[team];
 }
 
+/*
+===============
+BG_TeamConfigPath
+===============
+*/
+static const char *BG_TeamConfigPath(const char *game_mode, team_t team) {
+  return va("game_modes/%s/teams/%s.cfg", game_mode, BG_Team(team)->name);
+}
+
 /*
 ======================
 BG_ParseTeamFile
@@ -891,17 +922,19 @@ return qtrue;
 BG_InitTeamConfigs
 ===============
 */
-static void BG_InitTeamConfigs(char *game_mode) {
+static qboolean BG_InitTeamConfigs(char *game_mode) {
   int               i;
   teamConfig_t *tc;
+  qboolean          parsed = qtrue;
 
   for(i = TEAM_NONE; i < NUM_TEAMS; i++) {
     tc = &bg_teamConfigList[i];
     Com_Memset(tc, 0, sizeof(teamConfig_t));
 
-    BG_ParseTeamFile(
-      va("game_modes/%s/teams/%s.cfg", game_mode, BG_Team( i )->name), tc);
+    parsed &= BG_ParseTeamFile(BG_TeamConfigPath(game_mode, i), tc);
   }
+
+  return parsed;
 }
 
 /*
@@ -923,6 +956,15 @@ const modConfig_t *BG_MODConfig(meansOfDeath_t mod) {
   return &bg_modConfigList[mod];
 }
 
+/*
+===============
+BG_MODConfigPath
+===============
+*/
+static const char *BG_MODConfigPath(const char *game_mode, meansOfDeath_t mod) {
+  return va("game_modes/%s/means_of_death/%s.cfg", game_mode, BG_MOD(mod)->name);
+}
+
 /*
 ======================
 BG_ParseMODFile
@@ -1075,21 +1117,19 @@ static qboolean BG_ParseMODFile(const char *filename, modConfig_t *mc) {
 BG_InitMODConfigs
 ===============
 */
-static void BG_InitMODConfigs(char *game_mode) {
+static qboolean BG_InitMODConfigs(char *game_mode) {
   int               i;
   modConfig_t *mc;
+  qboolean          parsed = qtrue;
 
   for(i = 0; i < NUM_MODS; i++) {
     mc = &bg_modConfigList[i];
     Com_Memset(mc, 0, sizeof(teamConfig_t));
 
-    BG_ParseMODFile(
-      va(
-        "game_modes/%s/means_of_death/%s.cfg",
-        game_mode,
-        BG_MOD( i )->name),
-      mc);
+    parsed &= BG_ParseMODFile(BG_MODConfigPath(game_mode, i), mc);
   }
+
+  return parsed;
 }
 
 /*
@@ -1111,6 +1151,15 @@ const classConfig_t *BG_ClassConfig(class_t class) {
   return &bg_classConfigList[class];
 }
 
+/*
+===============
+BG_ClassConfigPath
+===============
+*/
+static const char *BG_ClassConfigPath(const char *game_mode, class_t class) {
+  return va("game_modes/%s/classes/%s.cfg", game_mode, BG_Class(class)->name);
+}
+
 /*
 ======================
 BG_ParseClassFile
@@ -1408,16 +1457,18 @@ static qboolean BG_ParseClassFile(const char *filename, classConfig_t *cc) {
 BG_InitClassConfigs
 ===============
 */
-static void BG_InitClassConfigs(char *game_mode) {
+static qboolean BG_InitClassConfigs(char *game_mode) {
   int           i;
   classConfig_t *cc;
+  qboolean      parsed = qtrue;
 
   for(i = PCL_NONE; i < PCL_NUM_CLASSES; i++) {
     cc = &bg_classConfigList[i];
 
-    BG_ParseClassFile(
-      va("game_modes/%s/classes/%s.cfg", game_mode, BG_Class(i)->name), cc);
+    parsed &= BG_ParseClassFile(BG_ClassConfigPath(game_mode, i), cc);
   }
+
+  return parsed;
 }
 
 /*
@@ -1439,6 +1490,16 @@ const buildableConfig_t *BG_BuildableConfig(buildable_t buildable) {
   return &bg_buildableConfigList[buildable];
 }
 
+/*
+===============
+BG_BuildableConfigPath
+===============
+*/
+static const char *BG_BuildableConfigPath(
+  const char *game_mode, buildable_t buildable) {
+  return va("game_modes/%s/buildables/%s.cfg", game_mode, BG_Buildable(buildable)->name);
+}
+
 /*
 ======================
 BG_ParseBuildableFile
@@ -1618,18 +1679,19 @@ static qboolean BG_ParseBuildableFile(
 BG_InitBuildableConfigs
 ===============
 */
-static void BG_InitBuildableConfigs(char *game_mode) {
+static qboolean BG_InitBuildableConfigs(char *game_mode) {
   int               i;
   buildableConfig_t *bc;
+  qboolean          parsed = qtrue;
 
   for(i = BA_NONE + 1; i < BA_NUM_BUILDABLES; i++) {
     bc = &bg_buildableConfigList[i];
     Com_Memset(bc, 0, sizeof(buildableConfig_t));
 
-    BG_ParseBuildableFile(
-      va("game_modes/%s/buildables/%s.cfg", game_mode, BG_Buildable(i)->name),
-      bc);
+    parsed &= BG_ParseBuildableFile(BG_BuildableConfigPath(game_mode, i), bc);
   }
+
+  return parsed;
 }
 
 /*
@@ -1655,7 +1717,6 @@ static const weaponModeConfig_t weapon_mode_default =
 {
   {                   //missileConfig_t missile;
     qfalse,             //qboolean       enabled;
-    "",                 //char           *class_name;
     MOD_UNKNOWN,        //meansOfDeath_t mod;
     MOD_UNKNOWN,        //meansOfDeath_t splash_mod;
     qfalse,             //qboolean       selective_damage;
@@ -1704,7 +1765,8 @@ static const weaponModeConfig_t weapon_mode_default =
     0,                  //int            scale_start_time;
     0,                  //int            scale_stop_time;
     {0.0f, 0.0f, 0.0f}, //vec3_t         scale_stop_mins;
-    {0.0f, 0.0f, 0.0f}  //vec3_t         scale_stop_maxs;
+    {0.0f, 0.0f, 0.0f}, //vec3_t         scale_stop_maxs;
+    ""                  //char           *class_name;
   }
 };
 
@@ -2170,6 +2232,15 @@ static qboolean BG_ParseWeaponModeConfig(weaponModeConfig_t *wmc, char **text_p)
   return qfalse;
 }
 
+/*
+===============
+BG_WeaponConfigPath
+===============
+*/
+static const char *BG_WeaponConfigPath(const char *game_mode, weapon_t weapon) {
+  return va("game_modes/%s/weapons/%s.cfg", game_mode, BG_Weapon(weapon)->name);
+}
+
 /*
 ======================
 BG_ParseWeaponFile
@@ -2268,10 +2339,11 @@ return qtrue;
 BG_InitWeaponConfigs
 ===============
 */
-static void BG_InitWeaponConfigs(char *game_mode) {
+static qboolean BG_InitWeaponConfigs(char *game_mode) {
   int               i;
   weaponConfig_t    *wc;
   weaponMode_t  mode = WPM_NONE;
+  qboolean          parsed = qtrue;
 
   for(i = WP_NONE + 1; i < WP_NUM_WEAPONS; i++) {
     wc = &bg_weaponConfigList[i];
@@ -2282,9 +2354,10 @@ static void BG_InitWeaponConfigs(char *game_mode) {
       wc->mode[mode] = weapon_mode_default;
     }
 
-    BG_ParseWeaponFile(
-      va("game_modes/%s/weapons/%s.cfg", game_mode, BG_Weapon(i)->name), wc);
+    parsed &= BG_ParseWeaponFile(BG_WeaponConfigPath(game_mode, i), wc);
   }
+
+  return parsed;
 }
 
 /*
@@ -2306,6 +2379,15 @@ const upgradeConfig_t *BG_UpgradeConfig(upgrade_t upgrade) {
   return &bg_upgradeConfigList[upgrade];
 }
 
+/*
+===============
+BG_UpgradeConfigPath
+===============
+*/
+static const char *BG_UpgradeConfigPath(const char *game_mode, upgrade_t upgrade) {
+  return va("game_modes/%s/upgrades/%s.cfg", game_mode, BG_Upgrade(upgrade)->name);
+}
+
 /*
 ======================
 BG_ParseUpgradeFile
@@ -2393,15 +2475,330 @@ return qtrue;
 BG_InitUpgradeConfigs
 ===============
 */
-static void BG_InitUpgradeConfigs(char *game_mode) {
+static qboolean BG_InitUpgradeConfigs(char *game_mode) {
   int               i;
   upgradeConfig_t    *uc;
+  qboolean          parsed = qtrue;
 
   for(i = UP_NONE + 1; i < UP_NUM_UPGRADES; i++) {
     uc = &bg_upgradeConfigList[i];
     Com_Memset(uc, 0, sizeof( upgradeConfig_t ));
 
-    BG_ParseUpgradeFile(
-      va("game_modes/%s/upgrades/%s.cfg", game_mode, BG_Upgrade(i)->name), uc);
+    parsed &= BG_ParseUpgradeFile(BG_UpgradeConfigPath(game_mode, i), uc);
+  }
+
+  return parsed;
+}
+
+/*
+======================================================================
+
+Game Mode Cache
+
+The parsed config lists of a game mode are written as they are to
+cache/game_modes/<game mode>.dat, along with a hash of the config files they
+were parsed from.  As long as the config files hash the same, later loads of
+the game mode read the lists back from the cache instead of tokenizing every
+file again.  The hash also covers the build that wrote the cache, the layout
+of the lists and the defaults the parsers fill them from, so a cache is only
+read by the module and build that wrote it.
+
+======================================================================
+*/
+
+#define GAME_MODE_CACHE_IDENT   (('C'<<24)+('M'<<16)+('G'<<8)+'G')
+#define GAME_MODE_CACHE_VERSION 1
+
+// each module keeps its own, as their builds differ
+#if defined(GAME)
+#define GAME_MODE_CACHE_MODULE "game"
+#elif defined(CGAME)
+#define GAME_MODE_CACHE_MODULE "cgame"
+#else
+#define GAME_MODE_CACHE_MODULE "ui"
+#endif
+
+#define GMC_OFFSET(type, field) ((int)(size_t)&(((type *)0)->field))
+
+typedef enum
+{
+  GMC_TEAMS,
+  GMC_MODS,
+  GMC_CLASSES,
+  GMC_BUILDABLES,
+  GMC_WEAPONS,
+  GMC_UPGRADES,
+
+  GMC_NUM_LISTS
+} gameModeCacheList_t;
+
+typedef struct gameModeCacheHeader_s
+{
+  int          ident;
+  int          version;
+  unsigned int hash;
+  int          sizes[GMC_NUM_LISTS];
+} gameModeCacheHeader_t;
+
+/*
+===============
+BG_GameModeCachePath
+===============
+*/
+static const char *BG_GameModeCachePath(const char *game_mode) {
+  return va("cache/game_modes/%s." GAME_MODE_CACHE_MODULE ".dat", game_mode);
+}
+
+/*
+===============
+BG_GameModeCacheLists
+
+The lists in the order they are stored in a cache
+===============
+*/
+static void BG_GameModeCacheLists(void **lists, int *sizes) {
+  lists[GMC_TEAMS] = bg_teamConfigList;
+  sizes[GMC_TEAMS] = sizeof(bg_teamConfigList);
+  lists[GMC_MODS] = bg_modConfigList;
+  sizes[GMC_MODS] = sizeof(bg_modConfigList);
+  lists[GMC_CLASSES] = bg_classConfigList;
+  sizes[GMC_CLASSES] = sizeof(bg_classConfigList);
+  lists[GMC_BUILDABLES] = bg_buildableConfigList;
+  sizes[GMC_BUILDABLES] = sizeof(bg_buildableConfigList);
+  lists[GMC_WEAPONS] = bg_weaponConfigList;
+  sizes[GMC_WEAPONS] = sizeof(bg_weaponConfigList);
+  lists[GMC_UPGRADES] = bg_upgradeConfigList;
+  sizes[GMC_UPGRADES] = sizeof(bg_upgradeConfigList);
+}
+
+/*
+===============
+BG_GameModeHash
+
+FNV-1a
+===============
+*/
+static unsigned int BG_GameModeHash(
+  unsigned int hash, const void *data, int len) {
+  const byte *p = data;
+  int        i;
+
+  for(i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= 16777619u;
   }
+
+  return hash;
+}
+
+/*
+===============
+BG_GameModeBuildHash
+
+Hashes what the lists are as well as what they are parsed from: the build,
+the size of each config and where its fields are, and the missile defaults,
+so that changing any of those leaves old caches behind
+===============
+*/
+static unsigned int BG_GameModeBuildHash(unsigned int hash) {
+  const char *build = Q3_VERSION " " __DATE__ " " __TIME__;
+  int        layout[] = {
+    sizeof(teamConfig_t),
+    sizeof(modConfig_t),
+    GMC_OFFSET(modConfig_t, suicide_message),
+    GMC_OFFSET(modConfig_t, message2),
+    sizeof(classConfig_t),
+    GMC_OFFSET(classConfig_t, viewheight),
+    GMC_OFFSET(classConfig_t, shoulderOffsets),
+    GMC_OFFSET(classConfig_t, shadowScale),
+    GMC_OFFSET(classConfig_t, modelName),
+    GMC_OFFSET(classConfig_t, description),
+    sizeof(buildableConfig_t),
+    GMC_OFFSET(buildableConfig_t, zOffset),
+    GMC_OFFSET(buildableConfig_t, models),
+    GMC_OFFSET(buildableConfig_t, description),
+    sizeof(upgradeConfig_t),
+    sizeof(weaponConfig_t),
+    GMC_OFFSET(weaponConfig_t, mode),
+    sizeof(missileConfig_t),
+    GMC_OFFSET(missileConfig_t, damage),
+    GMC_OFFSET(missileConfig_t, mins),
+    GMC_OFFSET(missileConfig_t, speed),
+    GMC_OFFSET(missileConfig_t, bounce_type),
+    GMC_OFFSET(missileConfig_t, tripwire_range),
+    GMC_OFFSET(missileConfig_t, charged_time_max),
+    GMC_OFFSET(missileConfig_t, clip_mask),
+    GMC_OFFSET(missileConfig_t, scale_stop_maxs),
+    GMC_OFFSET(missileConfig_t, class_name)
+  };
+
+  hash = BG_GameModeHash(hash, build, strlen(build));
+  hash = BG_GameModeHash(hash, layout, sizeof(layout));
+  return BG_GameModeHash(
+    hash, &weapon_mode_default, sizeof(weapon_mode_default));
+}
+
+/*
+===============
+BG_GameModeFileHash
+
+Hashes the path, length and contents of a config file, a missing file
+hashes as a length of -1
+===============
+*/
+static unsigned int BG_GameModeFileHash(unsigned int hash, const char *path) {
+  static byte  buffer[4096];
+  fileHandle_t f;
+  int          len, chunk;
+
+  hash = BG_GameModeHash(hash, path, strlen(path));
+
+  len = FS_FOpenFileByMode(path, &f, FS_READ);
+  if(!f) {
+    len = -1;
+  }
+
+  hash = BG_GameModeHash(hash, &len, sizeof(len));
+
+  if(!f) {
+    return hash;
+  }
+
+  while(len > 0) {
+    chunk = MIN(len, (int)sizeof(buffer));
+    FS_Read2(buffer, chunk, f);
+    hash = BG_GameModeHash(hash, buffer, chunk);
+    len -= chunk;
+  }
+
+  FS_FCloseFile(f);
+  return hash;
+}
+
+/*
+===============
+BG_GameModeSourceHash
+
+Hashes every config file the lists of a game mode are parsed from, on top
+of the build
+===============
+*/
+static unsigned int BG_GameModeSourceHash(const char *game_mode) {
+  unsigned int hash = BG_GameModeBuildHash(2166136261u);
+  int          i;
+
+  for(i = TEAM_NONE; i < NUM_TEAMS; i++) {
+    hash = BG_GameModeFileHash(hash, BG_TeamConfigPath(game_mode, i));
+  }
+
+  for(i = 0; i < NUM_MODS; i++) {
+    hash = BG_GameModeFileHash(hash, BG_MODConfigPath(game_mode, i));
+  }
+
+  for(i = PCL_NONE; i < PCL_NUM_CLASSES; i++) {
+    hash = BG_GameModeFileHash(hash, BG_ClassConfigPath(game_mode, i));
+  }
+
+  for(i = BA_NONE + 1; i < BA_NUM_BUILDABLES; i++) {
+    hash = BG_GameModeFileHash(hash, BG_BuildableConfigPath(game_mode, i));
+  }
+
+  for(i = WP_NONE + 1; i < WP_NUM_WEAPONS; i++) {
+    hash = BG_GameModeFileHash(hash, BG_WeaponConfigPath(game_mode, i));
+  }
+
+  for(i = UP_NONE + 1; i < UP_NUM_UPGRADES; i++) {
+    hash = BG_GameModeFileHash(hash, BG_UpgradeConfigPath(game_mode, i));
+  }
+
+  return hash;
+}
+
+/*
+===============
+BG_LoadGameModeCache
+
+Reads the lists straight into place if the game mode has a cache that was
+built by this build from the config files as they are now
+===============
+*/
+static qboolean BG_LoadGameModeCache(const char *game_mode, unsigned int hash) {
+  gameModeCacheHeader_t header;
+  void                  *lists[GMC_NUM_LISTS];
+  int                   sizes[GMC_NUM_LISTS];
+  fileHandle_t          f;
+  int                   len, total, i;
+
+  len = FS_FOpenFileByMode(BG_GameModeCachePath(game_mode), &f, FS_READ);
+  if(!f) {
+    return qfalse;
+  }
+
+  BG_GameModeCacheLists(lists, sizes);
+
+  total = sizeof(header);
+  for(i = 0; i < GMC_NUM_LISTS; i++) {
+    total += sizes[i];
+  }
+
+  if(len != total) {
+    FS_FCloseFile(f);
+    return qfalse;
+  }
+
+  FS_Read2(&header, sizeof(header), f);
+
+  if(
+    header.ident != GAME_MODE_CACHE_IDENT ||
+    header.version != GAME_MODE_CACHE_VERSION || header.hash != hash) {
+    FS_FCloseFile(f);
+    return qfalse;
+  }
+
+  for(i = 0; i < GMC_NUM_LISTS; i++) {
+    if(header.sizes[i] != sizes[i]) {
+      FS_FCloseFile(f);
+      return qfalse;
+    }
+  }
+
+  for(i = 0; i < GMC_NUM_LISTS; i++) {
+    FS_Read2(lists[i], sizes[i], f);
+  }
+
+  FS_FCloseFile(f);
+  return qtrue;
+}
+
+/*
+===============
+BG_SaveGameModeCache
+===============
+*/
+static void BG_SaveGameModeCache(const char *game_mode, unsigned int hash) {
+  gameModeCacheHeader_t header;
+  void                  *lists[GMC_NUM_LISTS];
+  fileHandle_t          f;
+  int                   i;
+
+  FS_FOpenFileByMode(BG_GameModeCachePath(game_mode), &f, FS_WRITE);
+  if(!f) {
+    Com_Printf(
+      S_COLOR_YELLOW "WARNING: couldn't write %s\n",
+      BG_GameModeCachePath(game_mode));
+    return;
+  }
+
+  Com_Memset(&header, 0, sizeof(header));
+  header.ident = GAME_MODE_CACHE_IDENT;
+  header.version = GAME_MODE_CACHE_VERSION;
+  header.hash = hash;
+  BG_GameModeCacheLists(lists, header.sizes);
+
+  FS_Write(&header, sizeof(header), f);
+  for(i = 0; i < GMC_NUM_LISTS; i++) {
+    FS_Write(lists[i], header.sizes[i], f);
+  }
+
+  FS_FCloseFile(f);
 }
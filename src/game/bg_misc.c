@@ -1590,40 +1590,145 @@ size_t bg_numBuildables = ARRAY_LEN( bg_buildableList );
 
 static const buildableAttributes_t nullBuildable = { 0 };
 
+/*
+--------------------------------------------------------------------------------
+Attribute lookups by name
+
+The attribute tables never change, so BG_InitNameIndex() sorts the names of
+each of them once, and BG_*ByName() do a binary search of the sorted names
+instead of comparing against every entry of the table.
+*/
+
+// offset of an attribute table's name field
+#define NOFS(type,field) ((size_t)&(((type *)0)->field))
+
+typedef struct bgNameIndex_s
+{
+  const char *name;
+  int        index; // into the attribute table
+} bgNameIndex_t;
+
+static struct
+{
+  qboolean      built;
+
+  bgNameIndex_t buildables[ BA_NUM_BUILDABLES ];
+  int           numBuildables;
+  bgNameIndex_t buildableEntities[ BA_NUM_BUILDABLES ];
+  int           numBuildableEntities;
+  bgNameIndex_t classes[ PCL_NUM_CLASSES ];
+  int           numClasses;
+  bgNameIndex_t weapons[ WP_NUM_WEAPONS ];
+  int           numWeapons;
+  bgNameIndex_t upgrades[ UP_NUM_UPGRADES ];
+  int           numUpgrades;
+} bg_names;
+
 /*
 ==============
-BG_BuildableByName
+BG_CompareNameIndex
+
+Entries with the same name keep their table order, so that the first one in
+the table is the one that is found, as it was before the names were sorted
 ==============
 */
-const buildableAttributes_t *BG_BuildableByName( const char *name )
+static int QDECL BG_CompareNameIndex( const void *a, const void *b )
 {
-  int i;
+  const bgNameIndex_t *na = a;
+  const bgNameIndex_t *nb = b;
+  int                 cmp = Q_stricmp( na->name, nb->name );
+
+  return cmp ? cmp : na->index - nb->index;
+}
+
+/*
+==============
+BG_SortNameIndex
+==============
+*/
+static int BG_SortNameIndex( bgNameIndex_t *names, int size,
+                             const void *table, size_t stride,
+                             size_t nameOffset, int tableLength )
+{
+  int i, num = 0;
 
-  for( i = 0; i < bg_numBuildables; i++ )
+  for( i = 0; i < tableLength; i++ )
   {
-    if( !Q_stricmp( bg_buildableList[ i ].name, name ) )
-      return &bg_buildableList[ i ];
+    const char *name =
+      *(const char **)( (const byte *)table + i * stride + nameOffset );
+
+    if( !name )
+      continue;
+
+    Com_Assert( num < size );
+    names[ num ].name = name;
+    names[ num ].index = i;
+    num++;
   }
 
-  return &nullBuildable;
+  qsort( names, num, sizeof( bgNameIndex_t ), BG_CompareNameIndex );
+
+  return num;
 }
 
 /*
 ==============
-BG_BuildableByEntityName
+BG_FindNameIndex
+
+Returns the table index of the first entry named name, or -1
 ==============
 */
-const buildableAttributes_t *BG_BuildableByEntityName( const char *name )
+static int BG_FindNameIndex( const bgNameIndex_t *names, int num,
+                             const char *name )
 {
-  int i;
+  int low = 0, high = num;
+
+  if( !bg_names.built )
+    BG_InitNameIndex( );
 
-  for( i = 0; i < bg_numBuildables; i++ )
+  while( low < high )
   {
-    if( !Q_stricmp( bg_buildableList[ i ].entityName, name ) )
-      return &bg_buildableList[ i ];
+    int mid = ( low + high ) / 2;
+
+    if( Q_stricmp( names[ mid ].name, name ) < 0 )
+      low = mid + 1;
+    else
+      high = mid;
   }
 
-  return &nullBuildable;
+  if( low < num && !Q_stricmp( names[ low ].name, name ) )
+    return names[ low ].index;
+
+  return -1;
+}
+
+/*
+--------------------------------------------------------------------------------
+*/
+
+/*
+==============
+BG_BuildableByName
+==============
+*/
+const buildableAttributes_t *BG_BuildableByName( const char *name )
+{
+  int i = BG_FindNameIndex( bg_names.buildables, bg_names.numBuildables, name );
+
+  return i >= 0 ? &bg_buildableList[ i ] : &nullBuildable;
+}
+
+/*
+==============
+BG_BuildableByEntityName
+==============
+*/
+const buildableAttributes_t *BG_BuildableByEntityName( const char *name )
+{
+  int i = BG_FindNameIndex( bg_names.buildableEntities,
+                            bg_names.numBuildableEntities, name );
+
+  return i >= 0 ? &bg_buildableList[ i ] : &nullBuildable;
 }
 
 /*
@@ -2172,15 +2277,9 @@ BG_ClassByName
 */
 const classAttributes_t *BG_ClassByName( const char *name )
 {
-  int i;
+  int i = BG_FindNameIndex( bg_names.classes, bg_names.numClasses, name );
 
-  for( i = 0; i < bg_numClasses; i++ )
-  {
-    if( !Q_stricmp( bg_classList[ i ].name, name ) )
-      return &bg_classList[ i ];
-  }
-
-  return &nullClass;
+  return i >= 0 ? &bg_classList[ i ] : &nullClass;
 }
 
 /*
@@ -5291,17 +5390,9 @@ BG_WeaponByName
 */
 const weaponAttributes_t *BG_WeaponByName( const char *name )
 {
-  int i;
+  int i = BG_FindNameIndex( bg_names.weapons, bg_names.numWeapons, name );
 
-  for( i = 0; i < bg_numWeapons; i++ )
-  {
-    if( !Q_stricmp( bg_weapons[ i ].name, name ) )
-    {
-      return &bg_weapons[ i ];
-    }
-  }
-
-  return &nullWeapon;
+  return i >= 0 ? &bg_weapons[ i ] : &nullWeapon;
 }
 
 /*
@@ -5663,17 +5754,9 @@ BG_UpgradeByName
 */
 const upgradeAttributes_t *BG_UpgradeByName( const char *name )
 {
-  int i;
-
-  for( i = 0; i < bg_numUpgrades; i++ )
-  {
-    if( !Q_stricmp( bg_upgrades[ i ].name, name ) )
-    {
-      return &bg_upgrades[ i ];
-    }
-  }
+  int i = BG_FindNameIndex( bg_names.upgrades, bg_names.numUpgrades, name );
 
-  return &nullUpgrade;
+  return i >= 0 ? &bg_upgrades[ i ] : &nullUpgrade;
 }
 
 /*
@@ -6962,6 +7045,39 @@ typedef struct gameElements_s
 
 static gameElements_t bg_disabledGameElements;
 
+/*
+============
+BG_InitNameIndex
+
+Sorts the names of the attribute tables for BG_*ByName().  The lookups do
+this themselves if they are used first.
+============
+*/
+void BG_InitNameIndex( void )
+{
+  bg_names.numBuildables = BG_SortNameIndex(
+    bg_names.buildables, ARRAY_LEN( bg_names.buildables ),
+    bg_buildableList, sizeof( bg_buildableList[ 0 ] ),
+    NOFS( buildableAttributes_t, name ), bg_numBuildables );
+  bg_names.numBuildableEntities = BG_SortNameIndex(
+    bg_names.buildableEntities, ARRAY_LEN( bg_names.buildableEntities ),
+    bg_buildableList, sizeof( bg_buildableList[ 0 ] ),
+    NOFS( buildableAttributes_t, entityName ), bg_numBuildables );
+  bg_names.numClasses = BG_SortNameIndex(
+    bg_names.classes, ARRAY_LEN( bg_names.classes ),
+    bg_classList, sizeof( bg_classList[ 0 ] ),
+    NOFS( classAttributes_t, name ), bg_numClasses );
+  bg_names.numWeapons = BG_SortNameIndex(
+    bg_names.weapons, ARRAY_LEN( bg_names.weapons ),
+    bg_weapons, sizeof( bg_weapons[ 0 ] ),
+    NOFS( weaponAttributes_t, name ), bg_numWeapons );
+  bg_names.numUpgrades = BG_SortNameIndex(
+    bg_names.upgrades, ARRAY_LEN( bg_names.upgrades ),
+    bg_upgrades, sizeof( bg_upgrades[ 0 ] ),
+    NOFS( upgradeAttributes_t, name ), bg_numUpgrades );
+  bg_names.built = qtrue;
+}
+
 /*
 ============
 BG_InitAllowedGameElements
@@ -6971,6 +7087,8 @@ void BG_InitAllowedGameElements( void )
 {
   char cvar[ MAX_CVAR_VALUE_STRING ];
 
+  BG_InitNameIndex( );
+
   Cvar_VariableStringBuffer( "g_disabledEquipment",
       cvar, MAX_CVAR_VALUE_STRING );
 
@@ -30,6 +30,9 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 // linked lists
 #include "bg_list.h"
 
+// contiguous vectors and ring buffer deques
+#include "bg_vector.h"
+
 // BGAME Dynamic Memory Allocation
 #include "bg_alloc.h"
 
@@ -1874,6 +1877,7 @@ void BG_ParseCSVEquipmentList( const char *string, weapon_t *weapons, int weapon
     upgrade_t *upgrades, int upgradesSize );
 void BG_ParseCSVClassList( const char *string, class_t *classes, int classesSize );
 void BG_ParseCSVBuildableList( const char *string, buildable_t *buildables, int buildablesSize );
+void BG_InitNameIndex( void );
 void BG_InitAllowedGameElements( void );
 qboolean BG_WeaponIsAllowed( weapon_t weapon, qboolean devMode );
 qboolean BG_UpgradeIsAllowed( upgrade_t upgrade, qboolean devMode );
@@ -1989,6 +1993,7 @@ void          BG_UEID_set(bgentity_id *ueid, int ent_num);
 int           BG_UEID_get_ent_num(bgentity_id *ueid);
 
 void          BG_Init_Collision_Functions(bg_collision_funcs_t funcs);
+bg_collision_funcs_t BG_Collision_Functions(void);
 void          BG_Trace(
   trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs,
   const vec3_t end, int passEntityNum, qboolean clip_against_missiles,
@@ -2010,6 +2015,56 @@ void          BG_UnlaggedOn(unlagged_attacker_data_t *data);
 void          BG_UnlaggedOff(void);
 void          BG_Update_Collision_Data_For_Entity(int ent_num, int time);
 
+//bg_replay.c
+#define PMOVE_REPLAY_IDENT      (('R'<<24)+('M'<<16)+('P'<<8)+'P')
+#define PMOVE_REPLAY_VERSION    1
+#define MAX_PMOVE_REPLAY_CMDS   16384
+
+typedef struct
+{
+  int            ident;
+  int            version;
+  int            numCmds;
+  char           mapname[ MAX_QPATH ];   // recorded on
+
+  // the rest of the pmove_t the commands were run with
+  content_mask_t trace_mask;
+  int            pmove_fixed;
+  int            pmove_msec;
+  int            humanStaminaMode;
+  int            playerAccelMode;
+  int            swapAttacks;
+  float          wallJumperMinFactor;
+  float          marauderMinJumpFactor;
+  qboolean       reactor;
+
+  // before the first command
+  playerState_t  ps;
+  pmoveExt_t     pmext;
+} pmoveReplayHeader_t;
+
+typedef struct
+{
+  pmoveReplayHeader_t header;
+  usercmd_t           cmds[ MAX_PMOVE_REPLAY_CMDS ];
+} pmoveReplay_t;
+
+typedef struct
+{
+  int          pmoves;
+  int          traces;
+  int          pointContents;
+  int          msec;
+  unsigned int hash;        // of every playerState in the last run
+  vec3_t       origin;      // where it ended
+} pmoveReplayResult_t;
+
+qboolean      BG_PmoveReplayLoad( const char *name, pmoveReplay_t *replay );
+qboolean      BG_PmoveReplaySave( const char *name, pmoveReplay_t *replay );
+void          BG_PmoveReplay(
+  const pmoveReplay_t *replay, const bg_collision_funcs_t *world, int runs,
+  int ( *milliseconds )( void ), pmoveReplayResult_t *result );
+
 
 //for movers
 void BG_CreateRotationMatrix( vec3_t angles, vec3_t matrix[ 3 ] );
@@ -2131,16 +2186,11 @@ typedef struct
   char      message2[MAX_TOKEN_CHARS];
 } modConfig_t;
 
+// the fields of the configs that are read while moving and tracing come first,
+// so that they share cache lines instead of being spread out past the strings
+
 typedef struct
 {
-  char      modelName[MAX_QPATH];
-  char      description[MAX_TOKEN_CHARS];
-  float     modelScale;
-  char      skinName[MAX_QPATH];
-  float     shadowScale;
-  char      hudName[MAX_QPATH];
-  char      humanName[MAX_STRING_CHARS];
-
   vec3_t    mins;
   vec3_t    maxs;
   vec3_t    crouchMaxs;
@@ -2151,18 +2201,25 @@ typedef struct
   float     zOffset;
   vec3_t    shoulderOffsets;
   qboolean  silenceFootsteps;
+  float     modelScale;
+  float     shadowScale;
+
+  char      modelName[MAX_QPATH];
+  char      skinName[MAX_QPATH];
+  char      hudName[MAX_QPATH];
+  char      humanName[MAX_STRING_CHARS];
+  char      description[MAX_TOKEN_CHARS];
 } classConfig_t;
 
 typedef struct
 {
-  char      description[MAX_TOKEN_CHARS];
-
-  char      models[MAX_BUILDABLE_MODELS][MAX_QPATH];
-
-  float     modelScale;
   vec3_t    mins;
   vec3_t    maxs;
   float     zOffset;
+  float     modelScale;
+
+  char      models[MAX_BUILDABLE_MODELS][MAX_QPATH];
+  char      description[MAX_TOKEN_CHARS];
 } buildableConfig_t;
 
 typedef struct
@@ -2173,7 +2230,6 @@ typedef struct
 typedef struct missileConfig_s
 {
   qboolean       enabled;
-  char           class_name[MAX_STRING_CHARS];
   meansOfDeath_t mod;
   meansOfDeath_t splash_mod;
   qboolean       selective_damage;
@@ -2223,6 +2279,7 @@ typedef struct missileConfig_s
   int            scale_stop_time;
   vec3_t         scale_stop_mins;
   vec3_t         scale_stop_maxs;
+  char           class_name[MAX_STRING_CHARS];
 } missileConfig_t;
 
 typedef struct weaponModeConfig_s
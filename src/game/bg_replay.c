@@ -0,0 +1,273 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+
+// bg_replay.c -- recorded usercmd streams replayed through Pmove, for the
+// pmovebench commands of both games
+
+#include "../qcommon/q_shared.h"
+#include "bg_public.h"
+
+#ifdef Q3_VM
+  #define FS_FOpenFileByMode trap_FS_FOpenFile
+  #define FS_Read2 trap_FS_Read
+  #define FS_Write trap_FS_Write
+  #define FS_FCloseFile trap_FS_FCloseFile
+#else
+  int  FS_FOpenFileByMode( const char *qpath, fileHandle_t *f, fsMode_t mode );
+  int  FS_Read2( void *buffer, int len, fileHandle_t f );
+  int  FS_Write( const void *buffer, int len, fileHandle_t f );
+  void FS_FCloseFile( fileHandle_t f );
+#endif
+
+static bg_collision_funcs_t replayWorld;
+static int                  replayTraces;
+static int                  replayPointContents;
+static qboolean             replayReactor;
+
+/*
+============
+BG_PmoveReplayPath
+============
+*/
+static const char *BG_PmoveReplayPath( const char *name )
+{
+  return va( "pmove/%s.pmr", name );
+}
+
+/*
+============
+BG_PmoveReplayLoad
+
+Streams are this build's structures written as they are, so only builds
+that share the layout can read each others'
+============
+*/
+qboolean BG_PmoveReplayLoad( const char *name, pmoveReplay_t *replay )
+{
+  fileHandle_t f;
+  int          len, cmdsLen;
+
+  len = FS_FOpenFileByMode( BG_PmoveReplayPath( name ), &f, FS_READ );
+  if( !f )
+    return qfalse;
+
+  if( len < (int)sizeof( replay->header ) )
+  {
+    Com_Printf( S_COLOR_YELLOW "WARNING: %s is too short\n", BG_PmoveReplayPath( name ) );
+    FS_FCloseFile( f );
+    return qfalse;
+  }
+
+  FS_Read2( &replay->header, sizeof( replay->header ), f );
+  cmdsLen = replay->header.numCmds * sizeof( usercmd_t );
+
+  if( replay->header.ident != PMOVE_REPLAY_IDENT ||
+      replay->header.version != PMOVE_REPLAY_VERSION ||
+      replay->header.numCmds < 0 || replay->header.numCmds > MAX_PMOVE_REPLAY_CMDS ||
+      len != (int)sizeof( replay->header ) + cmdsLen )
+  {
+    Com_Printf( S_COLOR_YELLOW "WARNING: %s is not a pmove stream of this build\n",
+      BG_PmoveReplayPath( name ) );
+    FS_FCloseFile( f );
+    return qfalse;
+  }
+
+  FS_Read2( replay->cmds, cmdsLen, f );
+  FS_FCloseFile( f );
+  return qtrue;
+}
+
+/*
+============
+BG_PmoveReplaySave
+============
+*/
+qboolean BG_PmoveReplaySave( const char *name, pmoveReplay_t *replay )
+{
+  fileHandle_t f;
+
+  FS_FOpenFileByMode( BG_PmoveReplayPath( name ), &f, FS_WRITE );
+  if( !f )
+  {
+    Com_Printf( S_COLOR_YELLOW "WARNING: couldn't write %s\n", BG_PmoveReplayPath( name ) );
+    return qfalse;
+  }
+
+  replay->header.ident = PMOVE_REPLAY_IDENT;
+  replay->header.version = PMOVE_REPLAY_VERSION;
+
+  FS_Write( &replay->header, sizeof( replay->header ), f );
+  FS_Write( replay->cmds, replay->header.numCmds * sizeof( usercmd_t ), f );
+  FS_FCloseFile( f );
+  return qtrue;
+}
+
+/*
+============
+BG_PmoveReplayTrace
+============
+*/
+static void BG_PmoveReplayTrace(
+  trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs,
+  const vec3_t end, int passEntityNum, qboolean clip_against_missiles,
+  const content_mask_t content_mask, traceType_t type )
+{
+  replayTraces++;
+  replayWorld.trace(
+    results, start, mins, maxs, end, passEntityNum, clip_against_missiles,
+    content_mask, type );
+}
+
+/*
+============
+BG_PmoveReplayPointContents
+============
+*/
+static int BG_PmoveReplayPointContents( const vec3_t point, int passEntityNum )
+{
+  replayPointContents++;
+  return replayWorld.pointcontents( point, passEntityNum );
+}
+
+/*
+============
+BG_PmoveReplayReactor
+============
+*/
+static qboolean BG_PmoveReplayReactor( void )
+{
+  return replayReactor;
+}
+
+/*
+============
+BG_PmoveReplayHash
+
+FNV-1a
+============
+*/
+static unsigned int BG_PmoveReplayHash( unsigned int hash, const void *data, int len )
+{
+  const byte *p = data;
+  int        i;
+
+  for( i = 0; i < len; i++ )
+  {
+    hash ^= p[ i ];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/*
+============
+BG_PmoveReplayRun
+
+One run of the stream from its first state, hashing every playerState it
+goes through if hash is given
+============
+*/
+static void BG_PmoveReplayRun( const pmoveReplay_t *replay, playerState_t *ps,
+  unsigned int *hash )
+{
+  const pmoveReplayHeader_t *header = &replay->header;
+  static pmove_t            pm;
+  pmoveExt_t                pmext;
+  int                       i;
+
+  *ps = header->ps;
+  pmext = header->pmext;
+
+  Com_Memset( &pm, 0, sizeof( pm ) );
+  pm.ps = ps;
+  pm.pmext = &pmext;
+  pm.pmove_fixed = header->pmove_fixed;
+  pm.pmove_msec = header->pmove_msec;
+  pm.humanStaminaMode = header->humanStaminaMode;
+  pm.playerAccelMode = header->playerAccelMode;
+  pm.swapAttacks = header->swapAttacks;
+  pm.wallJumperMinFactor = header->wallJumperMinFactor;
+  pm.marauderMinJumpFactor = header->marauderMinJumpFactor;
+  pm.pm_reactor = BG_PmoveReplayReactor;
+
+  for( i = 0; i < header->numCmds; i++ )
+  {
+    // like ClientThink_real
+    pmext.fallVelocity = 0.0f;
+    pm.cmd = replay->cmds[ i ];
+    pm.trace_mask = header->trace_mask;
+
+    Pmove( &pm );
+
+    if( hash )
+      *hash = BG_PmoveReplayHash( *hash, ps, sizeof( *ps ) );
+  }
+}
+
+/*
+============
+BG_PmoveReplay
+
+Runs the stream through Pmove the given number of times, colliding with
+whatever world collides with, usually just the BSP so that every module
+replays against the same thing.  Another run that isn't timed hashes
+every playerState the stream goes through, so two modules or two builds
+that move a player the same way give the same hash.
+============
+*/
+void BG_PmoveReplay(
+  const pmoveReplay_t *replay, const bg_collision_funcs_t *world, int runs,
+  int ( *milliseconds )( void ), pmoveReplayResult_t *result )
+{
+  bg_collision_funcs_t saved, counting;
+  playerState_t        ps;
+  int                  run, start;
+
+  Com_Memset( result, 0, sizeof( *result ) );
+
+  saved = BG_Collision_Functions( );
+  replayWorld = *world;
+  counting = *world;
+  counting.trace = BG_PmoveReplayTrace;
+  counting.pointcontents = BG_PmoveReplayPointContents;
+  BG_Init_Collision_Functions( counting );
+  replayTraces = replayPointContents = 0;
+  replayReactor = replay->header.reactor;
+
+  start = milliseconds( );
+  for( run = 0; run < runs; run++ )
+    BG_PmoveReplayRun( replay, &ps, NULL );
+  result->msec = milliseconds( ) - start;
+
+  result->pmoves = runs * replay->header.numCmds;
+  result->traces = replayTraces;
+  result->pointContents = replayPointContents;
+
+  result->hash = 2166136261u;
+  BG_PmoveReplayRun( replay, &ps, &result->hash );
+  VectorCopy( ps.origin, result->origin );
+
+  BG_Init_Collision_Functions( saved );
+}
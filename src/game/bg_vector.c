@@ -0,0 +1,758 @@
+/*
+===========================================================================
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+
+// bg_vector.c -- contiguous vectors and ring buffer deques of elements stored
+// by value, for the per-frame containers that don't need bglist_t's links
+
+#include "../qcommon/q_shared.h"
+#include "bg_public.h"
+
+#define VECTOR_MIN_CAPACITY 4
+
+/*
+--------------------------------------------------------------------------------
+Helper functions
+*/
+
+/*
+============
+BG_Vector_Elements_Equal
+
+Compares two elements byte by byte, as memcmp() isn't available to the QVMs.
+Pointers, which is what most of the containers hold, are compared whole.
+============
+*/
+static ID_INLINE qboolean BG_Vector_Elements_Equal(
+  const void *a, const void *b, size_t elementSize) {
+  const byte *pa = (const byte *)a;
+  const byte *pb = (const byte *)b;
+  size_t     i;
+
+  if(elementSize == sizeof(void *)) {
+    return *(void *const *)a == *(void *const *)b;
+  }
+
+  for(i = 0; i < elementSize; i++) {
+    if(pa[i] != pb[i]) {
+      return qfalse;
+    }
+  }
+
+  return qtrue;
+}
+
+/*
+============
+BG_Vector_Find
+
+Gets the position of the first of count elements starting at data that is
+equal to element, or -1
+============
+*/
+static int BG_Vector_Find(
+  const byte *data, int count, const void *element, size_t elementSize) {
+  int i;
+
+  if(elementSize == sizeof(void *)) {
+    void *const *ptrs = (void *const *)data;
+    const void  *ptr = *(void *const *)element;
+
+    for(i = 0; i < count; i++) {
+      if(ptrs[i] == ptr) {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  for(i = 0; i < count; i++, data += elementSize) {
+    if(BG_Vector_Elements_Equal(data, element, elementSize)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/*
+============
+BG_Vector_Grown_Capacity
+============
+*/
+static int BG_Vector_Grown_Capacity(int capacity, int needed) {
+  if(capacity < VECTOR_MIN_CAPACITY) {
+    capacity = VECTOR_MIN_CAPACITY;
+  }
+
+  while(capacity < needed) {
+    capacity <<= 1;
+  }
+
+  return capacity;
+}
+
+/*
+--------------------------------------------------------------------------------
+*/
+
+/*
+--------------------------------------------------------------------------------
+Vectors
+*/
+
+/**
+ * BG_Vector_Init:
+ * @vector: a #bgvector_t
+ * @elementSize: the size of each element in bytes
+ *
+ * Initializes an empty @vector.  Nothing is allocated until the first
+ * element is added.
+ */
+void BG_Vector_Init(bgvector_t *vector, size_t elementSize) {
+  Com_Assert(vector != NULL);
+  Com_Assert(elementSize > 0);
+
+  vector->data = NULL;
+  vector->length = 0;
+  vector->capacity = 0;
+  vector->elementSize = elementSize;
+}
+
+/**
+ * BG_Vector_Clear:
+ * @vector: a #bgvector_t
+ *
+ * Removes all of the elements from @vector and frees its storage.  @vector
+ * can be used again afterwards.
+ */
+void BG_Vector_Clear(bgvector_t *vector) {
+  Com_Assert(vector != NULL);
+
+  if(vector->data) {
+    BG_Free(vector->data);
+  }
+
+  vector->data = NULL;
+  vector->length = 0;
+  vector->capacity = 0;
+}
+
+/**
+ * BG_Vector_Reserve:
+ * @vector: a #bgvector_t
+ * @capacity: the number of elements to make room for
+ *
+ * Makes sure that @vector can hold at least @capacity elements without
+ * reallocating.
+ */
+void BG_Vector_Reserve(bgvector_t *vector, int capacity) {
+  void *data;
+
+  Com_Assert(vector != NULL);
+
+  if(capacity <= vector->capacity) {
+    return;
+  }
+
+  capacity = BG_Vector_Grown_Capacity(vector->capacity, capacity);
+  data = BG_Alloc(capacity * vector->elementSize);
+
+  if(vector->data) {
+    memcpy(data, vector->data, vector->length * vector->elementSize);
+    BG_Free(vector->data);
+  }
+
+  vector->data = data;
+  vector->capacity = capacity;
+}
+
+/**
+ * BG_Vector_Push_Tail:
+ * @vector: a #bgvector_t
+ * @element: (nullable): a pointer to the element to copy in, or %NULL to
+ *   leave the new element uninitialized
+ *
+ * Adds an element to the end of @vector.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Vector_Push_Tail(bgvector_t *vector, const void *element) {
+  byte *slot;
+
+  Com_Assert(vector != NULL);
+
+  BG_Vector_Reserve(vector, vector->length + 1);
+
+  slot = (byte *)vector->data + vector->length * vector->elementSize;
+  if(element) {
+    memcpy(slot, element, vector->elementSize);
+  }
+  vector->length++;
+
+  return slot;
+}
+
+/**
+ * BG_Vector_Pop_Tail:
+ * @vector: a #bgvector_t
+ * @element: (nullable): where to copy the removed element to
+ *
+ * Removes the last element of @vector.
+ *
+ * Returns: %qfalse if @vector was empty
+ */
+qboolean BG_Vector_Pop_Tail(bgvector_t *vector, void *element) {
+  Com_Assert(vector != NULL);
+
+  if(vector->length <= 0) {
+    return qfalse;
+  }
+
+  vector->length--;
+  if(element) {
+    memcpy(
+      element, (byte *)vector->data + vector->length * vector->elementSize,
+      vector->elementSize);
+  }
+
+  return qtrue;
+}
+
+/**
+ * BG_Vector_Insert:
+ * @vector: a #bgvector_t
+ * @index: the position to insert the element at, from 0 to the length of
+ *   @vector
+ * @element: (nullable): a pointer to the element to copy in
+ *
+ * Inserts an element before the @index'th element of @vector, keeping the
+ * order of the elements after it.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Vector_Insert(bgvector_t *vector, int index, const void *element) {
+  byte *slot;
+
+  Com_Assert(vector != NULL);
+  Com_Assert(index >= 0 && index <= vector->length);
+
+  BG_Vector_Reserve(vector, vector->length + 1);
+
+  slot = (byte *)vector->data + index * vector->elementSize;
+  memmove(
+    slot + vector->elementSize, slot,
+    (vector->length - index) * vector->elementSize);
+  if(element) {
+    memcpy(slot, element, vector->elementSize);
+  }
+  vector->length++;
+
+  return slot;
+}
+
+/**
+ * BG_Vector_Remove_Index:
+ * @vector: a #bgvector_t
+ * @index: the position of the element to remove
+ *
+ * Removes the @index'th element of @vector, keeping the order of the
+ * elements after it.
+ */
+void BG_Vector_Remove_Index(bgvector_t *vector, int index) {
+  byte *slot;
+
+  Com_Assert(vector != NULL);
+  Com_Assert(index >= 0 && index < vector->length);
+
+  slot = (byte *)vector->data + index * vector->elementSize;
+  memmove(
+    slot, slot + vector->elementSize,
+    (vector->length - index - 1) * vector->elementSize);
+  vector->length--;
+}
+
+/**
+ * BG_Vector_Remove_All:
+ * @vector: a #bgvector_t
+ * @element: a pointer to the value to remove
+ *
+ * Removes every element of @vector that is bytewise equal to @element,
+ * keeping the order of the rest.
+ *
+ * Returns: the number of elements removed
+ */
+int BG_Vector_Remove_All(bgvector_t *vector, const void *element) {
+  const size_t size = vector->elementSize;
+  byte         *src, *dst, *end;
+  int          old_length, i;
+
+  Com_Assert(vector != NULL);
+
+  old_length = vector->length;
+
+  // everything before the first match stays where it is
+  i = BG_Vector_Index(vector, element);
+  if(i < 0) {
+    return 0;
+  }
+
+  dst = (byte *)vector->data + i * size;
+  end = (byte *)vector->data + vector->length * size;
+  for(src = dst + size; src < end; src += size) {
+    if(BG_Vector_Elements_Equal(src, element, size)) {
+      continue;
+    }
+
+    if(dst != src) {
+      memcpy(dst, src, size);
+    }
+    dst += size;
+  }
+
+  vector->length = (dst - (byte *)vector->data) / size;
+
+  return old_length - vector->length;
+}
+
+/**
+ * BG_Vector_Index:
+ * @vector: a #bgvector_t
+ * @element: a pointer to the value to find
+ *
+ * Gets the position of the first element of @vector that is bytewise equal
+ * to @element.
+ *
+ * Returns: the index of the element, or -1 if it isn't in @vector
+ */
+int BG_Vector_Index(const bgvector_t *vector, const void *element) {
+  Com_Assert(vector != NULL);
+
+  return
+    BG_Vector_Find(
+      (const byte *)vector->data, vector->length, element,
+      vector->elementSize);
+}
+
+/*
+--------------------------------------------------------------------------------
+*/
+
+/*
+--------------------------------------------------------------------------------
+Deques
+*/
+
+/*
+============
+BG_Deque_Slot
+============
+*/
+static ID_INLINE byte *BG_Deque_Slot(const bgdeque_t *deque, int n) {
+  return
+    (byte *)deque->data +
+    ((deque->head + n) & (deque->capacity - 1)) * deque->elementSize;
+}
+
+/*
+============
+BG_Deque_Grow
+
+Makes room for one more element, unwrapping the ring so that the head is at
+the start of the new storage
+============
+*/
+static void BG_Deque_Grow(bgdeque_t *deque) {
+  byte *data;
+  int  capacity, first;
+
+  if(deque->length < deque->capacity) {
+    return;
+  }
+
+  capacity = BG_Vector_Grown_Capacity(deque->capacity, deque->length + 1);
+  data = BG_Alloc(capacity * deque->elementSize);
+
+  if(deque->data) {
+    first = deque->capacity - deque->head;
+    if(first > deque->length) {
+      first = deque->length;
+    }
+
+    memcpy(data, BG_Deque_Slot(deque, 0), first * deque->elementSize);
+    memcpy(
+      data + first * deque->elementSize, deque->data,
+      (deque->length - first) * deque->elementSize);
+    BG_Free(deque->data);
+  }
+
+  deque->data = data;
+  deque->head = 0;
+  deque->capacity = capacity;
+}
+
+/**
+ * BG_Deque_Init:
+ * @deque: a #bgdeque_t
+ * @elementSize: the size of each element in bytes
+ *
+ * Initializes an empty @deque.  Nothing is allocated until the first
+ * element is added.
+ */
+void BG_Deque_Init(bgdeque_t *deque, size_t elementSize) {
+  Com_Assert(deque != NULL);
+  Com_Assert(elementSize > 0);
+
+  deque->data = NULL;
+  deque->head = 0;
+  deque->length = 0;
+  deque->capacity = 0;
+  deque->elementSize = elementSize;
+}
+
+/**
+ * BG_Deque_Clear:
+ * @deque: a #bgdeque_t
+ *
+ * Removes all of the elements from @deque and frees its storage.  @deque
+ * can be used again afterwards.
+ */
+void BG_Deque_Clear(bgdeque_t *deque) {
+  Com_Assert(deque != NULL);
+
+  if(deque->data) {
+    BG_Free(deque->data);
+  }
+
+  deque->data = NULL;
+  deque->head = 0;
+  deque->length = 0;
+  deque->capacity = 0;
+}
+
+/**
+ * BG_Deque_Push_Head:
+ * @deque: a #bgdeque_t
+ * @element: (nullable): a pointer to the element to copy in
+ *
+ * Adds an element to the head of @deque.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Deque_Push_Head(bgdeque_t *deque, const void *element) {
+  Com_Assert(deque != NULL);
+
+  BG_Deque_Grow(deque);
+
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  deque->length++;
+  if(element) {
+    memcpy(BG_Deque_Slot(deque, 0), element, deque->elementSize);
+  }
+
+  return BG_Deque_Slot(deque, 0);
+}
+
+/**
+ * BG_Deque_Push_Tail:
+ * @deque: a #bgdeque_t
+ * @element: (nullable): a pointer to the element to copy in
+ *
+ * Adds an element to the tail of @deque.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Deque_Push_Tail(bgdeque_t *deque, const void *element) {
+  byte *slot;
+
+  Com_Assert(deque != NULL);
+
+  BG_Deque_Grow(deque);
+
+  slot = BG_Deque_Slot(deque, deque->length);
+  deque->length++;
+  if(element) {
+    memcpy(slot, element, deque->elementSize);
+  }
+
+  return slot;
+}
+
+/**
+ * BG_Deque_Pop_Head:
+ * @deque: a #bgdeque_t
+ * @element: (nullable): where to copy the removed element to
+ *
+ * Removes the element at the head of @deque.
+ *
+ * Returns: %qfalse if @deque was empty
+ */
+qboolean BG_Deque_Pop_Head(bgdeque_t *deque, void *element) {
+  Com_Assert(deque != NULL);
+
+  if(deque->length <= 0) {
+    return qfalse;
+  }
+
+  if(element) {
+    memcpy(element, BG_Deque_Slot(deque, 0), deque->elementSize);
+  }
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->length--;
+
+  return qtrue;
+}
+
+/**
+ * BG_Deque_Pop_Tail:
+ * @deque: a #bgdeque_t
+ * @element: (nullable): where to copy the removed element to
+ *
+ * Removes the element at the tail of @deque.
+ *
+ * Returns: %qfalse if @deque was empty
+ */
+qboolean BG_Deque_Pop_Tail(bgdeque_t *deque, void *element) {
+  Com_Assert(deque != NULL);
+
+  if(deque->length <= 0) {
+    return qfalse;
+  }
+
+  deque->length--;
+  if(element) {
+    memcpy(element, BG_Deque_Slot(deque, deque->length), deque->elementSize);
+  }
+
+  return qtrue;
+}
+
+/**
+ * BG_Deque_Peek_Head:
+ * @deque: a #bgdeque_t
+ *
+ * Returns: a pointer to the element at the head of @deque, or %NULL if
+ *   @deque is empty
+ */
+void *BG_Deque_Peek_Head(const bgdeque_t *deque) {
+  Com_Assert(deque != NULL);
+
+  return deque->length > 0 ? BG_Deque_Slot(deque, 0) : NULL;
+}
+
+/**
+ * BG_Deque_Peek_Tail:
+ * @deque: a #bgdeque_t
+ *
+ * Returns: a pointer to the element at the tail of @deque, or %NULL if
+ *   @deque is empty
+ */
+void *BG_Deque_Peek_Tail(const bgdeque_t *deque) {
+  Com_Assert(deque != NULL);
+
+  return deque->length > 0 ? BG_Deque_Slot(deque, deque->length - 1) : NULL;
+}
+
+/**
+ * BG_Deque_Insert:
+ * @deque: a #bgdeque_t
+ * @index: the position to insert the element at, from 0 to the length of
+ *   @deque
+ * @element: (nullable): a pointer to the element to copy in
+ *
+ * Inserts an element before the @index'th element of @deque, keeping the
+ * order of the rest.  Whichever side of @index has fewer elements is the
+ * one that is shifted.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Deque_Insert(bgdeque_t *deque, int index, const void *element) {
+  const size_t size = deque->elementSize;
+  int          i;
+
+  Com_Assert(deque != NULL);
+  Com_Assert(index >= 0 && index <= deque->length);
+
+  BG_Deque_Grow(deque);
+
+  if(index < deque->length / 2) {
+    deque->head = (deque->head - 1) & (deque->capacity - 1);
+    deque->length++;
+    for(i = 0; i < index; i++) {
+      memcpy(BG_Deque_Slot(deque, i), BG_Deque_Slot(deque, i + 1), size);
+    }
+  } else {
+    deque->length++;
+    for(i = deque->length - 1; i > index; i--) {
+      memcpy(BG_Deque_Slot(deque, i), BG_Deque_Slot(deque, i - 1), size);
+    }
+  }
+
+  if(element) {
+    memcpy(BG_Deque_Slot(deque, index), element, size);
+  }
+
+  return BG_Deque_Slot(deque, index);
+}
+
+/**
+ * BG_Deque_Insert_Sorted:
+ * @deque: a #bgdeque_t
+ * @element: a pointer to the element to copy in
+ * @func: the function to compare elements in the deque.  It is passed
+ *   pointers to the two elements and should return a number > 0 if the
+ *   first element comes after the second element in the sort order.
+ * @user_data: user data to pass to @func
+ *
+ * Inserts an element into @deque before the first element that doesn't
+ * sort before it, the same place BG_List_Insert_Sorted() would put it.
+ *
+ * Returns: a pointer to the new element
+ */
+void *BG_Deque_Insert_Sorted(
+  bgdeque_t *deque, const void *element, BG_CompareDataFunc func,
+  void *user_data) {
+  int index;
+
+  Com_Assert(deque != NULL);
+  Com_Assert(func != NULL);
+
+  for(index = 0; index < deque->length; index++) {
+    if(func(BG_Deque_Slot(deque, index), element, user_data) >= 0) {
+      break;
+    }
+  }
+
+  return BG_Deque_Insert(deque, index, element);
+}
+
+/**
+ * BG_Deque_Remove_Index:
+ * @deque: a #bgdeque_t
+ * @index: the position of the element to remove
+ *
+ * Removes the @index'th element of @deque, keeping the order of the rest.
+ * Whichever side of @index has fewer elements is the one that is shifted,
+ * so removing the head is as cheap as BG_Deque_Pop_Head().
+ */
+void BG_Deque_Remove_Index(bgdeque_t *deque, int index) {
+  const size_t size = deque->elementSize;
+  int          i;
+
+  Com_Assert(deque != NULL);
+  Com_Assert(index >= 0 && index < deque->length);
+
+  if(index < deque->length / 2) {
+    for(i = index; i > 0; i--) {
+      memcpy(BG_Deque_Slot(deque, i), BG_Deque_Slot(deque, i - 1), size);
+    }
+    deque->head = (deque->head + 1) & (deque->capacity - 1);
+  } else {
+    for(i = index; i < deque->length - 1; i++) {
+      memcpy(BG_Deque_Slot(deque, i), BG_Deque_Slot(deque, i + 1), size);
+    }
+  }
+  deque->length--;
+}
+
+/**
+ * BG_Deque_Remove_All:
+ * @deque: a #bgdeque_t
+ * @element: a pointer to the value to remove
+ *
+ * Removes every element of @deque that is bytewise equal to @element,
+ * keeping the order of the rest.
+ *
+ * Returns: the number of elements removed
+ */
+int BG_Deque_Remove_All(bgdeque_t *deque, const void *element) {
+  const size_t size = deque->elementSize;
+  int          src, dst, old_length;
+
+  Com_Assert(deque != NULL);
+
+  old_length = deque->length;
+
+  // the common case of a single match is a single shift
+  src = BG_Deque_Index(deque, element);
+  if(src < 0) {
+    return 0;
+  }
+  BG_Deque_Remove_Index(deque, src);
+
+  for(dst = src; src < deque->length; src++) {
+    if(BG_Vector_Elements_Equal(BG_Deque_Slot(deque, src), element, size)) {
+      continue;
+    }
+
+    if(dst != src) {
+      memcpy(BG_Deque_Slot(deque, dst), BG_Deque_Slot(deque, src), size);
+    }
+    dst++;
+  }
+  deque->length = dst;
+
+  return old_length - deque->length;
+}
+
+/**
+ * BG_Deque_Index:
+ * @deque: a #bgdeque_t
+ * @element: a pointer to the value to find
+ *
+ * Gets the position of the first element of @deque that is bytewise equal
+ * to @element, counting from the head.
+ *
+ * Returns: the index of the element, or -1 if it isn't in @deque
+ */
+int BG_Deque_Index(const bgdeque_t *deque, const void *element) {
+  int first, i;
+
+  Com_Assert(deque != NULL);
+
+  if(!deque->length) {
+    return -1;
+  }
+
+  // the ring is searched as the run from the head to the end of the storage
+  // and the run that wrapped around to the start of it
+  first = deque->capacity - deque->head;
+  if(first > deque->length) {
+    first = deque->length;
+  }
+
+  i = BG_Vector_Find(BG_Deque_Slot(deque, 0), first, element, deque->elementSize);
+  if(i >= 0) {
+    return i;
+  }
+
+  i =
+    BG_Vector_Find(
+      (const byte *)deque->data, deque->length - first, element,
+      deque->elementSize);
+
+  return i >= 0 ? first + i : -1;
+}
+
+/*
+--------------------------------------------------------------------------------
+*/
@@ -0,0 +1,189 @@
+/*
+===========================================================================
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+
+#ifndef __BG_VECTOR_H__
+#define __BG_VECTOR_H__
+
+#include "../qcommon/q_shared.h"
+#include "bg_list.h"
+
+typedef struct bgvector_s bgvector_t;
+typedef struct bgdeque_s bgdeque_t;
+
+/**
+ * bgvector_t:
+ * @data: the elements, stored by value one after another
+ * @length: the number of elements in the vector
+ * @capacity: the number of elements @data has room for
+ * @elementSize: the size of each element in bytes
+ *
+ * A growable array.  Unlike a #bglist_t there is no link per element, the
+ * elements themselves are kept contiguous so that walking over them only
+ * touches the memory they take up.  Pointers to elements are invalidated by
+ * anything that adds or removes elements.
+ */
+struct bgvector_s
+{
+  void   *data;
+  int    length;
+  int    capacity;
+  size_t elementSize;
+};
+
+/**
+ * bgdeque_t:
+ * @data: the elements, stored by value in a ring
+ * @head: the index in @data of the first element
+ * @length: the number of elements in the deque
+ * @capacity: the number of elements @data has room for, always a power of 2
+ * @elementSize: the size of each element in bytes
+ *
+ * A growable ring buffer that can be pushed onto and popped from either end
+ * in constant time, with the same ordering semantics as a #bglist_t used as
+ * a queue.
+ */
+struct bgdeque_s
+{
+  void   *data;
+  int    head;
+  int    length;
+  int    capacity;
+  size_t elementSize;
+};
+
+/**
+ * BG_VECTOR_INIT:
+ * @type: the type of the elements
+ *
+ * A statically-allocated #bgvector_t must be initialized with this
+ * macro before it can be used, in the same way as #BG_LIST_INIT.
+ *
+ * |[
+ * bgvector_t my_vector = BG_VECTOR_INIT(zapTarget_t);
+ * ]|
+ */
+#define BG_VECTOR_INIT(type) { NULL, 0, 0, sizeof(type) }
+
+/**
+ * BG_DEQUE_INIT:
+ * @type: the type of the elements
+ *
+ * A statically-allocated #bgdeque_t must be initialized with this
+ * macro before it can be used.
+ */
+#define BG_DEQUE_INIT(type) { NULL, 0, 0, 0, sizeof(type) }
+
+/**
+ * BG_Vector_At:
+ * @vector: a #bgvector_t
+ * @type: the type of the elements
+ * @n: the index of the element, which isn't range checked
+ *
+ * Returns: the @n'th element of @vector as an lvalue of @type
+ */
+#define BG_Vector_At(vector, type, n) (((type *)(vector)->data)[(n)])
+
+/**
+ * BG_Vector_Foreach:
+ * @vector: a #bgvector_t
+ * @type: the type of the elements
+ * @ptr: a variable of type @type * that points to each element in turn
+ *
+ * Loops over the elements of @vector from the first to the last.  The body
+ * must not add elements to or remove elements from @vector.
+ *
+ * |[
+ * zapTarget_t *target;
+ *
+ * BG_Vector_Foreach(&zap->targetQueue, zapTarget_t, target) {
+ *   G_Damage(target->targetEnt, ...);
+ * }
+ * ]|
+ */
+#define BG_Vector_Foreach(vector, type, ptr) \
+  for((ptr) = (type *)(vector)->data; \
+      (ptr) < (type *)(vector)->data + (vector)->length; (ptr)++)
+
+/**
+ * BG_Deque_At:
+ * @deque: a #bgdeque_t
+ * @type: the type of the elements
+ * @n: the index of the element counting from the head, which isn't range
+ *     checked
+ *
+ * Returns: the @n'th element of @deque as an lvalue of @type
+ */
+#define BG_Deque_At(deque, type, n) \
+  (((type *)(deque)->data)[((deque)->head + (n)) & ((deque)->capacity - 1)])
+
+/**
+ * BG_Deque_Foreach:
+ * @deque: a #bgdeque_t
+ * @type: the type of the elements
+ * @ptr: a variable of type @type * that points to each element in turn
+ * @i: an int variable that holds the index of the element @ptr points to
+ *
+ * Loops over the elements of @deque from the head to the tail.  The body
+ * must not add elements to or remove elements from @deque.
+ */
+#define BG_Deque_Foreach(deque, type, ptr, i) \
+  for((i) = 0; \
+      (i) < (deque)->length && ((ptr) = &BG_Deque_At((deque), type, (i)), qtrue); \
+      (i)++)
+
+/* Vectors
+ */
+
+void     BG_Vector_Init(bgvector_t *vector, size_t elementSize);
+void     BG_Vector_Clear(bgvector_t *vector);
+void     BG_Vector_Reserve(bgvector_t *vector, int capacity);
+
+void     *BG_Vector_Push_Tail(bgvector_t *vector, const void *element);
+qboolean BG_Vector_Pop_Tail(bgvector_t *vector, void *element);
+void     *BG_Vector_Insert(bgvector_t *vector, int index, const void *element);
+
+void     BG_Vector_Remove_Index(bgvector_t *vector, int index);
+int      BG_Vector_Remove_All(bgvector_t *vector, const void *element);
+int      BG_Vector_Index(const bgvector_t *vector, const void *element);
+
+/* Deques
+ */
+
+void     BG_Deque_Init(bgdeque_t *deque, size_t elementSize);
+void     BG_Deque_Clear(bgdeque_t *deque);
+
+void     *BG_Deque_Push_Head(bgdeque_t *deque, const void *element);
+void     *BG_Deque_Push_Tail(bgdeque_t *deque, const void *element);
+qboolean BG_Deque_Pop_Head(bgdeque_t *deque, void *element);
+qboolean BG_Deque_Pop_Tail(bgdeque_t *deque, void *element);
+void     *BG_Deque_Peek_Head(const bgdeque_t *deque);
+void     *BG_Deque_Peek_Tail(const bgdeque_t *deque);
+void     *BG_Deque_Insert(bgdeque_t *deque, int index, const void *element);
+void     *BG_Deque_Insert_Sorted(
+  bgdeque_t *deque, const void *element, BG_CompareDataFunc func,
+  void *user_data);
+
+void     BG_Deque_Remove_Index(bgdeque_t *deque, int index);
+int      BG_Deque_Remove_All(bgdeque_t *deque, const void *element);
+int      BG_Deque_Index(const bgdeque_t *deque, const void *element);
+
+#endif /* __BG_VECTOR_H__ */
@@ -403,8 +403,8 @@ Send spawn queue data to a client
 */
 static void G_ClientUpdateSpawnQueue(gclient_t *client) {
   client->pers.spawn_queue_pos =
-    BG_List_Index(
-      &level.spawn_queue[client->ps.stats[STAT_TEAM]], client);
+    BG_Deque_Index(
+      &level.spawn_queue[client->ps.stats[STAT_TEAM]], &client);
 
   if(client->pers.spawn_queue_pos < 1) {
     client->ps.persistant[PERS_QUEUEPOS] = (client->pers.spawnTime - level.time) / 1000;
@@ -464,7 +464,9 @@ void SpectatorThink( gentity_t *ent, usercmd_t *ucmd )
 
   // Check to see if we are in the spawn queue
   
-  if(BG_List_Find(&level.spawn_queue[client->ps.stats[STAT_TEAM]], client)) {
+  if(
+    BG_Deque_Index(
+      &level.spawn_queue[client->ps.stats[STAT_TEAM]], &client) >= 0) {
     queued = qtrue;
   } else {
     queued = client->spawnReady;
@@ -476,8 +478,8 @@ void SpectatorThink( gentity_t *ent, usercmd_t *ucmd )
     if( client->sess.spectatorState == SPECTATOR_FOLLOW ) {
       G_StopFollowing( ent );
     }
-    BG_List_Remove_All(
-      &level.spawn_queue[client->ps.stats[STAT_TEAM]], client);
+    BG_Deque_Remove_All(
+      &level.spawn_queue[client->ps.stats[STAT_TEAM]], &client);
     client->spawnReady = qfalse;
     client->pers.classSelection = PCL_NONE;
     client->pers.humanItemSelection = WP_NONE;
@@ -2266,6 +2268,8 @@ void ClientThink_real( gentity_t *ent )
   // For firing lightning bolts early
   BG_CheckBoltImpactTrigger(&pm);
 
+  G_PmoveRecord( ent, &pm );
+
   Pmove( &pm );
 
   G_UnlaggedDetectCollisions( ent );
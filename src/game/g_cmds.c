@@ -2799,8 +2799,8 @@ qboolean G_EvolveAfterCheck( gentity_t *ent, class_t newClass, qboolean give )
 
 static int G_CompareSpawnQueuePoss(
   const void *a, const void *b, const void *user_data) {
-  gclient_t *client_a = (gclient_t *)a;
-  gclient_t *client_b = (gclient_t *)b;
+  gclient_t *client_a = *(gclient_t *const *)a;
+  gclient_t *client_b = *(gclient_t *const *)b;
 
   if(client_a == NULL || client_b == NULL) {
     return 0;
@@ -2856,11 +2856,11 @@ void Cmd_Class_f( gentity_t *ent )
       // spawn from an egg
       if( !client->spawnReady )
       {
-        bglist_t *spawn_queue = &level.spawn_queue[client->ps.stats[STAT_TEAM]];
+        bgdeque_t *spawn_queue = &level.spawn_queue[client->ps.stats[STAT_TEAM]];
 
-        if(BG_List_Find(spawn_queue, client) == NULL) {
-          BG_List_Insert_Sorted(
-            spawn_queue, client, G_CompareSpawnQueuePoss, NULL);
+        if(BG_Deque_Index(spawn_queue, &client) < 0) {
+          BG_Deque_Insert_Sorted(
+            spawn_queue, &client, G_CompareSpawnQueuePoss, NULL);
         }
 
         g_entities[ clientNum ].client->ps.persistant[ PERS_STATE ] |= PS_QUEUED;
@@ -2890,11 +2890,11 @@ void Cmd_Class_f( gentity_t *ent )
       // spawn from a telenode
       if( !client->spawnReady )
       {
-        bglist_t *spawn_queue = &level.spawn_queue[client->ps.stats[STAT_TEAM]];
+        bgdeque_t *spawn_queue = &level.spawn_queue[client->ps.stats[STAT_TEAM]];
 
-        if(BG_List_Find(spawn_queue, client) == NULL) {
-          BG_List_Insert_Sorted(
-            spawn_queue, client, G_CompareSpawnQueuePoss, NULL);
+        if(BG_Deque_Index(spawn_queue, &client) < 0) {
+          BG_Deque_Insert_Sorted(
+            spawn_queue, &client, G_CompareSpawnQueuePoss, NULL);
         }
 
         g_entities[ clientNum ].client->ps.persistant[ PERS_STATE ] |= PS_QUEUED;
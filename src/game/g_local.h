@@ -894,7 +894,7 @@ typedef struct
   timeWarning_t     timelimitWarning;
   qboolean          sudden_death_replacable[BA_NUM_BUILDABLES];
 
-  bglist_t         spawn_queue[NUM_TEAMS];
+  bgdeque_t        spawn_queue[NUM_TEAMS];
 
   int               alienStage2Time;
   int               alienStage3Time;
@@ -1358,7 +1358,7 @@ typedef struct zap_s
 {
   bglink_t      *zapLink;
   gentity_t     *creator;
-  bglist_t     targetQueue;
+  bgvector_t    targetQueue;
 
   int           timeToLive;
 
@@ -1368,7 +1368,7 @@ typedef struct zap_s
 extern bglink_t *lev2ZapList;
 
 void      G_PackEntityNumbers( entityState_t *es, int creatorNum,
-                               bglist_t *targetQueue );
+                               bgvector_t *targetQueue );
 
 void      G_ForceWeaponChange( gentity_t *ent, weapon_t weapon );
 qboolean  G_CanGiveClientMaxAmmo( gentity_t *ent, qboolean buyingEnergyAmmo,
@@ -1417,6 +1417,7 @@ void      G_Client_For_All( void (*func)( gentity_t *ent ) );
 qboolean  ConsoleCommand( void );
 void      G_RegisterCommands( void );
 void      G_UnregisterCommands( void );
+void      G_PmoveRecord( gentity_t *ent, pmove_t *pm );
 
 //
 // g_weapon.c
@@ -1746,6 +1747,10 @@ extern  vmCvar_t  g_censorship;
 void      Com_Printf( const char *msg, ... );
 void      Com_Error( int level, const char *error, ... );
 int       Sys_Milliseconds( void );
+typedef void ( *sysThreadFunc_t )( void *arg );
+void      *Sys_CreateThread( sysThreadFunc_t func, void *arg );
+void      Sys_JoinThread( void *thread );
+int       Sys_ProcessorCount( void );
 int       Com_RealTime( qtime_t *qtime );
 int       Cmd_Argc( void );
 void      Cmd_ArgvBuffer( int n, char *buffer, int bufferLength );
@@ -1759,6 +1764,7 @@ int       FS_Seek( fileHandle_t f, long offset, int origin ); // fsOrigin_t
 void      Cbuf_ExecuteText( int exec_when, const char *text );
 void      Cvar_Register( vmCvar_t *cvar, const char *var_name, const char *value, int flags );
 void      Cvar_Update( vmCvar_t *cvar );
+int       Cvar_ChangedHandles( int *sequence, cvarHandle_t *handles, int maxHandles );
 void      Cvar_SetSafe( const char *var_name, const char *value );
 void 	    Cvar_ForceReset(const char *var_name);
 int       Cvar_VariableIntegerValue( const char *var_name );
@@ -1801,6 +1807,13 @@ qboolean  SV_inPVS( const vec3_t p1, const vec3_t p2 );
 qboolean  SV_inPVSIgnorePortals( const vec3_t p1, const vec3_t p2 );
 void      SV_AdjustAreaPortalState( gentity_t *ent, qboolean open );
 qboolean  CM_AreasConnected( int area1, int area2 );
+int       CM_PointContents( const vec3_t p, clipHandle_t model );
+void      CM_BoxTrace(
+	trace_t *results, const vec3_t start, const vec3_t end, vec3_t mins,
+	vec3_t maxs, clipHandle_t model, int brushmask, traceType_t type);
+void      CM_BiSphereTrace(
+	trace_t *results, const vec3_t start, const vec3_t end, float startRad,
+	float endRad, clipHandle_t model, int mask);
 void      SV_LinkEntity( gentity_t *ent );
 void      SV_UnlinkEntity( gentity_t *ent );
 int       SV_AreaEntities(
@@ -415,6 +415,12 @@ static cvarTable_t   gameCvarTable[ ] =
 
 static size_t gameCvarTableSize = ARRAY_LEN( gameCvarTable );
 
+// gameCvarTable entries by cvar handle, so G_UpdateCvars only has to
+// look at the cvars the engine reports as changed
+static int gameCvarsByHandle[ MAX_CVARS ];
+static int gameCvarNextForHandle[ ARRAY_LEN( gameCvarTable ) ];
+static int gameCvarSequence = -1;
+
 void CheckExitRules( void );
 
 void G_CountBuildables( void );
@@ -508,47 +514,79 @@ void G_RegisterCvars( void )
   int         i;
   cvarTable_t *cv;
 
+  for( i = 0; i < MAX_CVARS; i++ )
+    gameCvarsByHandle[ i ] = -1;
+
   for( i = 0, cv = gameCvarTable; i < gameCvarTableSize; i++, cv++ )
   {
     Cvar_Register( cv->vmCvar, cv->cvarName,
       cv->defaultString, cv->cvarFlags );
 
+    gameCvarNextForHandle[ i ] = -1;
     if( cv->vmCvar )
+    {
       cv->modificationCount = cv->vmCvar->modificationCount;
 
+      gameCvarNextForHandle[ i ] = gameCvarsByHandle[ cv->vmCvar->handle ];
+      gameCvarsByHandle[ cv->vmCvar->handle ] = i;
+    }
+
     if( cv->explicit )
       strcpy( cv->explicit, cv->vmCvar->string );
   }
+
+  gameCvarSequence = -1;
 }
 
 /*
 =================
-G_UpdateCvars
+G_UpdateCvar
 =================
 */
-void G_UpdateCvars( void )
+static void G_UpdateCvar( cvarTable_t *cv )
 {
-  int         i;
-  cvarTable_t *cv;
+  Cvar_Update( cv->vmCvar );
 
-  for( i = 0, cv = gameCvarTable; i < gameCvarTableSize; i++, cv++ )
+  if( cv->modificationCount != cv->vmCvar->modificationCount )
   {
-    if( cv->vmCvar )
-    {
-      Cvar_Update( cv->vmCvar );
+    cv->modificationCount = cv->vmCvar->modificationCount;
 
-      if( cv->modificationCount != cv->vmCvar->modificationCount )
-      {
-        cv->modificationCount = cv->vmCvar->modificationCount;
+    if( cv->trackChange )
+      SV_GameSendServerCommand( -1, va( "print \"Server: %s changed to %s\n\"",
+        cv->cvarName, cv->vmCvar->string ) );
 
-        if( cv->trackChange )
-          SV_GameSendServerCommand( -1, va( "print \"Server: %s changed to %s\n\"",
-            cv->cvarName, cv->vmCvar->string ) );
+    if( !level.spawning && cv->explicit )
+      strcpy( cv->explicit, cv->vmCvar->string );
+  }
+}
 
-        if( !level.spawning && cv->explicit )
-          strcpy( cv->explicit, cv->vmCvar->string );
-      }
+/*
+=================
+G_UpdateCvars
+=================
+*/
+void G_UpdateCvars( void )
+{
+  cvarHandle_t handles[ 64 ];
+  int          i, j, numHandles;
+  cvarTable_t  *cv;
+
+  numHandles = Cvar_ChangedHandles( &gameCvarSequence, handles, ARRAY_LEN( handles ) );
+
+  if( numHandles < 0 )
+  {
+    for( i = 0, cv = gameCvarTable; i < gameCvarTableSize; i++, cv++ )
+    {
+      if( cv->vmCvar )
+        G_UpdateCvar( cv );
     }
+    return;
+  }
+
+  for( i = 0; i < numHandles; i++ )
+  {
+    for( j = gameCvarsByHandle[ handles[ i ] ]; j >= 0; j = gameCvarNextForHandle[ j ] )
+      G_UpdateCvar( &gameCvarTable[ j ] );
   }
 }
 
@@ -822,7 +860,7 @@ Q_EXPORT void G_InitGame( int levelTime, int randomSeed, int restart )
   G_ExecutePlaymapFlags( level.playmapFlags );
 
   for(i = 0; i < NUM_TEAMS; i++) {
-    BG_List_Init(&level.spawn_queue[i]);
+    BG_Deque_Init(&level.spawn_queue[i], sizeof(gclient_t *));
   }
 
   if( g_debugMapRotation.integer )
@@ -902,7 +940,7 @@ Q_EXPORT void G_ShutdownGame( int restart )
   G_ClearVotes( );
 
   for(i = 0; i < NUM_TEAMS; i++) {
-    BG_List_Clear(&level.spawn_queue[i]);
+    BG_Deque_Clear(&level.spawn_queue[i]);
   }
 
   if(IS_SCRIM && level.scrim.scrim_completed) {
@@ -1002,12 +1040,6 @@ int QDECL SortRanks( const void *a, const void *b )
     return 0;
 }
 
-static void G_Print_Client_Num_For_Spawn_Pos(void *data, void *user_data) {
-  gclient_t *client = (gclient_t *)data;
-
-  Com_Printf( "%d:", client - g_clients);
-}
-
 /*
 -============
 -G_PrintSpawnQueue
@@ -1016,16 +1048,20 @@ static void G_Print_Client_Num_For_Spawn_Pos(void *data, void *user_data) {
 -============
 -*/
 void G_PrintSpawnQueue(team_t team) {
-  bglist_t *spawn_queue = &level.spawn_queue[team];
-  gclient_t *head_client = (gclient_t *)spawn_queue->head;
-  gclient_t *tail_client = (gclient_t *)spawn_queue->tail;
-  int       head = head_client ? head_client - g_clients : -1;
-  int       tail = tail_client ? tail_client - g_clients : -1;
-  int length = BG_List_Get_Length(spawn_queue);
+  bgdeque_t *spawn_queue = &level.spawn_queue[team];
+  gclient_t **head_client = BG_Deque_Peek_Head(spawn_queue);
+  gclient_t **tail_client = BG_Deque_Peek_Tail(spawn_queue);
+  gclient_t **client;
+  int       head = head_client ? *head_client - g_clients : -1;
+  int       tail = tail_client ? *tail_client - g_clients : -1;
+  int       i;
 
-  Com_Printf("length:%d head:%d tail:%d    :", length, head, tail);
+  Com_Printf(
+    "length:%d head:%d tail:%d    :", spawn_queue->length, head, tail);
 
-  BG_List_Foreach(spawn_queue, NULL, G_Print_Client_Num_For_Spawn_Pos, NULL);
+  BG_Deque_Foreach(spawn_queue, gclient_t *, client, i) {
+    Com_Printf( "%d:", (int)(*client - g_clients));
+  }
 
   Com_Printf( "\n" );
 }
@@ -1034,14 +1070,13 @@ void G_PrintSpawnQueue(team_t team) {
 ============
 G_SpawnClients
 
-Spawn queued clients
+Spawn a queued client
 ============
 */
-void G_SpawnClients(void *data, void *user_data) {
-  gclient_t *client = (gclient_t *)data;
+static void G_SpawnClients(gclient_t *client) {
   gentity_t *ent = NULL;
 	team_t    team;
-  bglist_t *spawn_queue;
+  bgdeque_t *spawn_queue;
   int       client_num = client - level.clients;
 	int       numSpawns = 0;
 
@@ -1065,7 +1100,7 @@ void G_SpawnClients(void *data, void *user_data) {
   }
 
   spawn_queue = &level.spawn_queue[team];
-  if(!IS_WARMUP && BG_List_Index(spawn_queue, ent->client) > 0) {
+  if(!IS_WARMUP && BG_Deque_Index(spawn_queue, &ent->client) > 0) {
     return;
   }
 
@@ -1080,8 +1115,8 @@ void G_SpawnClients(void *data, void *user_data) {
 			ent->client->sess.spectatorState = SPECTATOR_NOT;
 			ClientUserinfoChanged( ent->client->ps.clientNum, qfalse );
 			ClientSpawn( ent, spawn, spawn_origin, spawn_angles, qtrue );
-      BG_List_Remove_All(
-        &level.spawn_queue[team], ent->client);
+      BG_Deque_Remove_All(
+        &level.spawn_queue[team], &ent->client);
 			ent->client->spawnReady = qfalse;
       ent->client->ps.persistant[ PERS_STATE ] &= ~PS_QUEUED;
 		}
@@ -1763,7 +1798,7 @@ void BeginIntermission( void )
   G_ClearVotes( );
 
   for(i = 0; i < NUM_TEAMS; i++) {
-    BG_List_Clear(&level.spawn_queue[i]);
+    BG_Deque_Clear(&level.spawn_queue[i]);
   }
 
   G_UpdateTeamConfigStrings( );
@@ -3232,6 +3267,9 @@ Q_EXPORT void G_RunFrame( int levelTime )
   int        msec;
   static int ptime3000 = 0;
 
+  // nothing allocated for the last frame is needed any more
+  BG_FrameArenaReset( );
+
   // if we are waiting for the level to restart, do nothing
   if( level.restarted )
     return;
@@ -3444,7 +3482,21 @@ Q_EXPORT void G_RunFrame( int levelTime )
     G_CalculateBuildPoints( );
     G_CalculateStages( );
     for(i = 0; i < NUM_TEAMS; i++) {
-      BG_List_Foreach(&level.spawn_queue[i], NULL, G_SpawnClients, NULL);
+      bgdeque_t *spawn_queue = &level.spawn_queue[i];
+      int       j = 0;
+
+      while(j < spawn_queue->length) {
+        gclient_t *client = BG_Deque_At(spawn_queue, gclient_t *, j);
+
+        G_SpawnClients(client);
+
+        // a client that spawned took itself out of the queue
+        if(
+          j < spawn_queue->length &&
+          BG_Deque_At(spawn_queue, gclient_t *, j) == client) {
+          j++;
+        }
+      }
     }
     G_CalculateAvgPlayers( );
     G_UpdateZaps( msec );
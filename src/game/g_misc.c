@@ -478,11 +478,10 @@ Used for sending zap effects to clients.
 ===============
 */
 void G_PackEntityNumbers( entityState_t *es, int creatorNum,
-                           bglist_t *targetQueue )
+                           bgvector_t *targetQueue )
 {
-  bglink_t *targetZapLink = BG_List_Peek_Head_Link( targetQueue );
   int      i;
-  int      count = BG_List_Get_Length( targetQueue ) + 1;
+  int      count = targetQueue->length + 1;
 
   if( count > MAX_NUM_PACKED_ENTITY_NUMS )
   {
@@ -506,8 +505,7 @@ void G_PackEntityNumbers( entityState_t *es, int creatorNum,
 
     if( i < count )
     {
-      entityNum = ((zapTarget_t *)targetZapLink->data)->targetEnt->s.number;
-      targetZapLink = targetZapLink->next;
+      entityNum = BG_Vector_At( targetQueue, zapTarget_t, i - 1 ).targetEnt->s.number;
     }
     else
       entityNum = ENTITYNUM_NONE;
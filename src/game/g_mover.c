@@ -57,10 +57,25 @@ typedef struct pushes_s {
   mover_data_t mover_data[MAX_GENTITIES];
   //first index is the pusher, second is the pushee
   mover_push_t type[MAX_GENTITIES][MAX_GENTITIES]; 
+
+  //pushers with a row in type to clear before the next move, so that the
+  //whole table doesn't have to be cleared for every move
+  qboolean     type_row_set[MAX_GENTITIES];
+  int          type_rows[MAX_GENTITIES];
+  int          num_type_rows;
 } pushes_t;
 
 static pushes_t pushes;
 
+//for each entity, the entities standing on it in entity number order,
+//linked through next and terminated by -1.  Built once for each move.
+typedef struct mover_riders_s {
+  int first[MAX_GENTITIES];
+  int next[MAX_GENTITIES];
+} mover_riders_t;
+
+static mover_riders_t riders;
+
 /*
 ===============================================================================
 
@@ -81,6 +96,52 @@ typedef struct
 
 pushed_t  pushed[ MAX_PUSHES ], *pushed_p;
 
+//entities found in contact during a move, last found first.  Kept in the
+//frame arena, each level of the push giving its contacts back when done with
+//them.
+typedef struct mover_contact_s {
+  gentity_t              *ent;
+  struct mover_contact_s *next;
+} mover_contact_t;
+
+/*
+============
+G_Mover_Contact
+============
+*/
+static void G_Mover_Contact(mover_contact_t **contacts, gentity_t *ent) {
+  mover_contact_t *contact = BG_FrameAlloc(sizeof(*contact));
+
+  contact->ent = ent;
+  contact->next = *contacts;
+  *contacts = contact;
+}
+
+/*
+============
+G_Mover_Find_Riders
+
+Indexes the entities by what they stand on, for the push about to be made
+============
+*/
+static void G_Mover_Find_Riders(void) {
+  int i;
+
+  memset(riders.first, -1, sizeof(riders.first));
+
+  //walk backwards so that each chain is in entity number order
+  for(i = ENTITYNUM_MAX_NORMAL - 1; i >= 0; i--) {
+    int ground = g_entities[i].s.groundEntityNum;
+
+    if(ground < 0 || ground >= MAX_GENTITIES) {
+      continue;
+    }
+
+    riders.next[i] = riders.first[ground];
+    riders.first[ground] = i;
+  }
+}
+
 /*
 ============
 G_Set_Pusher_Num
@@ -170,6 +231,10 @@ static qboolean G_Set_Push_Type(
     return qfalse;
   }
 
+  if(!pushes.type_row_set[pusher->s.number]) {
+    pushes.type_row_set[pusher->s.number] = qtrue;
+    pushes.type_rows[pushes.num_type_rows++] = pusher->s.number;
+  }
   pushes.type[pusher->s.number][ent->s.number] = push_type;
   return qtrue;
 }
@@ -338,10 +403,10 @@ If rough_check is false, collisions are further tested with a trace
 ============
 */
 static qboolean G_Pushable_Area_Ents_For_Move(
-  gentity_t   *ent,
-  push_data_t *push_data,
-  bglist_t   *ent_list,
-  qboolean    rough_check) {
+  gentity_t       *ent,
+  push_data_t     *push_data,
+  mover_contact_t **ent_list,
+  qboolean        rough_check) {
   vec3_t      total_move;
   qboolean    check_for_direct_block = qfalse;
   int         ent_array[MAX_GENTITIES];
@@ -443,7 +508,7 @@ static qboolean G_Pushable_Area_Ents_For_Move(
     }
 
     if(rough_check || G_TestEntAgainstOtherEnt(pushable, ent->s.number)) {
-      BG_List_Push_Head(ent_list, pushable);
+      G_Mover_Contact(ent_list, pushable);
       //only need to find one pushable entity for the roughcheck
       if(rough_check) {
         return qfalse;
@@ -490,7 +555,8 @@ static void G_Find_Mover_Pushes(void *data, void *user_data ) {
   gentity_t   *check = (gentity_t *)data;
   push_data_t *push_data = (push_data_t *)user_data;
   push_data_t next_push_data;
-  bglist_t   pushable_ents = BG_LIST_INIT;
+  void        *mark = BG_FrameArenaMark( );
+  mover_contact_t *pushable_ents = NULL, *contact;
   int         i;
 
   Com_Assert(push_data && "G_Find_Mover_Pushes: push_data is NULL");
@@ -532,7 +598,7 @@ static void G_Find_Mover_Pushes(void *data, void *user_data ) {
   }
 
   //check any and all collided pushable entities
-  if(pushable_ents.length) {
+  if(pushable_ents) {
     next_push_data.pusher = push_data->pusher;
     if(push_data->push_type == MPUSH_RIDE) {
       next_push_data.push_type =  MPUSH_RIDING_STACK_HIT;
@@ -543,18 +609,16 @@ static void G_Find_Mover_Pushes(void *data, void *user_data ) {
     VectorCopy(push_data->amove, next_push_data.amove);
     VectorCopy(push_data->move, next_push_data.move);
 
-    BG_List_Foreach(&pushable_ents, NULL, G_Foreach_Find_Mover_Pushes, &next_push_data);
-    BG_List_Clear(&pushable_ents);
+    for(contact = pushable_ents; contact; contact = contact->next) {
+      G_Foreach_Find_Mover_Pushes(contact->ent, &next_push_data);
+    }
   }
+  BG_FrameArenaRelease(mark);
 
   //check riding entities that have not collided from the push
-  for(i = 0; i < ENTITYNUM_MAX_NORMAL; i++) {
+  for(i = riders.first[check->s.number]; i >= 0; i = riders.next[i]) {
     gentity_t *rider = &g_entities[i];
 
-    if(rider->s.groundEntityNum != check->s.number) {
-      continue;
-    }
-
     //don't check riders that have already been checked
     
     if(pushes.type[check->s.number][rider->s.number] > MPUSH_NONE) {
@@ -792,8 +856,8 @@ returns qtrue if an obstacle blocks the prime mover
 ==================
 */
 static qboolean G_Find_Mover_Blockage(
-  push_data_t *push_data,
-  bglist_t   *obstacles) {
+  push_data_t     *push_data,
+  mover_contact_t **obstacles) {
   gentity_t   *check;
   pushed_t    *saved_pushed = pushed_p;
   qboolean    block_prime_mover = qfalse;
@@ -873,7 +937,7 @@ static qboolean G_Find_Mover_Blockage(
           continue;
         }
 
-        BG_List_Push_Head(obstacles, check);
+        G_Mover_Contact(obstacles, check);
         block_prime_mover = qtrue;
         continue;
       }
@@ -984,9 +1048,8 @@ static qboolean G_TryPushingEntities(
   vec3_t       start_angles,
   vec3_t       move,
   vec3_t       amove,
-  bglist_t    *obstacles) {
+  mover_contact_t **obstacles) {
   push_data_t  push_data;
-  bglist_t    pushable_ents = BG_LIST_INIT;
   qboolean     rider_in_range = qfalse;
   int          i;
 
@@ -1001,15 +1064,11 @@ static qboolean G_TryPushingEntities(
   VectorCopy(move, push_data.move);
   VectorCopy(amove, push_data.amove);
   //check if there are any pushable entities the range of the mover, if not the
-  //expensive memset of the pushes structure for initialization can be avoided
-  //entirely.
-  for(i = 0; i < ENTITYNUM_MAX_NORMAL; i++) {
+  //initialization of the pushes structure can be avoided entirely.
+  G_Mover_Find_Riders( );
+  for(i = riders.first[check->s.number]; i >= 0; i = riders.next[i]) {
     gentity_t *rider = &g_entities[i];
 
-    if(rider->s.groundEntityNum != check->s.number) {
-      continue;
-    }
-
     //don't check self as a rider
     if(rider->s.number == check->s.number) {
       continue;
@@ -1022,16 +1081,26 @@ static qboolean G_TryPushingEntities(
     rider_in_range = qtrue;
   }
   if(!rider_in_range) {
+    void            *mark = BG_FrameArenaMark( );
+    mover_contact_t *pushable_ents = NULL;
+
     G_Pushable_Area_Ents_For_Move(check, &push_data, &pushable_ents, qtrue);
-    if(!pushable_ents.length) {
+    BG_FrameArenaRelease(mark);
+    if(!pushable_ents) {
       //nothing to move
       return qtrue;
     }
-    BG_List_Clear(&pushable_ents);
   }
 
   //finish initializing for the move
-  memset(&pushes, 0, sizeof(pushes_t));
+  memset(pushes.mover_data, 0, sizeof(pushes.mover_data));
+  for(i = 0; i < pushes.num_type_rows; i++) {
+    int row = pushes.type_rows[i];
+
+    memset(pushes.type[row], 0, sizeof(pushes.type[row]));
+    pushes.type_row_set[row] = qfalse;
+  }
+  pushes.num_type_rows = 0;
   for( i = 0; i < MAX_GENTITIES; i++ ) {
     if(!g_entities[i].inuse) {
       continue;
@@ -1063,16 +1132,17 @@ G_MoverPush
 
 Objects need to be moved back on a failed push,
 otherwise riders would continue to slide.
-If qfalse is returned, *obstacle will be the blocking entity
+If qfalse is returned, the blocking entities will have been added to
+*obstacles
 ============
 */
-qboolean G_MoverPush(
+static qboolean G_MoverPush(
   gentity_t *pusher,
   vec3_t    start_origin,
   vec3_t    start_angles,
   vec3_t    move,
   vec3_t    amove,
-  bglist_t *obstacles) {
+  mover_contact_t **obstacles) {
   pushed_t  *p;
 
   // move the prime pusher to its final position
@@ -1114,17 +1184,6 @@ qboolean G_MoverPush(
   return qtrue;
 }
 
-void G_Foreach_Blocked(void *data, void *user_data) {
-  gentity_t *block = (gentity_t *)data;
-  gentity_t  *pusher = (gentity_t *)user_data;
-
-  Com_Assert(block && "G_Foreach_Blocked: block is NULL");
-  Com_Assert(pusher && "G_Foreach_Blocked: pusher is NULL");
-  Com_Assert(pusher->blocked && "G_Foreach_Blocked: pusher->blocked is NULL");
-
-  pusher->blocked(pusher, block);
-}
-
 /*
 =================
 G_MoverTeam
@@ -1134,7 +1193,8 @@ void G_MoverTeam(gentity_t *ent) {
   vec3_t    move, amove;
   gentity_t *part;
   vec3_t    origin, angles;
-  bglist_t obstacles = BG_LIST_INIT;
+  void      *mark = BG_FrameArenaMark( );
+  mover_contact_t *obstacles = NULL;
   qboolean  move_blocked = qfalse;
 
   // make sure all team slaves can move before commiting
@@ -1183,14 +1243,20 @@ void G_MoverTeam(gentity_t *ent) {
 
     // if the pusher has a "blocked" function, call it
     if(ent->blocked) {
-      BG_List_Foreach(&obstacles, NULL, G_Foreach_Blocked, ent);
+      mover_contact_t *obstacle;
+
+      for(obstacle = obstacles; obstacle; obstacle = obstacle->next) {
+        ent->blocked(ent, obstacle->ent);
+      }
     }
 
-    BG_List_Clear(&obstacles);
+    BG_FrameArenaRelease(mark);
 
     return;
   }
 
+  BG_FrameArenaRelease(mark);
+
   // the move succeeded
   for(part = ent; part; part = part->teamchain) {
     // call the reached function if time is at or past end point
@@ -602,6 +602,643 @@ static void Svcmd_G_MemoryInfo( void ) {
   G_Missle_Entity_ID_Free_Memory_Info( );
 }
 
+/*
+===================
+Pmove replays
+
+pmoverecord takes down the commands a player's Pmoves run with and
+pmovebench replays them against the BSP alone.  The cgame has the same
+pmovebench, so the hashes show whether both move players the same way.
+===================
+*/
+
+static pmoveReplay_t pmoveReplay;
+static int           pmoveRecordClient = -1;
+static char          pmoveRecordName[ MAX_QPATH ];
+
+/*
+===================
+G_PmoveRecordStop
+===================
+*/
+static void G_PmoveRecordStop( void )
+{
+  if( pmoveRecordClient < 0 )
+    return;
+
+  if( BG_PmoveReplaySave( pmoveRecordName, &pmoveReplay ) )
+    Com_Printf( "wrote %d commands to pmove/%s.pmr\n",
+      pmoveReplay.header.numCmds, pmoveRecordName );
+
+  pmoveRecordClient = -1;
+}
+
+/*
+===================
+G_PmoveRecord
+
+Called by ClientThink_real just before Pmove
+===================
+*/
+void G_PmoveRecord( gentity_t *ent, pmove_t *pm )
+{
+  pmoveReplayHeader_t *header = &pmoveReplay.header;
+
+  if( ent - g_entities != pmoveRecordClient )
+    return;
+
+  if( !header->numCmds )
+  {
+    Cvar_VariableStringBuffer( "mapname", header->mapname, sizeof( header->mapname ) );
+    header->trace_mask = pm->trace_mask;
+    header->pmove_fixed = pm->pmove_fixed;
+    header->pmove_msec = pm->pmove_msec;
+    header->humanStaminaMode = pm->humanStaminaMode;
+    header->playerAccelMode = pm->playerAccelMode;
+    header->swapAttacks = pm->swapAttacks;
+    header->wallJumperMinFactor = pm->wallJumperMinFactor;
+    header->marauderMinJumpFactor = pm->marauderMinJumpFactor;
+    header->reactor = pm->pm_reactor( );
+    header->ps = *pm->ps;
+    header->pmext = *pm->pmext;
+  }
+
+  pmoveReplay.cmds[ header->numCmds++ ] = pm->cmd;
+
+  if( header->numCmds == MAX_PMOVE_REPLAY_CMDS )
+    G_PmoveRecordStop( );
+}
+
+/*
+===================
+Svcmd_PmoveRecord_f
+===================
+*/
+static void Svcmd_PmoveRecord_f( void )
+{
+  char      name[ MAX_STRING_CHARS ];
+  gclient_t *cl;
+
+  if( Cmd_Argc( ) == 1 )
+  {
+    if( pmoveRecordClient < 0 )
+      Com_Printf( "usage: pmoverecord <player> <stream>, or no arguments to stop\n" );
+    G_PmoveRecordStop( );
+    return;
+  }
+
+  if( Cmd_Argc( ) != 3 )
+  {
+    Com_Printf( "usage: pmoverecord <player> <stream>, or no arguments to stop\n" );
+    return;
+  }
+
+  Cmd_ArgvBuffer( 1, name, sizeof( name ) );
+  cl = ClientForString( name );
+  if( !cl )
+    return;
+
+  G_PmoveRecordStop( );
+
+  Cmd_ArgvBuffer( 2, pmoveRecordName, sizeof( pmoveRecordName ) );
+  Com_Memset( &pmoveReplay.header, 0, sizeof( pmoveReplay.header ) );
+  pmoveRecordClient = cl - level.clients;
+  Com_Printf( "recording %s^7's Pmoves to pmove/%s.pmr\n", cl->pers.netname,
+    pmoveRecordName );
+}
+
+static const struct
+{
+  const char *name;
+  class_t    class;
+  weapon_t   weapon;
+  upgrade_t  upgrade;
+} pmoveScripts[ ] =
+{
+  { "dretch", PCL_ALIEN_LEVEL0, WP_ALEVEL0, UP_NONE },     // wall walking
+  { "marauder", PCL_ALIEN_LEVEL2, WP_ALEVEL2, UP_NONE },   // wall jumping
+  { "jetpack", PCL_HUMAN, WP_MACHINEGUN, UP_JETPACK }
+};
+
+#define PMOVE_SCRIPT_MSEC 8         // 125fps
+#define PMOVE_SCRIPT_TIME 30000
+
+/*
+===================
+G_PmoveScript
+
+Streams for maps nobody has recorded on: from the intermission point,
+30 seconds of running forward while turning, strafing from side to side
+and, for the dretch, holding crouch to walk on walls with a jump every
+two seconds, for the marauder jumping three times a second and for the
+human flying the jetpack one and a half seconds out of every two and a
+half
+===================
+*/
+static qboolean G_PmoveScript( const char *name, pmoveReplay_t *replay )
+{
+  pmoveReplayHeader_t *header = &replay->header;
+  playerState_t       *ps = &header->ps;
+  const classAttributes_t *class;
+  usercmd_t           *cmd;
+  int                 script, i, t;
+  float               pitch;
+
+  for( script = 0; script < ARRAY_LEN( pmoveScripts ); script++ )
+  {
+    if( !Q_stricmp( name, pmoveScripts[ script ].name ) )
+      break;
+  }
+
+  if( script == ARRAY_LEN( pmoveScripts ) )
+    return qfalse;
+
+  class = BG_Class( pmoveScripts[ script ].class );
+
+  Com_Memset( header, 0, sizeof( *header ) );
+  Cvar_VariableStringBuffer( "mapname", header->mapname, sizeof( header->mapname ) );
+  header->trace_mask = *Temp_Clip_Mask( MASK_PLAYERSOLID, 0 );
+  header->pmove_fixed = pmove_fixed.integer;
+  header->pmove_msec = pmove_msec.integer;
+  header->humanStaminaMode = g_humanStaminaMode.integer;
+  header->playerAccelMode = g_playerAccelMode.integer;
+  header->wallJumperMinFactor = 0.3f;
+  header->marauderMinJumpFactor = 0.7f;
+  header->reactor = qtrue;
+
+  // what ClientSpawn and ClientThink_real would have set
+  ps->pm_type = PM_NORMAL;
+  ps->clientNum = 0;
+  ps->groundEntityNum = ENTITYNUM_NONE;
+  ps->gravity = g_gravity.value;
+  ps->speed = g_speed.value * class->speed;
+  ps->stats[ STAT_CLASS ] = pmoveScripts[ script ].class;
+  ps->stats[ STAT_TEAM ] = class->team;
+  ps->stats[ STAT_BUILDABLE ] = BA_NONE;
+  if( pmoveScripts[ script ].upgrade != UP_NONE )
+    BG_AddUpgradeToInventory( pmoveScripts[ script ].upgrade, ps->stats );
+  ps->stats[ STAT_FUEL ] = JETPACK_FUEL_FULL;
+  ps->stats[ STAT_WEAPON ] = ps->weapon = ps->misc[ MISC_HELD_WEAPON ] =
+    pmoveScripts[ script ].weapon;
+  ps->ammo = BG_GetMaxAmmo( ps->stats, ps->weapon );
+  *BG_GetClips( ps, ps->weapon ) = BG_GetMaxClips( ps->stats, ps->weapon );
+  ps->weaponstate = WEAPON_READY;
+  ps->misc[ MISC_HEALTH ] = class->health;
+  if( BG_ClassHasAbility( ps->stats[ STAT_CLASS ], SCA_STAMINA ) )
+    ps->stats[ STAT_STAMINA ] = STAMINA_MAX;
+  if( BG_ClassHasAbility( ps->stats[ STAT_CLASS ], SCA_CHARGE_STAMINA ) )
+    ps->misc[ MISC_CHARGE_STAMINA ] = class->chargeStaminaMax / class->chargeStaminaRestoreRate;
+  VectorCopy( level.intermission_origin, ps->origin );
+  VectorSet( ps->grapplePoint, 0.0f, 0.0f, 1.0f );
+  ps->torsoAnim = TORSO_STAND;
+  ps->legsAnim = LEGS_IDLE;
+
+  header->numCmds = PMOVE_SCRIPT_TIME / PMOVE_SCRIPT_MSEC;
+  for( i = 0; i < header->numCmds; i++ )
+  {
+    cmd = &replay->cmds[ i ];
+    t = ( i + 1 ) * PMOVE_SCRIPT_MSEC;
+
+    Com_Memset( cmd, 0, sizeof( *cmd ) );
+    cmd->serverTime = t;
+    cmd->weapon = ps->weapon;
+    cmd->forwardmove = 127;
+    cmd->rightmove = ( t / 1500 ) % 2 ? 127 : -127;
+
+    // turn at 40 degrees a second, nodding up and down every four
+    pitch = ( t % 4000 ) * 0.06f - 120.0f;
+    if( pitch > 0.0f )
+      pitch = -pitch;
+    cmd->angles[ YAW ] = ANGLE2SHORT( t * 0.04f );
+    cmd->angles[ PITCH ] = ANGLE2SHORT( pitch + 60.0f );
+
+    switch( pmoveScripts[ script ].class )
+    {
+      case PCL_ALIEN_LEVEL0:
+        cmd->upmove = t % 2000 < 200 ? 127 : -127;
+        break;
+
+      case PCL_ALIEN_LEVEL2:
+        cmd->rightmove = ( t / 700 ) % 2 ? 127 : -127;
+        cmd->upmove = t % 333 < 100 ? 127 : 0;
+        break;
+
+      default:
+        cmd->upmove = t % 2500 < 1500 ? 127 : 0;
+        break;
+    }
+  }
+
+  return qtrue;
+}
+
+/*
+===================
+G_PmoveBenchTrace
+
+Only the BSP, the same as the cgame's
+===================
+*/
+static void G_PmoveBenchTrace(
+  trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs,
+  const vec3_t end, int passEntityNum, qboolean clip_against_missiles,
+  const content_mask_t content_mask, traceType_t type )
+{
+  vec3_t zero = { 0.0f, 0.0f, 0.0f };
+
+  if( !mins )
+    mins = zero;
+  if( !maxs )
+    maxs = zero;
+
+  if( type == TT_BISPHERE )
+    CM_BiSphereTrace( results, start, end, mins[ 0 ], maxs[ 0 ], 0, content_mask.include );
+  else
+    CM_BoxTrace( results, start, end, mins, maxs, 0, content_mask.include, type );
+
+  results->entityNum = results->fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+}
+
+/*
+===================
+G_PmoveBenchPointContents
+===================
+*/
+static int G_PmoveBenchPointContents( const vec3_t point, int passEntityNum )
+{
+  return CM_PointContents( point, 0 );
+}
+
+/*
+===================
+Svcmd_PmoveBench_f
+
+Streams that aren't there yet are written from G_PmoveScript first, so the
+cgame can replay the same ones.  The streams are loaded where pmoverecord
+records, so this waits for a recording to be stopped.
+===================
+*/
+static void Svcmd_PmoveBench_f( void )
+{
+  bg_collision_funcs_t world;
+  pmoveReplayResult_t  result;
+  char                 buffer[ MAX_TOKEN_CHARS ];
+  char                 name[ MAX_QPATH ];
+  int                  runs, i, first;
+
+  Cmd_ArgvBuffer( 1, buffer, sizeof( buffer ) );
+  if( Cmd_Argc( ) > 1 && !Q_isanumber( buffer ) )
+  {
+    Com_Printf( "usage: pmovebench [runs] [stream ...]\n" );
+    return;
+  }
+
+  if( pmoveRecordClient >= 0 )
+  {
+    Com_Printf( "pmovebench: stop the recording with pmoverecord first\n" );
+    return;
+  }
+
+  runs = Cmd_Argc( ) > 1 ? atoi( buffer ) : 10;
+  if( runs < 1 )
+    runs = 1;
+
+  Com_Memset( &world, 0, sizeof( world ) );
+  world.trace = G_PmoveBenchTrace;
+  world.pointcontents = G_PmoveBenchPointContents;
+
+  first = Cmd_Argc( ) > 2 ? 2 : 0;
+  for( i = first; i < ( first ? Cmd_Argc( ) : ARRAY_LEN( pmoveScripts ) ); i++ )
+  {
+    if( first )
+      Cmd_ArgvBuffer( i, name, sizeof( name ) );
+    else
+      Q_strncpyz( name, pmoveScripts[ i ].name, sizeof( name ) );
+
+    if( !BG_PmoveReplayLoad( name, &pmoveReplay ) )
+    {
+      if( !G_PmoveScript( name, &pmoveReplay ) )
+      {
+        Com_Printf( "no pmove/%s.pmr\n", name );
+        continue;
+      }
+      BG_PmoveReplaySave( name, &pmoveReplay );
+    }
+
+    if( !pmoveReplay.header.numCmds )
+      continue;
+
+    BG_PmoveReplay( &pmoveReplay, &world, runs, Sys_Milliseconds, &result );
+
+    Com_Printf( "%-12s %6d pmoves %8.0f ns/pmove %6.2f traces/pmove %6.2f contents/pmove "
+      "hash %08x end ( %.3f %.3f %.3f )\n", name, result.pmoves,
+      result.msec * 1000000.0 / result.pmoves,
+      (float)result.traces / result.pmoves, (float)result.pointContents / result.pmoves,
+      result.hash, result.origin[ 0 ], result.origin[ 1 ], result.origin[ 2 ] );
+  }
+}
+
+#ifdef BENCHMARKS
+#define LIST_BENCH_LENGTH MAX_CLIENTS
+
+/*
+===================
+Svcmd_ListBench_f
+
+Times a bglist_t against a bgvector_t and a bgdeque_t holding client
+pointers the way the spawn queues do: filling the container and emptying it
+again by removing every element by value, walking it, and finding the
+position of every element
+===================
+*/
+static void Svcmd_ListBench_f( void )
+{
+  static const char *containers[ ] = { "bglist", "bgvector", "bgdeque" };
+  static const char *phases[ ] = { "churn", "iterate", "index" };
+  bglist_t          list = BG_LIST_INIT;
+  bgvector_t        vector = BG_VECTOR_INIT( gclient_t * );
+  bgdeque_t         deque = BG_DEQUE_INIT( gclient_t * );
+  gclient_t         *clients[ LIST_BENCH_LENGTH ];
+  gclient_t         **slot;
+  bglink_t          *link;
+  char              buffer[ MAX_TOKEN_CHARS ];
+  int               msec[ ARRAY_LEN( containers ) ][ ARRAY_LEN( phases ) ];
+  int               sum[ ARRAY_LEN( containers ) ];
+  int               runs, run, c, p, i;
+
+  Cmd_ArgvBuffer( 1, buffer, sizeof( buffer ) );
+  if( Cmd_Argc( ) > 1 && !Q_isanumber( buffer ) )
+  {
+    Com_Printf( "usage: listbench [runs]\n" );
+    return;
+  }
+
+  runs = Cmd_Argc( ) > 1 ? atoi( buffer ) : 20000;
+  if( runs < 1 )
+    runs = 1;
+
+  // queue order isn't client order
+  for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+    clients[ i ] = &level.clients[ ( i * 37 ) % LIST_BENCH_LENGTH ];
+
+  Com_Memset( sum, 0, sizeof( sum ) );
+
+  // bglist
+  msec[ 0 ][ 0 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_List_Push_Tail( &list, clients[ i ] );
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_List_Remove_All( &list, clients[ i ] );
+  }
+  msec[ 0 ][ 0 ] = Sys_Milliseconds( ) - msec[ 0 ][ 0 ];
+
+  for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+    BG_List_Push_Tail( &list, clients[ i ] );
+
+  msec[ 0 ][ 1 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( link = list.head; link; link = link->next )
+      sum[ 0 ] += ( (gclient_t *)link->data ) - level.clients;
+  }
+  msec[ 0 ][ 1 ] = Sys_Milliseconds( ) - msec[ 0 ][ 1 ];
+
+  msec[ 0 ][ 2 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      sum[ 0 ] += BG_List_Index( &list, clients[ i ] );
+  }
+  msec[ 0 ][ 2 ] = Sys_Milliseconds( ) - msec[ 0 ][ 2 ];
+
+  BG_List_Clear( &list );
+
+  // bgvector
+  msec[ 1 ][ 0 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_Vector_Push_Tail( &vector, &clients[ i ] );
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_Vector_Remove_All( &vector, &clients[ i ] );
+  }
+  msec[ 1 ][ 0 ] = Sys_Milliseconds( ) - msec[ 1 ][ 0 ];
+
+  for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+    BG_Vector_Push_Tail( &vector, &clients[ i ] );
+
+  msec[ 1 ][ 1 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    BG_Vector_Foreach( &vector, gclient_t *, slot )
+      sum[ 1 ] += *slot - level.clients;
+  }
+  msec[ 1 ][ 1 ] = Sys_Milliseconds( ) - msec[ 1 ][ 1 ];
+
+  msec[ 1 ][ 2 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      sum[ 1 ] += BG_Vector_Index( &vector, &clients[ i ] );
+  }
+  msec[ 1 ][ 2 ] = Sys_Milliseconds( ) - msec[ 1 ][ 2 ];
+
+  BG_Vector_Clear( &vector );
+
+  // bgdeque
+  msec[ 2 ][ 0 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_Deque_Push_Tail( &deque, &clients[ i ] );
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      BG_Deque_Remove_All( &deque, &clients[ i ] );
+  }
+  msec[ 2 ][ 0 ] = Sys_Milliseconds( ) - msec[ 2 ][ 0 ];
+
+  for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+    BG_Deque_Push_Tail( &deque, &clients[ i ] );
+
+  msec[ 2 ][ 1 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    BG_Deque_Foreach( &deque, gclient_t *, slot, p )
+      sum[ 2 ] += *slot - level.clients;
+  }
+  msec[ 2 ][ 1 ] = Sys_Milliseconds( ) - msec[ 2 ][ 1 ];
+
+  msec[ 2 ][ 2 ] = Sys_Milliseconds( );
+  for( run = 0; run < runs; run++ )
+  {
+    for( i = 0; i < LIST_BENCH_LENGTH; i++ )
+      sum[ 2 ] += BG_Deque_Index( &deque, &clients[ i ] );
+  }
+  msec[ 2 ][ 2 ] = Sys_Milliseconds( ) - msec[ 2 ][ 2 ];
+
+  BG_Deque_Clear( &deque );
+
+  Com_Printf( "%d runs of %d clients, ns per element\n", runs, LIST_BENCH_LENGTH );
+  for( c = 0; c < ARRAY_LEN( containers ); c++ )
+  {
+    Com_Printf( "%-9s", containers[ c ] );
+    for( p = 0; p < ARRAY_LEN( phases ); p++ )
+    {
+      Com_Printf( " %s %8.2f", phases[ p ],
+        msec[ c ][ p ] * 1000000.0 / ( (double)runs * LIST_BENCH_LENGTH ) );
+    }
+    Com_Printf( "%s\n", sum[ c ] == sum[ 0 ] ? "" : S_COLOR_RED " differs from bglist" );
+  }
+}
+#endif
+
+#if defined( BENCHMARKS ) && !defined( Q3_VM )
+#define ALLOC_STRESS_WORDS      8
+#define ALLOC_STRESS_CHUNKS     4096
+#define ALLOC_STRESS_HELD       64
+#define ALLOC_STRESS_MAX_THREADS 32
+
+allocator_mt_protos( allocStress )
+allocator_mt( allocStress, ALLOC_STRESS_WORDS * sizeof( int ), ALLOC_STRESS_CHUNKS )
+
+typedef struct
+{
+  int ops;
+  int seed;
+  int failures;
+} allocStressThread_t;
+
+/*
+===================
+G_AllocStressThread
+
+Allocates and frees chunks in a random order, filling every chunk it gets
+with a pattern of its own and checking the pattern is still there when it
+frees it, which it wouldn't be if another thread had been given the same
+chunk
+===================
+*/
+static void G_AllocStressThread( void *arg )
+{
+  allocStressThread_t *thread = arg;
+  int                 *held[ ALLOC_STRESS_HELD ];
+  int                 heldTag[ ALLOC_STRESS_HELD ];
+  int                 numHeld = 0;
+  unsigned int        seed = thread->seed;
+  int                 i, j, k;
+
+  for( i = 0; i < thread->ops || numHeld; i++ )
+  {
+    seed = seed * 1103515245 + 12345;
+
+    if( i < thread->ops && numHeld < ALLOC_STRESS_HELD &&
+        ( !numHeld || ( seed >> 16 ) & 1 ) )
+    {
+      held[ numHeld ] = alloc_allocStress( __FILE__, __LINE__ );
+      heldTag[ numHeld ] = ( thread->seed << 20 ) ^ i;
+      for( j = 0; j < ALLOC_STRESS_WORDS; j++ )
+        held[ numHeld ][ j ] = heldTag[ numHeld ];
+      numHeld++;
+      continue;
+    }
+
+    k = ( seed >> 8 ) % numHeld;
+    for( j = 0; j < ALLOC_STRESS_WORDS; j++ )
+    {
+      if( held[ k ][ j ] != heldTag[ k ] )
+      {
+        thread->failures++;
+        break;
+      }
+    }
+
+    free_allocStress( held[ k ], __FILE__, __LINE__ );
+    numHeld--;
+    held[ k ] = held[ numHeld ];
+    heldTag[ k ] = heldTag[ numHeld ];
+  }
+
+  flushCache_allocStress( );
+}
+
+/*
+===================
+Svcmd_AllocStress_f
+
+Hammers an allocator_mt() pool from several threads at once, then checks
+that every chunk made it back to the shared free stack exactly once
+===================
+*/
+static void Svcmd_AllocStress_f( void )
+{
+  allocStressThread_t threads[ ALLOC_STRESS_MAX_THREADS ];
+  void                *handles[ ALLOC_STRESS_MAX_THREADS ];
+  static qboolean     seen[ ALLOC_STRESS_CHUNKS ];
+  char                buffer[ MAX_TOKEN_CHARS ];
+  int                 numThreads, ops, failures, chunks, chunk, i, msec;
+
+  Cmd_ArgvBuffer( 1, buffer, sizeof( buffer ) );
+  numThreads = Cmd_Argc( ) > 1 ? atoi( buffer ) : Sys_ProcessorCount( );
+  Cmd_ArgvBuffer( 2, buffer, sizeof( buffer ) );
+  ops = Cmd_Argc( ) > 2 ? atoi( buffer ) : 1000000;
+
+  if( numThreads < 1 || ops < 1 )
+  {
+    Com_Printf( "usage: allocstress [threads] [ops per thread]\n" );
+    return;
+  }
+  if( numThreads > ALLOC_STRESS_MAX_THREADS )
+    numThreads = ALLOC_STRESS_MAX_THREADS;
+
+  initPool_allocStress( __FILE__, __LINE__ );
+
+  msec = Sys_Milliseconds( );
+  for( i = 0; i < numThreads; i++ )
+  {
+    threads[ i ].ops = ops;
+    threads[ i ].seed = i + 1;
+    threads[ i ].failures = 0;
+    handles[ i ] = Sys_CreateThread( G_AllocStressThread, &threads[ i ] );
+    if( !handles[ i ] )
+    {
+      Com_Printf( S_COLOR_YELLOW "WARNING: couldn't start thread %d\n", i );
+      numThreads = i;
+      break;
+    }
+  }
+
+  failures = 0;
+  for( i = 0; i < numThreads; i++ )
+  {
+    Sys_JoinThread( handles[ i ] );
+    failures += threads[ i ].failures;
+  }
+  msec = Sys_Milliseconds( ) - msec;
+
+  // walk the shared stack, every chunk should be on it once
+  Com_Memset( seen, 0, sizeof( seen ) );
+  chunks = 0;
+  for( chunk = (int)( head_allocStress & 0xFFFFFFFF ) - 1;
+       chunk >= 0 && chunks <= ALLOC_STRESS_CHUNKS;
+       chunk = next_allocStress[ chunk ] )
+  {
+    if( seen[ chunk ] )
+      failures++;
+    seen[ chunk ] = qtrue;
+    chunks++;
+  }
+  if( chunks != ALLOC_STRESS_CHUNKS ||
+      unused_memory_chunks_allocStress( ) != ALLOC_STRESS_CHUNKS )
+    failures++;
+
+  Com_Printf( "%d threads, %d allocs and frees each in %d msec (%.0f ns per pair), %s\n",
+    numThreads, ops, msec, msec * 1000000.0 / ( (double)numThreads * ops ),
+    failures ? va( S_COLOR_RED "%d failures", failures ) : "no failures" );
+  memoryInfo_allocStress( );
+}
+#endif
+
 struct svcmd
 {
   char     *cmd;
@@ -612,6 +1249,9 @@ struct svcmd
   { "admitDefeat", qfalse, Svcmd_AdmitDefeat_f },
   { "advanceMapRotation", qfalse, Svcmd_G_AdvanceMapRotation_f },
   { "alienWin", qfalse, Svcmd_TeamWin_f },
+#if defined( BENCHMARKS ) && !defined( Q3_VM )
+  { "allocstress", qfalse, Svcmd_AllocStress_f },
+#endif
   { "chat", qtrue, Svcmd_MessageWrapper },
   { "dumpuser", qfalse, Svcmd_DumpUser_f },
   { "eject", qfalse, Svcmd_EjectClient_f },
@@ -624,10 +1264,15 @@ struct svcmd
   { "humanWin", qfalse, Svcmd_TeamWin_f },
   { "layoutLoad", qfalse, Svcmd_LayoutLoad_f },
   { "layoutSave", qfalse, Svcmd_LayoutSave_f },
+#ifdef BENCHMARKS
+  { "listbench", qfalse, Svcmd_ListBench_f },
+#endif
   { "listmaps", qtrue, Svcmd_ListMapsWrapper },
   { "loadcensors", qfalse, G_LoadCensors },
   { "m", qtrue, Svcmd_MessageWrapper },
   { "mapRotation", qfalse, Svcmd_MapRotation_f },
+  { "pmovebench", qfalse, Svcmd_PmoveBench_f },
+  { "pmoverecord", qfalse, Svcmd_PmoveRecord_f },
   { "pr", qfalse, Svcmd_Pr_f },
   { "printqueue", qfalse, Svcmd_PrintQueue_f },
   { "say", qtrue, Svcmd_MessageWrapper },
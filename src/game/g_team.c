@@ -182,8 +182,8 @@ void G_LeaveTeam( gentity_t *self )
   
   self->client->ps.persistant[ PERS_STATE ] &= ~PS_QUEUED;
   self->client->spawnReady = qfalse;
-  BG_List_Remove_All(
-    &level.spawn_queue[self->client->ps.stats[STAT_TEAM]], self->client);
+  BG_Deque_Remove_All(
+    &level.spawn_queue[self->client->ps.stats[STAT_TEAM]], &self->client);
 
   if( team == TEAM_NONE )
   {
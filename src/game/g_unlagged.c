@@ -94,6 +94,13 @@ typedef struct unlagged_data_s {
   unlagged_t                   calc;
 } unlagged_data_t;
 
+//entities linked for storage this frame, last linked first.  Kept in the
+//frame arena.
+typedef struct unlagged_store_link_s {
+  gentity_t                    *ent;
+  struct unlagged_store_link_s *next;
+} unlagged_store_link_t;
+
 typedef struct rewind_ent_adjustment_s {
   qboolean use;
   vec3_t   move;
@@ -104,10 +111,10 @@ static unlagged_data_t     unlagged_data[ENTITYNUM_MAX_NORMAL];
 static unlagged_data_t     *unlagged_data_head;
 static int                 history_wheel_times[MAX_UNLAGGED_HISTORY_WHEEL_FRAMES];
 static int                 current_history_frame;
-static bglist_t           dims_store_list = BG_LIST_INIT;
-static bglist_t           origin_store_list = BG_LIST_INIT;
-static bglist_t           pos_store_list = BG_LIST_INIT;
-static bglist_t           apos_store_list = BG_LIST_INIT;
+static unlagged_store_link_t *dims_store_list;
+static unlagged_store_link_t *origin_store_list;
+static unlagged_store_link_t *pos_store_list;
+static unlagged_store_link_t *apos_store_list;
 static rewind_ent_adjustment_t rewind_ents_adjustments[ENTITYNUM_MAX_NORMAL];
 
 /*
@@ -124,10 +131,7 @@ void G_Init_Unlagged(void) {
   memset(&unlagged_data, 0, sizeof(unlagged_data));
   memset(rewind_ents_adjustments, 0, sizeof(rewind_ents_adjustments));
   memset(frame_usage, 0, sizeof(frame_usage));
-  BG_List_Clear(&dims_store_list);
-  BG_List_Clear(&origin_store_list);
-  BG_List_Clear(&pos_store_list);
-  BG_List_Clear(&apos_store_list);
+  dims_store_list = origin_store_list = pos_store_list = apos_store_list = NULL;
 }
 
 /*
@@ -138,14 +142,21 @@ void G_Init_Unlagged(void) {
 ==============
 */
 void G_Unlagged_Prepare_Store(void) { 
-  if(!g_unlagged.integer) {
-    return;
-  }
+  //the links of the last frame went with the frame arena
+  dims_store_list = origin_store_list = pos_store_list = apos_store_list = NULL;
+}
 
-  BG_List_Clear(&dims_store_list);
-  BG_List_Clear(&origin_store_list);
-  BG_List_Clear(&pos_store_list);
-  BG_List_Clear(&apos_store_list);
+/*
+==============
+ G_Unlagged_Link
+==============
+*/
+static void G_Unlagged_Link(unlagged_store_link_t **list, gentity_t *ent) {
+  unlagged_store_link_t *link = BG_FrameAlloc(sizeof(*link));
+
+  link->ent = ent;
+  link->next = *list;
+  *list = link;
 }
 
 /*
@@ -177,19 +188,19 @@ void G_Unlagged_Link_To_Store_Data(
   }
 
   if(dims) {
-    BG_List_Push_Head(&dims_store_list, ent);
+    G_Unlagged_Link(&dims_store_list, ent);
   }
 
   if(pos) {
-    BG_List_Push_Head(&pos_store_list, ent);
+    G_Unlagged_Link(&pos_store_list, ent);
   }
 
   if(apos) {
-    BG_List_Push_Head(&apos_store_list, ent);
+    G_Unlagged_Link(&apos_store_list, ent);
   }
 
   if(origin) {
-    BG_List_Push_Head(&origin_store_list, ent);
+    G_Unlagged_Link(&origin_store_list, ent);
   }
 }
 
@@ -198,8 +209,7 @@ void G_Unlagged_Link_To_Store_Data(
  G_Unlagged_Store_Dimensions
 ==============
 */
-static void G_Unlagged_Store_Dimensions(void *data, void *user_data) {
-  gentity_t                *ent = (gentity_t *)data;
+static void G_Unlagged_Store_Dimensions(gentity_t *ent) {
   unlagged_history_frame_t *save;
 
   Com_Assert(ent && "G_Unlagged_Store_Dimensions: ent is NULL");
@@ -218,8 +228,7 @@ static void G_Unlagged_Store_Dimensions(void *data, void *user_data) {
  G_Unlagged_Store_Origin
 ==============
 */
-static void G_Unlagged_Store_Origin(void *data, void *user_data) {
-  gentity_t                *ent = (gentity_t *)data;
+static void G_Unlagged_Store_Origin(gentity_t *ent) {
   unlagged_history_frame_t *save;
 
   Com_Assert(ent && "G_Unlagged_Store_Origin: ent is NULL");
@@ -314,8 +323,7 @@ static qboolean G_SaveTrajectory(
  G_Unlagged_Store_pos
 ==============
 */
-static void G_Unlagged_Store_pos(void *data, void *user_data) {
-  gentity_t *ent = (gentity_t *)data;
+static void G_Unlagged_Store_pos(gentity_t *ent) {
   unlagged_history_frame_t *save;
   unlagged_data_t          *data_for_ent;
 
@@ -338,8 +346,7 @@ static void G_Unlagged_Store_pos(void *data, void *user_data) {
  would have their pos trajectory changed
 ==============
 */
-static void G_Unlagged_Store_apos(void *data, void *user_data) {
-  gentity_t *ent = (gentity_t *)data;
+static void G_Unlagged_Store_apos(gentity_t *ent) {
   unlagged_history_frame_t *save;
   unlagged_data_t          *data_for_ent;
 
@@ -364,6 +371,8 @@ storage.
 ==============
 */
 void G_UnlaggedStore( void ) {
+  unlagged_store_link_t *link;
+
   if(!g_unlagged.integer) {
     return;
   }
@@ -381,10 +390,18 @@ void G_UnlaggedStore( void ) {
     0,
     sizeof(frame_usage[current_history_frame]));
 
-  BG_List_Foreach(&dims_store_list, NULL, G_Unlagged_Store_Dimensions, NULL);
-  BG_List_Foreach(&origin_store_list, NULL, G_Unlagged_Store_Origin, NULL);
-  BG_List_Foreach(&pos_store_list, NULL, G_Unlagged_Store_pos, NULL);
-  BG_List_Foreach(&apos_store_list, NULL, G_Unlagged_Store_apos, NULL);
+  for(link = dims_store_list; link; link = link->next) {
+    G_Unlagged_Store_Dimensions(link->ent);
+  }
+  for(link = origin_store_list; link; link = link->next) {
+    G_Unlagged_Store_Origin(link->ent);
+  }
+  for(link = pos_store_list; link; link = link->next) {
+    G_Unlagged_Store_pos(link->ent);
+  }
+  for(link = apos_store_list; link; link = link->next) {
+    G_Unlagged_Store_apos(link->ent);
+  }
 }
 
 /*
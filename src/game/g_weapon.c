@@ -1417,7 +1417,7 @@ void G_DeleteZapData( void *data )
 {
   zap_t *zapData = (zap_t *)data;
 
-  BG_List_Clear_Full_Forced( &zapData->targetQueue, BG_FreePassed );
+  BG_Vector_Clear( &zapData->targetQueue );
 
   BG_Free( zapData );
 }
@@ -1430,7 +1430,7 @@ G_FindLev2ZapChainTargets
 static void G_FindLev2ZapChainTargets( zap_t *zap )
 {
   gentity_t *ent =
-            ((zapTarget_t *)BG_List_Peek_Head( &zap->targetQueue ))->targetEnt; // the source
+            BG_Vector_At( &zap->targetQueue, zapTarget_t, 0 ).targetEnt; // the source
   int       entityList[ MAX_GENTITIES ];
   vec3_t    range = { LEVEL2_AREAZAP_CHAIN_RANGE,
                       LEVEL2_AREAZAP_CHAIN_RANGE,
@@ -1474,13 +1474,11 @@ static void G_FindLev2ZapChainTargets( zap_t *zap )
       {
         zapTarget_t *zapTarget;
 
-        zapTarget = BG_Alloc( sizeof(zapTarget_t) );
+        zapTarget = BG_Vector_Push_Tail( &zap->targetQueue, NULL );
         zapTarget->targetEnt = enemy;
         zapTarget->distance = distance;
-        BG_List_Push_Tail( &zap->targetQueue, zapTarget );
 
-        if( BG_List_Get_Length( &zap->targetQueue ) >=
-                                                    LEVEL2_AREAZAP_MAX_TARGETS )
+        if( zap->targetQueue.length >= LEVEL2_AREAZAP_MAX_TARGETS )
           return;
       }
     }
@@ -1506,12 +1504,8 @@ static void G_UpdateZapEffect( zap_t *zap )
 G_DamageLev2ZapTarget
 ===============
 */
-static void G_DamageLev2ZapTarget( void *data, void *user_data )
+static void G_DamageLev2ZapTarget( zapTarget_t *target, zap_t *zap )
 {
-  zapTarget_t *target = (zapTarget_t *)data;
-  zap_t *zap = (zap_t *)user_data;
-
-
   G_Damage( target->targetEnt, target->targetEnt, zap->creator, forward,
             target->targetEnt->r.currentOrigin, LEVEL2_AREAZAP_DMG *
             ( 1 - pow( ( target->distance / LEVEL2_AREAZAP_CHAIN_RANGE ),
@@ -1527,6 +1521,7 @@ static void G_CreateNewZap( gentity_t *creator, gentity_t *targetEnt )
 {
   zap_t   *zap = BG_Alloc0( sizeof( zap_t ) );
   zapTarget_t *primaryZapTarget;
+  int     i;
 
   // add the newly created zap to the lev2ZapList
   lev2ZapList = zap->zapLink = BG_Link_Prepend( lev2ZapList, zap );
@@ -1534,11 +1529,11 @@ static void G_CreateNewZap( gentity_t *creator, gentity_t *targetEnt )
   // initialize the zap
   zap->timeToLive = LEVEL2_AREAZAP_TIME;
   zap->creator = creator;
-  BG_List_Init( &zap->targetQueue );
-  primaryZapTarget = BG_Alloc( sizeof(zapTarget_t) );
+  BG_Vector_Init( &zap->targetQueue, sizeof( zapTarget_t ) );
+  BG_Vector_Reserve( &zap->targetQueue, LEVEL2_AREAZAP_MAX_TARGETS );
+  primaryZapTarget = BG_Vector_Push_Tail( &zap->targetQueue, NULL );
   primaryZapTarget->targetEnt = targetEnt;
   primaryZapTarget->distance  = 0;
-  BG_List_Push_Head( &zap->targetQueue, primaryZapTarget );
 
   // the zap chains only through living entities
   if( targetEnt->health > 0 )
@@ -1550,8 +1545,8 @@ static void G_CreateNewZap( gentity_t *creator, gentity_t *targetEnt )
               DAMAGE_NO_KNOCKBACK | DAMAGE_NO_LOCDAMAGE,
               MOD_LEVEL2_ZAP );
 
-    BG_Link_Foreach( BG_List_Peek_Head_Link( &zap->targetQueue )->next,
-                     G_DamageLev2ZapTarget, zap );
+    for( i = 1; i < zap->targetQueue.length; i++ )
+      G_DamageLev2ZapTarget( &BG_Vector_At( &zap->targetQueue, zapTarget_t, i ), zap );
   }
 
   // create and initialize the zap's effectChannel
@@ -1571,8 +1566,7 @@ static void G_UpdateLev2Zap( void *data, void *user_data )
 {
   zap_t *zap = (zap_t *)data;
   zapTarget_t *primaryTarget =
-              (zapTarget_t *)BG_List_Peek_Head_Link( &zap->targetQueue )->data;
-  bglink_t    *targetZapLink = BG_List_Peek_Head_Link( &zap->targetQueue )->next;
+              &BG_Vector_At( &zap->targetQueue, zapTarget_t, 0 );
   int j;
 
 
@@ -1590,17 +1584,12 @@ static void G_UpdateLev2Zap( void *data, void *user_data )
   }
 
   // the deconstruction or gibbing of chained buildables destroy the appropriate beams
-  for( j = 1; targetZapLink; j++ )
+  for( j = 1; j < zap->targetQueue.length; )
   {
-    bglink_t *next = targetZapLink->next;
-
-    if( !((zapTarget_t *)targetZapLink->data)->targetEnt->inuse )
-      {
-        BG_Free( targetZapLink->data );
-        BG_List_Delete_Link(targetZapLink);
-      }
-
-      targetZapLink = next;
+    if( !BG_Vector_At( &zap->targetQueue, zapTarget_t, j ).targetEnt->inuse )
+      BG_Vector_Remove_Index( &zap->targetQueue, j );
+    else
+      j++;
   }
 
   G_UpdateZapEffect( zap );
@@ -1624,8 +1613,7 @@ void G_ClearPlayerLev2ZapEffects( void *data, void *user_data )
 {
   zap_t *zap = (zap_t *)data;
   zapTarget_t *primaryTarget =
-              (zapTarget_t *)BG_List_Peek_Head_Link( &zap->targetQueue )->data;
-  bglink_t    *targetZapLink = BG_List_Peek_Head_Link( &zap->targetQueue )->next;
+              &BG_Vector_At( &zap->targetQueue, zapTarget_t, 0 );
   gentity_t *player = (gentity_t *)user_data;
   int       j;
 
@@ -1639,17 +1627,12 @@ void G_ClearPlayerLev2ZapEffects( void *data, void *user_data )
   }
 
   // the disappearance of chained players destroy the appropriate beams
-  for( j = 1; targetZapLink; j++ )
+  for( j = 1; j < zap->targetQueue.length; )
   {
-    bglink_t *next = targetZapLink->next;
-
-    if( ((zapTarget_t *)targetZapLink->data)->targetEnt == player )
-      {
-        BG_Free( targetZapLink->data );
-        BG_List_Delete_Link(targetZapLink);
-      }
-
-      targetZapLink = next;
+    if( BG_Vector_At( &zap->targetQueue, zapTarget_t, j ).targetEnt == player )
+      BG_Vector_Remove_Index( &zap->targetQueue, j );
+    else
+      j++;
   }
 }
 
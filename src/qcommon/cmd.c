@@ -345,7 +345,9 @@ void Cmd_Echo_f (void)
 typedef struct cmd_function_s
 {
 	struct cmd_function_s	*next;
+	struct cmd_function_s	*hashNext;
 	char			*name;
+	unsigned int	hashValue;
 	xcommand_t		function;
 	completionFunc_t	complete;	
 } cmd_function_t;
@@ -355,7 +357,7 @@ typedef struct cmdContext_s
 {
 	int		argc;
 	char	*argv[ MAX_STRING_TOKENS ];	// points into cmd.tokenized
-	char	tokenized[ BIG_INFO_STRING + MAX_STRING_TOKENS ];	// will have 0 bytes inserted
+	char	tokenized[ BIG_INFO_STRING ];	// copy of cmd with 0 bytes inserted
 	char	cmd[ BIG_INFO_STRING ]; // the original command we received (no token processing)
 } cmdContext_t;
 
@@ -363,6 +365,9 @@ static cmdContext_t		cmd;
 static cmdContext_t		savedCmd;
 static cmd_function_t	*cmd_functions;		// possible commands to execute
 
+#define CMD_HASH_SIZE	512
+static cmd_function_t	*cmd_hashTable[ CMD_HASH_SIZE ];
+
 /*
 ============
 Cmd_SaveCmdContext
@@ -417,6 +422,36 @@ void	Cmd_ArgvBuffer( int arg, char *buffer, int bufferLength ) {
 }
 
 
+/*
+============
+Cmd_ArgsFromInto
+
+Joins argv(arg) to argv(argc()-1) with single spaces, truncating
+to fit instead of overrunning buf
+============
+*/
+static char *Cmd_ArgsFromInto( int arg, char *buf, int bufSize ) {
+	int		i, len, used = 0;
+
+	buf[0] = 0;
+	if (arg < 0)
+		arg = 0;
+	for ( i = arg ; i < cmd.argc ; i++ ) {
+		len = strlen( cmd.argv[i] );
+		if ( len > bufSize - 1 - used ) {
+			len = bufSize - 1 - used;
+		}
+		Com_Memcpy( buf + used, cmd.argv[i], len );
+		used += len;
+		if ( i != cmd.argc-1 && used < bufSize - 1 ) {
+			buf[used++] = ' ';
+		}
+	}
+	buf[used] = 0;
+
+	return buf;
+}
+
 /*
 ============
 Cmd_Args
@@ -426,17 +461,8 @@ Returns a single string containing argv(1) to argv(argc()-1)
 */
 char	*Cmd_Args( void ) {
 	static	char		cmd_args[MAX_STRING_CHARS];
-	int		i;
 
-	cmd_args[0] = 0;
-	for ( i = 1 ; i < cmd.argc ; i++ ) {
-		strcat( cmd_args, cmd.argv[i] );
-		if ( i != cmd.argc-1 ) {
-			strcat( cmd_args, " " );
-		}
-	}
-
-	return cmd_args;
+	return Cmd_ArgsFromInto( 1, cmd_args, sizeof( cmd_args ) );
 }
 
 /*
@@ -448,19 +474,8 @@ Returns a single string containing argv(arg) to argv(argc()-1)
 */
 char *Cmd_ArgsFrom( int arg ) {
 	static	char		cmd_args[BIG_INFO_STRING];
-	int		i;
-
-	cmd_args[0] = 0;
-	if (arg < 0)
-		arg = 0;
-	for ( i = arg ; i < cmd.argc ; i++ ) {
-		strcat( cmd_args, cmd.argv[i] );
-		if ( i != cmd.argc-1 ) {
-			strcat( cmd_args, " " );
-		}
-	}
 
-	return cmd_args;
+	return Cmd_ArgsFromInto( arg, cmd_args, sizeof( cmd_args ) );
 }
 
 /*
@@ -506,16 +521,19 @@ char *Cmd_Cmd(void)
 Cmd_TokenizeString
 
 Parses the given string into command line tokens.
-The text is copied to a seperate buffer and 0 characters
-are inserted in the apropriate place, The argv array
-will point into this temporary buffer.
+The text is copied to cmd.cmd and once more, unchanged, to
+cmd.tokenized.  Every token ends on a delimiter that is not part of
+any other token, so 0 characters are written over those in place
+and the argv array points into cmd.tokenized at the same offsets
+the tokens have in the original text.
 ============
 */
 // NOTE TTimo define that to track tokenization issues
 //#define TKN_DBG
 static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 	const char	*text;
-	char	*textOut;
+	char	*out;
+	int		len;
 
 #ifdef TKN_DBG
   // FIXME TTimo blunt hook to try to find the tokenization of userinfo
@@ -529,11 +547,13 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 	if ( !text_in ) {
 		return;
 	}
-	
+
 	Q_strncpyz( cmd.cmd, text_in, sizeof(cmd.cmd) );
+	len = strlen( cmd.cmd );
+	Com_Memcpy( cmd.tokenized, cmd.cmd, len + 1 );
 
-	text = text_in;
-	textOut = cmd.tokenized;
+	text = cmd.cmd;
+	out = cmd.tokenized;
 
 	while ( 1 ) {
 		if ( cmd.argc == MAX_STRING_TOKENS ) {
@@ -571,13 +591,13 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 		// handle quoted strings
     // NOTE TTimo this doesn't handle \" escaping
 		if ( !ignoreQuotes && *text == '"' ) {
-			cmd.argv[cmd.argc] = textOut;
-			cmd.argc++;
 			text++;
+			cmd.argv[cmd.argc] = out + ( text - cmd.cmd );
+			cmd.argc++;
 			while ( *text && *text != '"' ) {
-				*textOut++ = *text++;
+				text++;
 			}
-			*textOut++ = 0;
+			out[ text - cmd.cmd ] = 0;
 			if ( !*text ) {
 				return;		// all tokens parsed
 			}
@@ -586,7 +606,7 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 		}
 
 		// regular token
-		cmd.argv[cmd.argc] = textOut;
+		cmd.argv[cmd.argc] = out + ( text - cmd.cmd );
 		cmd.argc++;
 
 		// skip until whitespace, quote, or command
@@ -604,10 +624,10 @@ static void Cmd_TokenizeString2( const char *text_in, qboolean ignoreQuotes ) {
 				break;
 			}
 
-			*textOut++ = *text++;
+			text++;
 		}
 
-		*textOut++ = 0;
+		out[ text - cmd.cmd ] = 0;
 
 		if ( !*text ) {
 			return;		// all tokens parsed
@@ -634,6 +654,25 @@ void Cmd_TokenizeStringIgnoreQuotes( const char *text_in ) {
 	Cmd_TokenizeString2( text_in, qtrue );
 }
 
+/*
+============
+Cmd_HashName
+
+Case insensitive FNV-1a, matching the Q_stricmp lookups
+============
+*/
+static unsigned int Cmd_HashName( const char *name )
+{
+	unsigned int	hash = 2166136261u;
+
+	while( *name )
+	{
+		hash ^= (unsigned char)tolower( *name++ );
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 /*
 ============
 Cmd_FindCommand
@@ -641,9 +680,11 @@ Cmd_FindCommand
 */
 cmd_function_t *Cmd_FindCommand( const char *cmd_name )
 {
-	cmd_function_t *cmdf;
-	for( cmdf = cmd_functions; cmdf; cmdf = cmdf->next )
-		if( !Q_stricmp( cmd_name, cmdf->name ) )
+	cmd_function_t	*cmdf;
+	unsigned int	hash = Cmd_HashName( cmd_name );
+
+	for( cmdf = cmd_hashTable[ hash & ( CMD_HASH_SIZE - 1 ) ]; cmdf; cmdf = cmdf->hashNext )
+		if( cmdf->hashValue == hash && !Q_stricmp( cmd_name, cmdf->name ) )
 			return cmdf;
 	return NULL;
 }
@@ -668,10 +709,14 @@ void	Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	// use a small malloc to avoid zone fragmentation
 	cmdf = S_Malloc (sizeof(cmd_function_t));
 	cmdf->name = CopyString( cmd_name );
+	cmdf->hashValue = Cmd_HashName( cmd_name );
 	cmdf->function = function;
 	cmdf->complete = NULL;
 	cmdf->next = cmd_functions;
 	cmd_functions = cmdf;
+
+	cmdf->hashNext = cmd_hashTable[ cmdf->hashValue & ( CMD_HASH_SIZE - 1 ) ];
+	cmd_hashTable[ cmdf->hashValue & ( CMD_HASH_SIZE - 1 ) ] = cmdf;
 }
 
 /*
@@ -680,12 +725,10 @@ Cmd_SetCommandCompletionFunc
 ============
 */
 void Cmd_SetCommandCompletionFunc( const char *command, completionFunc_t complete ) {
-	cmd_function_t	*cmdf;
+	cmd_function_t	*cmdf = Cmd_FindCommand( command );
 
-	for( cmdf = cmd_functions; cmdf; cmdf = cmdf->next ) {
-		if( !Q_stricmp( command, cmdf->name ) ) {
-			cmdf->complete = complete;
-		}
+	if( cmdf ) {
+		cmdf->complete = complete;
 	}
 }
 
@@ -695,25 +738,30 @@ Cmd_RemoveCommand
 ============
 */
 void	Cmd_RemoveCommand( const char *cmd_name ) {
-	cmd_function_t	*cmdf, **back;
+	cmd_function_t	*cmdf, **back, **hashBack;
 
-	back = &cmd_functions;
+	hashBack = &cmd_hashTable[ Cmd_HashName( cmd_name ) & ( CMD_HASH_SIZE - 1 ) ];
 	while( 1 ) {
-		cmdf = *back;
+		cmdf = *hashBack;
 		if ( !cmdf ) {
 			// command wasn't active
 			return;
 		}
 		if ( !strcmp( cmd_name, cmdf->name ) ) {
-			*back = cmdf->next;
-			if (cmdf->name) {
-				Z_Free(cmdf->name);
-			}
-			Z_Free (cmdf);
-			return;
+			break;
 		}
-		back = &cmdf->next;
+		hashBack = &cmdf->hashNext;
+	}
+
+	for( back = &cmd_functions; *back != cmdf; back = &(*back)->next ) {
 	}
+
+	*back = cmdf->next;
+	*hashBack = cmdf->hashNext;
+	if (cmdf->name) {
+		Z_Free(cmdf->name);
+	}
+	Z_Free (cmdf);
 }
 
 /*
@@ -765,10 +813,8 @@ void Cmd_CompleteArgument( const char *command, char *args, int argNum ) {
 	if( !cgvm || !VM_Call( cgvm, CG_CONSOLE_COMPLETARGUMENT, argNum ) )
 	  // Call local completion if VM doesn't pick up
 #endif
-	  for( cmdf = cmd_functions; cmdf; cmdf = cmdf->next ) {
-	    if( !Q_stricmp( command, cmdf->name ) && cmdf->complete ) {
-	      cmdf->complete( args, argNum );
-	    }
+	  if( ( cmdf = Cmd_FindCommand( command ) ) && cmdf->complete ) {
+	    cmdf->complete( args, argNum );
 	  }
 }
 
@@ -781,7 +827,7 @@ A complete command line has been parsed, so try to execute it
 ============
 */
 void	Cmd_ExecuteString( const char *text ) {	
-	cmd_function_t	*cmdFunc, **prev;
+	cmd_function_t	*cmdFunc;
 
 	// execute the command line
 	Cmd_TokenizeString( text );		
@@ -790,26 +836,14 @@ void	Cmd_ExecuteString( const char *text ) {
 	}
 
 	// check registered command functions	
-	for ( prev = &cmd_functions ; *prev ; prev = &cmdFunc->next ) {
-		cmdFunc = *prev;
-		if ( !Q_stricmp( cmd.argv[0], cmdFunc->name ) ) {
-			// rearrange the links so that the command will be
-			// near the head of the list next time it is used
-			*prev = cmdFunc->next;
-			cmdFunc->next = cmd_functions;
-			cmd_functions = cmdFunc;
-
-			// perform the action
-			if ( !cmdFunc->function ) {
-				// let the cgame or game handle it
-				break;
-			} else {
-				cmdFunc->function ();
-			}
-			return;
-		}
+	cmdFunc = Cmd_FindCommand( cmd.argv[0] );
+	if ( cmdFunc && cmdFunc->function ) {
+		// perform the action
+		cmdFunc->function ();
+		return;
 	}
-	
+	// otherwise let the cgame or game handle it
+
 	// check cvars
 	if ( Cvar_Command() ) {
 		return;
@@ -861,6 +895,112 @@ void Cmd_List_f (void)
 	Com_Printf ("%i commands\n", i);
 }
 
+/*
+============
+Cmd_Benchmark_f
+
+Times tokenizing a trace of client command traffic, looking up
+argv(0) and joining the arguments the way chat commands do
+============
+*/
+static const char *cmd_benchmarkTrace[ ] = {
+	"say_team \"need heals at the reactor\"",
+	"say \"gg all, rematch?\"",
+	"say \"!kick 5 spamming the chat\"",
+	"say_team \"dretch rushing the node /* not a comment */\"",
+	"callvote map atcs",
+	"callteamvote kick 3",
+	"vote yes",
+	"teamvote no",
+	"team aliens",
+	"class level0",
+	"build eggpod",
+	"itemact medkit",
+	"follownext",
+	"m 3 \"can you build a medi near the arm\"",
+	"vsay_team \"need_healing\"",
+	"userinfo \"\\name\\Granger\\rate\\25000\\snaps\\20\\cl_voip\\1\\handicap\\100\\teamoverlay\\1\"\"",
+	"listplayers",
+	"admintest",
+	"showbans 1",
+	"mute 7",
+	"score",
+	"teamstatus",
+	"buy lasgun",
+	"sell weapons",
+	"donate 50",
+	"ready",
+	"deconstruct 123",
+	"ptrcverify 42",
+	"where",
+	"nextdl"
+};
+
+static void Cmd_Benchmark_f( void )
+{
+	const char	**lines = cmd_benchmarkTrace;
+	char		**fileLines = NULL;
+	char		*text = NULL;
+	int			numLines = ARRAY_LEN( cmd_benchmarkTrace );
+	int			iterations, i, j, start, msec, found = 0;
+	size_t		argLen = 0;
+
+	iterations = Cmd_Argc( ) > 1 ? atoi( Cmd_Argv( 1 ) ) : 20000;
+	if( iterations < 1 )
+		iterations = 1;
+
+	if( Cmd_Argc( ) > 2 )
+	{
+		char *p;
+
+		if( FS_ReadFile( Cmd_Argv( 2 ), (void **)&text ) <= 0 )
+		{
+			Com_Printf( "couldn't read %s\n", Cmd_Argv( 2 ) );
+			return;
+		}
+
+		// one command per line
+		for( numLines = 0, p = text; *p; p++ )
+		{
+			if( *p == '\n' )
+				numLines++;
+		}
+		fileLines = Z_Malloc( ( numLines + 1 ) * sizeof( *fileLines ) );
+		for( numLines = 0, p = text; p && *p; )
+		{
+			fileLines[ numLines++ ] = p;
+			if( ( p = strchr( p, '\n' ) ) != NULL )
+				*p++ = '\0';
+		}
+		lines = (const char **)fileLines;
+	}
+
+	start = Sys_Milliseconds( );
+	for( i = 0; i < iterations; i++ )
+	{
+		for( j = 0; j < numLines; j++ )
+		{
+			Cmd_TokenizeString( lines[ j ] );
+			if( Cmd_FindCommand( Cmd_Argv( 0 ) ) )
+				found++;
+			argLen += strlen( Cmd_Args( ) );
+		}
+	}
+	msec = Sys_Milliseconds( ) - start;
+
+	Com_Printf( "%d commands in %d msec, %.1f ns per command (%d registered, %d arg bytes)\n",
+		iterations * numLines, msec,
+		msec * 1000000.0 / ( (double)iterations * numLines ),
+		found / iterations, (int)( argLen / iterations ) );
+
+	if( fileLines )
+		Z_Free( fileLines );
+	if( text )
+		FS_FreeFile( text );
+
+	Cmd_TokenizeString( NULL );
+}
+
 /*
 ==================
 Cmd_CompleteCfgName
@@ -887,4 +1027,5 @@ void Cmd_Init (void) {
 	Cmd_SetCommandCompletionFunc( "vstr", Cvar_CompleteCvarName );
 	Cmd_AddCommand ("echo",Cmd_Echo_f);
 	Cmd_AddCommand ("wait", Cmd_Wait_f);
+	Cmd_AddCommand ("cmd_benchmark", Cmd_Benchmark_f);
 }
@@ -926,6 +926,19 @@ int Z_AvailableMemory( void ) {
 	return Z_AvailableZoneMemory( mainzone );
 }
 
+static int	zoneAllocations;
+
+/*
+========================
+Z_Allocations
+
+Z_TagMalloc calls so far, for benchmarks
+========================
+*/
+int Z_Allocations( void ) {
+	return zoneAllocations;
+}
+
 /*
 ========================
 Z_Free
@@ -1043,6 +1056,8 @@ void *Z_TagMalloc( int size, int tag ) {
 		Com_Error( ERR_FATAL, "Z_TagMalloc: tried to use a 0 tag" );
 	}
 
+	zoneAllocations++;
+
 	if ( tag == TAG_SMALL ) {
 		zone = smallzone;
 	}
@@ -30,34 +30,93 @@ cvar_t		*cvar_vars = NULL;
 cvar_t		*cvar_cheats;
 int			cvar_modifiedFlags;
 
-#define	MAX_CVARS	2048
 cvar_t		cvar_indexes[MAX_CVARS];
 int			cvar_numIndexes;
 
-#define FILE_HASH_SIZE		256
-static	cvar_t	*hashTable[FILE_HASH_SIZE];
+// open addressing with linear probing, never more than half full
+#define CVAR_HASH_SIZE		( MAX_CVARS * 2 )
+static	cvar_t	*cvar_hashTable[CVAR_HASH_SIZE];
+
+// ring of recently modified cvar handles, see Cvar_ChangedHandles
+#define CVAR_CHANGELOG_SIZE	256
+static	cvarHandle_t	cvar_changeLog[CVAR_CHANGELOG_SIZE];
+static	int				cvar_changeSequence;	// wraps within 0..INT_MAX
 
 /*
 ================
-return a hash value for the filename
+Cvar_HashName
+
+Case insensitive FNV-1a, kept whole in cvar_t so probes
+can skip most string compares
 ================
 */
-static long generateHashValue( const char *fname ) {
-	int		i;
-	long	hash;
-	char	letter;
+static unsigned int Cvar_HashName( const char *name ) {
+	unsigned int	hash = 2166136261u;
 
-	hash = 0;
-	i = 0;
-	while (fname[i] != '\0') {
-		letter = tolower(fname[i]);
-		hash+=(long)(letter)*(i+119);
-		i++;
+	while ( *name ) {
+		hash ^= (unsigned char)tolower( *name++ );
+		hash *= 16777619u;
 	}
-	hash &= (FILE_HASH_SIZE-1);
 	return hash;
 }
 
+/*
+================
+Cvar_HashInsert
+================
+*/
+static void Cvar_HashInsert( cvar_t *var ) {
+	unsigned int	slot;
+
+	for ( slot = var->hashValue & ( CVAR_HASH_SIZE - 1 ); cvar_hashTable[slot];
+		slot = ( slot + 1 ) & ( CVAR_HASH_SIZE - 1 ) ) {
+	}
+	cvar_hashTable[slot] = var;
+}
+
+/*
+================
+Cvar_HashRemove
+
+Backward shift deletion, so lookups never need tombstones
+================
+*/
+static void Cvar_HashRemove( cvar_t *var ) {
+	unsigned int	hole, slot, home;
+
+	for ( hole = var->hashValue & ( CVAR_HASH_SIZE - 1 ); cvar_hashTable[hole] != var;
+		hole = ( hole + 1 ) & ( CVAR_HASH_SIZE - 1 ) ) {
+		if ( !cvar_hashTable[hole] ) {
+			return;
+		}
+	}
+	cvar_hashTable[hole] = NULL;
+
+	for ( slot = ( hole + 1 ) & ( CVAR_HASH_SIZE - 1 ); cvar_hashTable[slot];
+		slot = ( slot + 1 ) & ( CVAR_HASH_SIZE - 1 ) ) {
+		home = cvar_hashTable[slot]->hashValue & ( CVAR_HASH_SIZE - 1 );
+
+		// move it into the hole unless its home lies cyclically in (hole, slot]
+		if ( ( ( slot - home ) & ( CVAR_HASH_SIZE - 1 ) ) >= ( ( slot - hole ) & ( CVAR_HASH_SIZE - 1 ) ) ) {
+			cvar_hashTable[hole] = cvar_hashTable[slot];
+			cvar_hashTable[slot] = NULL;
+			hole = slot;
+		}
+	}
+}
+
+/*
+================
+Cvar_Modified
+================
+*/
+static void Cvar_Modified( cvar_t *var ) {
+	var->modified = qtrue;
+	var->modificationCount++;
+	cvar_changeLog[cvar_changeSequence & ( CVAR_CHANGELOG_SIZE - 1 )] = var - cvar_indexes;
+	cvar_changeSequence = ( cvar_changeSequence + 1 ) & INT_MAX;
+}
+
 /*
 ============
 Cvar_ValidateString
@@ -85,13 +144,14 @@ Cvar_FindVar
 ============
 */
 static cvar_t *Cvar_FindVar( const char *var_name ) {
-	cvar_t	*var;
-	long hash;
+	cvar_t			*var;
+	unsigned int	hash, slot;
 
-	hash = generateHashValue(var_name);
-	
-	for (var=hashTable[hash] ; var ; var=var->hashNext) {
-		if (!Q_stricmp(var_name, var->name)) {
+	hash = Cvar_HashName( var_name );
+
+	for ( slot = hash & ( CVAR_HASH_SIZE - 1 ); ( var = cvar_hashTable[slot] ) != NULL;
+		slot = ( slot + 1 ) & ( CVAR_HASH_SIZE - 1 ) ) {
+		if ( var->hashValue == hash && !Q_stricmp( var_name, var->name ) ) {
 			return var;
 		}
 	}
@@ -311,7 +371,6 @@ The flags will be or'ed in if the variable exists.
 */
 cvar_t *Cvar_Get( const char *var_name, const char *var_value, int flags ) {
 	cvar_t	*var;
-	long	hash;
 	int	index;
 
 	if ( !var_name || ! var_value ) {
@@ -437,8 +496,8 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, int flags ) {
 		
 	var->name = CopyString (var_name);
 	var->string = CopyString (var_value);
-	var->modified = qtrue;
-	var->modificationCount = 1;
+	var->modificationCount = 0;
+	Cvar_Modified( var );
 	var->value = atof (var->string);
 	var->integer = atoi(var->string);
 	var->resetString = CopyString( var_value );
@@ -460,15 +519,8 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, int flags ) {
 		cvar_modifiedFlags |= CVAR_SYSTEMINFO;
 	}
 
-	hash = generateHashValue(var_name);
-	var->hashIndex = hash;
-
-	var->hashNext = hashTable[hash];
-	if(hashTable[hash])
-		hashTable[hash]->hashPrev = var;
-
-	var->hashPrev = NULL;
-	hashTable[hash] = var;
+	var->hashValue = Cvar_HashName( var_name );
+	Cvar_HashInsert( var );
 
 	return var;
 }
@@ -596,8 +648,7 @@ cvar_t *Cvar_Set2( const char *var_name, const char *value, qboolean force ) {
 
 			Com_Printf ("%s will be changed upon restarting.\n", var_name);
 			var->latchedString = CopyString(value);
-			var->modified = qtrue;
-			var->modificationCount++;
+			Cvar_Modified( var );
 			return var;
 		}
 
@@ -620,9 +671,8 @@ cvar_t *Cvar_Set2( const char *var_name, const char *value, qboolean force ) {
 	if (!strcmp(value, var->string))
 		return var;		// not changed
 
-	var->modified = qtrue;
-	var->modificationCount++;
-	
+	Cvar_Modified( var );
+
 	Z_Free (var->string);	// free the old value string
 	
 	var->string = CopyString(value);
@@ -1146,12 +1196,7 @@ cvar_t *Cvar_Unset(cvar_t *cv)
 	if(cv->next)
 		cv->next->prev = cv->prev;
 
-	if(cv->hashPrev)
-		cv->hashPrev->hashNext = cv->hashNext;
-	else
-		hashTable[cv->hashIndex] = cv->hashNext;
-	if(cv->hashNext)
-		cv->hashNext->hashPrev = cv->hashPrev;
+	Cvar_HashRemove( cv );
 
 	Com_Memset(cv, '\0', sizeof(*cv));
 	
@@ -1399,6 +1444,34 @@ void	Cvar_Update( vmCvar_t *vmCvar ) {
 	vmCvar->integer = cv->integer;
 }
 
+/*
+=====================
+Cvar_ChangedHandles
+
+Fills handles with the cvars modified since *sequence and advances it,
+so callers can skip polling every cvar they track each frame.  Returns
+-1 when the caller has to recheck everything instead: on the first call
+(*sequence < 0) or when more cvars changed than the log or handles hold.
+A cvar modified several times may be listed more than once.
+=====================
+*/
+int Cvar_ChangedHandles( int *sequence, cvarHandle_t *handles, int maxHandles ) {
+	int		count, i;
+
+	count = ( cvar_changeSequence - *sequence ) & INT_MAX;
+	if ( *sequence < 0 || count > CVAR_CHANGELOG_SIZE || count > maxHandles ) {
+		*sequence = cvar_changeSequence;
+		return -1;
+	}
+
+	for ( i = 0; i < count; i++ ) {
+		handles[i] = cvar_changeLog[( *sequence + i ) & ( CVAR_CHANGELOG_SIZE - 1 )];
+	}
+	*sequence = cvar_changeSequence;
+
+	return count;
+}
+
 /*
 ==================
 Cvar_CompleteCvarName
@@ -1426,7 +1499,7 @@ Reads in all archived cvars
 void Cvar_Init (void)
 {
 	Com_Memset(cvar_indexes, '\0', sizeof(cvar_indexes));
-	Com_Memset(hashTable, '\0', sizeof(hashTable));
+	Com_Memset(cvar_hashTable, '\0', sizeof(cvar_hashTable));
 
 	cvar_cheats = Cvar_Get("sv_cheats", "1", CVAR_ROM | CVAR_SYSTEMINFO );
 
@@ -34,6 +34,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "q_shared.h"
 #include "qcommon.h"
 #include <minizip/unzip.h>
+#include <zlib.h>
 
 /*
 =============================================================================
@@ -191,6 +192,12 @@ typedef struct fileInPack_s {
 	unsigned long			pos;		// file info position in zip
 	unsigned long			len;		// uncompress file size
 	struct	fileInPack_s*	next;		// next file in the hash
+	struct	fileInPack_s*	indexNext;	// next file in the global index chain
+	struct	pack_s			*pack;		// pak containing this file
+	unsigned int			indexHash;	// full name hash for the global index
+	long					dataOfs;	// offset of the file data in the mapped pak, 0 if unresolved, -1 if unusable
+	unsigned long			csize;		// compressed file size
+	int						method;		// compression method, 0 for stored
 } fileInPack_t;
 
 typedef struct pack_s {
@@ -209,6 +216,12 @@ typedef struct pack_s {
 	qboolean		onlyPrimary;
 	qboolean		onlyAlternate;
 	struct pack_s	*primaryVersion;
+	struct searchpath_s	*search;				// search path holding this pak
+	int				searchOrder;				// position in fs_searchpaths
+	byte			*mapped;					// mapped pak contents, NULL until first mapped read
+	int				mappedSize;
+	int64_t			mappedMtime;				// pak mtime when it was mapped
+	qboolean		mapFailed;
 } pack_t;
 
 typedef struct {
@@ -222,10 +235,124 @@ typedef struct searchpath_s {
 
 	pack_t		*pack;		// only one of pack / dir will be non NULL
 	directory_t	*dir;
+	int			order;		// position in fs_searchpaths, set by FS_BuildFileIndex
 } searchpath_t;
 
+/*
+The global file index chains every file of every loaded pak by the hash of
+its full lower case name. Each chain is kept in search order, so the first
+matching entry of a chain is the one a walk of fs_searchpaths would hit
+first. Directories can not be indexed, so the few directory search paths are
+kept in their own list and only those ordered before the indexed hit are
+probed on disk.
+*/
+typedef struct {
+	fileInPack_t	**table;
+	int				size;			// power of 2
+	searchpath_t	**dirs;			// directory search paths in search order
+	int				numDirs;
+} fileIndex_t;
+
+static fileIndex_t	fs_index;
+
+/*
+Decompressed pak files are kept in a small LRU cache, keyed by pak file
+name, pak checksum and file position so that entries survive FS_Restart.
+*/
+#define INFLATE_CACHE_HASH_SIZE	1024
+
+typedef struct inflateCache_s {
+	struct inflateCache_s	*prev, *next;
+	struct inflateCache_s	*hashNext;
+	char			pakFilename[MAX_OSPATH];
+	int				checksum;
+	unsigned long	pos;
+	int				len;
+	byte			*data;
+} inflateCache_t;
+
+static inflateCache_t	fs_inflateCache = { &fs_inflateCache, &fs_inflateCache };
+static inflateCache_t	*fs_inflateCacheHash[INFLATE_CACHE_HASH_SIZE];
+static int				fs_inflateCacheBytes;
+
+/*
+Pak scanning is split in two: FS_ScanZipFile reads the central directory
+and computes the checksums into a zipScan_t without touching the zone, so
+that it can run on worker threads, then FS_LoadZipScan turns the result
+into a pack_t on the main thread.
+*/
+typedef struct {
+	uint32_t		pos;		// file info position in zip
+	uint32_t		len;		// uncompressed file size
+	uint32_t		crc;
+	uint32_t		nameOfs;	// offset of the lower case name in the names block
+} zipEntry_t;
+
+typedef struct {
+	char			pakFilename[MAX_OSPATH];
+	int64_t			size;		// -1 if the pak couldn't be stat'ed
+	int64_t			mtime;
+	unzFile			handle;
+	int				numEntries;
+	zipEntry_t		*entries;
+	int				namesLen;
+	char			*names;
+	int				checksum;
+	int				pure_checksum;
+	qboolean		fromCache;	// entries and names point into the pak cache
+	qboolean		valid;
+} zipScan_t;
+
+/*
+The pak cache keeps the scanned central directories of all paks found by
+the last FS_Startup in pakcache.dat under the home path, keyed by path,
+size and modification time. Only the checksums, which depend on the
+checksum feed, are computed again for unchanged paks.
+*/
+#define PAK_CACHE_IDENT		(('1'<<24)+('C'<<16)+('K'<<8)+'P')
+#define PAK_CACHE_VERSION	1
+#define PAK_CACHE_HASH_SIZE	1024
+
+typedef struct pakCacheRecord_s {
+	const char		*pakFilename;
+	int64_t			size;
+	int64_t			mtime;
+	int				numEntries;
+	zipEntry_t		*entries;
+	int				namesLen;
+	char			*names;
+	struct pakCacheRecord_s	*hashNext;
+} pakCacheRecord_t;
+
+typedef struct {
+	qboolean			active;		// only between FS_PakCacheLoad and FS_PakCacheSave
+
+	// what was read from disk, never changed while paks are being scanned
+	byte				*data;
+	pakCacheRecord_t	*records;
+	int					numRecords;
+	pakCacheRecord_t	*hash[PAK_CACHE_HASH_SIZE];
+
+	// what will be written back
+	byte				*out;
+	int					outLen;
+	int					outSize;
+	int					numOut;
+	qboolean			dirty;
+} pakCache_t;
+
+static pakCache_t	fs_pakCacheState;
+static int			fs_numCachedPaks;
+static int			fs_numScannedPaks;
+static int			fs_scanMsec;
+
 static	char		fs_gamedir[MAX_OSPATH];	// this will be a single file name with no separators
 static	cvar_t		*fs_debug;
+static	cvar_t		*fs_useIndex;
+static	cvar_t		*fs_mmap;
+static	cvar_t		*fs_inflateCacheSize;
+static	cvar_t		*fs_scanThreads;
+static	cvar_t		*fs_pakCache;
 static	cvar_t		*fs_homepath;
 
 #ifdef MACOS_X
@@ -369,6 +496,393 @@ static long FS_HashFileName( const char *fname, int hashSize ) {
 	return hash;
 }
 
+/*
+================
+FS_IndexHashFileName
+
+Hash of the full file name for the global file index, with the
+same case and separator folding as FS_FilenameCompare
+================
+*/
+static unsigned int FS_IndexHashFileName( const char *fname ) {
+	unsigned int	hash;
+	int				letter;
+
+	hash = 2166136261u;
+	while ( *fname ) {
+		letter = *fname++;
+		if ( letter >= 'a' && letter <= 'z' ) {
+			letter -= ( 'a' - 'A' );
+		}
+		if ( letter == '\\' || letter == ':' ) {
+			letter = '/';
+		}
+		hash = ( hash ^ (unsigned int)letter ) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+================
+FS_FreeFileIndex
+================
+*/
+static void FS_FreeFileIndex( void ) {
+	if ( fs_index.table ) {
+		Z_Free( fs_index.table );
+	}
+	if ( fs_index.dirs ) {
+		Z_Free( fs_index.dirs );
+	}
+	Com_Memset( &fs_index, 0, sizeof( fs_index ) );
+}
+
+/*
+================
+FS_BuildFileIndex
+
+Rebuilds the global file index from fs_searchpaths, this has to be
+done again whenever the search paths are added to or reordered
+================
+*/
+static void FS_BuildFileIndex( void ) {
+	searchpath_t	*search;
+	pack_t			**packs;
+	fileInPack_t	*pakFile;
+	int				numPacks, order, i, j, slot;
+
+	FS_FreeFileIndex();
+
+	numPacks = 0;
+	order = 0;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		search->order = order++;
+		if ( search->pack ) {
+			numPacks++;
+		} else {
+			fs_index.numDirs++;
+		}
+	}
+
+	// two files per slot on average is plenty, the chains compare hashes first
+	for ( fs_index.size = 1 ; fs_index.size * 2 < fs_packFiles ; fs_index.size <<= 1 ) {
+	}
+
+	fs_index.table = Z_Malloc( fs_index.size * sizeof( *fs_index.table ) );
+	fs_index.dirs = Z_Malloc( ( fs_index.numDirs + 1 ) * sizeof( *fs_index.dirs ) );
+	packs = Z_Malloc( ( numPacks + 1 ) * sizeof( *packs ) );
+
+	numPacks = 0;
+	fs_index.numDirs = 0;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			search->pack->search = search;
+			search->pack->searchOrder = search->order;
+			packs[ numPacks++ ] = search->pack;
+		} else {
+			fs_index.dirs[ fs_index.numDirs++ ] = search;
+		}
+	}
+
+	// insert from the lowest priority pak up, so every chain ends up in search order
+	for ( i = numPacks - 1 ; i >= 0 ; i-- ) {
+		for ( j = 0 ; j < packs[ i ]->numfiles ; j++ ) {
+			pakFile = &packs[ i ]->buildBuffer[ j ];
+			if ( !pakFile->name ) {
+				break;
+			}
+			pakFile->pack = packs[ i ];
+			pakFile->indexHash = FS_IndexHashFileName( pakFile->name );
+			slot = pakFile->indexHash & ( fs_index.size - 1 );
+			pakFile->indexNext = fs_index.table[ slot ];
+			fs_index.table[ slot ] = pakFile;
+		}
+	}
+
+	Z_Free( packs );
+}
+
+/*
+================
+FS_UseFileIndex
+================
+*/
+static qboolean FS_UseFileIndex( void ) {
+	return fs_index.table && fs_useIndex && fs_useIndex->integer;
+}
+
+/*
+================
+FS_IndexFindFile
+
+Returns the first pak file named "filename" in search order, or the next
+one after "prev" when it is non NULL
+================
+*/
+static fileInPack_t *FS_IndexFindFile( const char *filename, unsigned int hash, fileInPack_t *prev ) {
+	fileInPack_t	*pakFile;
+
+	if ( prev ) {
+		pakFile = prev->indexNext;
+	} else {
+		pakFile = fs_index.table[ hash & ( fs_index.size - 1 ) ];
+	}
+
+	for ( ; pakFile ; pakFile = pakFile->indexNext ) {
+		if ( pakFile->indexHash == hash && !FS_FilenameCompare( pakFile->name, filename ) ) {
+			return pakFile;
+		}
+	}
+	return NULL;
+}
+
+/*
+================
+FS_ResolvePakFileData
+
+Finds where the data of a pak file starts in the mapped pak by reading the
+central directory record at pakFile->pos and the local header it points to.
+Anything unusual (zip64, encryption, unknown methods) leaves the file to minizip.
+================
+*/
+#define ZIP_LONG( p ) ( (unsigned long)(p)[0] | ( (unsigned long)(p)[1] << 8 ) | \
+                        ( (unsigned long)(p)[2] << 16 ) | ( (unsigned long)(p)[3] << 24 ) )
+#define ZIP_SHORT( p ) ( (unsigned long)(p)[0] | ( (unsigned long)(p)[1] << 8 ) )
+
+static qboolean FS_ResolvePakFileData( fileInPack_t *pakFile ) {
+	pack_t			*pak = pakFile->pack;
+	const byte		*p;
+	unsigned long	localOfs, dataOfs, csize;
+	int				method;
+
+	if ( pakFile->dataOfs ) {
+		return pakFile->dataOfs > 0;
+	}
+	pakFile->dataOfs = -1;
+
+	if ( !pak->mapped ) {
+		int64_t	size = 0;
+
+		if ( pak->mapFailed ) {
+			return qfalse;
+		}
+		if ( Sys_FileStat( pak->pakFilename, &size, &pak->mappedMtime ) ) {
+			pak->mapped = Sys_MapFile( pak->pakFilename, &pak->mappedSize );
+		}
+		if ( pak->mapped && pak->mappedSize != size ) {
+			Sys_UnmapFile( pak->mapped, pak->mappedSize );
+			pak->mapped = NULL;
+		}
+		if ( !pak->mapped ) {
+			pak->mapFailed = qtrue;
+			return qfalse;
+		}
+	}
+
+	// central directory record
+	if ( pakFile->pos + 46 > (unsigned long)pak->mappedSize ) {
+		return qfalse;
+	}
+	p = pak->mapped + pakFile->pos;
+	if ( ZIP_LONG( p ) != 0x02014b50 || ( ZIP_SHORT( p + 8 ) & 1 ) ) {
+		return qfalse;
+	}
+	method = ZIP_SHORT( p + 10 );
+	csize = ZIP_LONG( p + 20 );
+	if ( ZIP_LONG( p + 24 ) != pakFile->len ) {
+		return qfalse;
+	}
+	if ( method != 0 && method != Z_DEFLATED ) {
+		return qfalse;
+	}
+	if ( method == 0 && csize != pakFile->len ) {
+		return qfalse;
+	}
+	localOfs = ZIP_LONG( p + 42 );
+
+	// local file header
+	if ( localOfs + 30 > (unsigned long)pak->mappedSize ) {
+		return qfalse;
+	}
+	p = pak->mapped + localOfs;
+	if ( ZIP_LONG( p ) != 0x04034b50 ) {
+		return qfalse;
+	}
+	dataOfs = localOfs + 30 + ZIP_SHORT( p + 26 ) + ZIP_SHORT( p + 28 );
+	if ( dataOfs + csize > (unsigned long)pak->mappedSize ) {
+		return qfalse;
+	}
+
+	pakFile->method = method;
+	pakFile->csize = csize;
+	pakFile->dataOfs = dataOfs;
+	return qtrue;
+}
+
+/*
+================
+FS_PakMapIsCurrent
+
+A pak that was truncated or rewritten in place since it was mapped would
+fault on the next read, so check that it still matches the mapping and drop
+the mapping for good if it doesn't, leaving the pak to the regular handles.
+================
+*/
+static qboolean FS_PakMapIsCurrent( pack_t *pak ) {
+	int64_t	size, mtime;
+
+	if ( !pak->mapped ) {
+		return !pak->mapFailed;
+	}
+
+	if ( Sys_FileStat( pak->pakFilename, &size, &mtime ) &&
+		size == pak->mappedSize && mtime == pak->mappedMtime ) {
+		return qtrue;
+	}
+
+	Com_DPrintf( "FS_PakMapIsCurrent: %s changed on disk, no longer reading it mapped\n", pak->pakFilename );
+	Sys_UnmapFile( pak->mapped, pak->mappedSize );
+	pak->mapped = NULL;
+	pak->mapFailed = qtrue;
+	return qfalse;
+}
+
+/*
+================
+FS_InflateCacheFree
+================
+*/
+static void FS_InflateCacheFree( inflateCache_t *entry ) {
+	inflateCache_t	**prev;
+
+	for ( prev = &fs_inflateCacheHash[ ( entry->pos ^ entry->checksum ) & ( INFLATE_CACHE_HASH_SIZE - 1 ) ] ;
+	      *prev != entry ; prev = &( *prev )->hashNext ) {
+	}
+	*prev = entry->hashNext;
+
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+	fs_inflateCacheBytes -= entry->len;
+	Z_Free( entry );
+}
+
+/*
+================
+FS_InflateCacheClear
+================
+*/
+static void FS_InflateCacheClear( void ) {
+	while ( fs_inflateCache.next != &fs_inflateCache ) {
+		FS_InflateCacheFree( fs_inflateCache.next );
+	}
+}
+
+/*
+================
+FS_InflateCacheFind
+
+Returns the cached contents of a deflated pak file and moves it to the
+front of the LRU list
+================
+*/
+static inflateCache_t *FS_InflateCacheFind( fileInPack_t *pakFile ) {
+	inflateCache_t	*entry;
+
+	for ( entry = fs_inflateCacheHash[ ( pakFile->pos ^ pakFile->pack->checksum ) & ( INFLATE_CACHE_HASH_SIZE - 1 ) ] ;
+	      entry ; entry = entry->hashNext ) {
+		if ( entry->pos == pakFile->pos && entry->checksum == pakFile->pack->checksum &&
+		     !strcmp( entry->pakFilename, pakFile->pack->pakFilename ) ) {
+			entry->prev->next = entry->next;
+			entry->next->prev = entry->prev;
+			entry->next = fs_inflateCache.next;
+			entry->prev = &fs_inflateCache;
+			entry->next->prev = entry;
+			fs_inflateCache.next = entry;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+================
+FS_InflateCacheAdd
+================
+*/
+static void FS_InflateCacheAdd( fileInPack_t *pakFile, const byte *data ) {
+	inflateCache_t	*entry;
+	int				limit;
+
+	limit = fs_inflateCacheSize->integer * 1024;
+
+	// a single file may not take over the whole cache
+	if ( pakFile->len > limit / 4 ) {
+		return;
+	}
+
+	while ( fs_inflateCacheBytes + pakFile->len > limit && fs_inflateCache.prev != &fs_inflateCache ) {
+		FS_InflateCacheFree( fs_inflateCache.prev );
+	}
+
+	entry = Z_Malloc( sizeof( *entry ) + pakFile->len );
+	Q_strncpyz( entry->pakFilename, pakFile->pack->pakFilename, sizeof( entry->pakFilename ) );
+	entry->checksum = pakFile->pack->checksum;
+	entry->pos = pakFile->pos;
+	entry->len = pakFile->len;
+	entry->data = (byte *)( entry + 1 );
+	Com_Memcpy( entry->data, data, pakFile->len );
+
+	entry->hashNext = fs_inflateCacheHash[ ( entry->pos ^ entry->checksum ) & ( INFLATE_CACHE_HASH_SIZE - 1 ) ];
+	fs_inflateCacheHash[ ( entry->pos ^ entry->checksum ) & ( INFLATE_CACHE_HASH_SIZE - 1 ) ] = entry;
+
+	entry->next = fs_inflateCache.next;
+	entry->prev = &fs_inflateCache;
+	entry->next->prev = entry;
+	fs_inflateCache.next = entry;
+	fs_inflateCacheBytes += entry->len;
+}
+
+/*
+================
+FS_ReadPakFileData
+
+Copies the uncompressed contents of a resolved pak file into buf
+================
+*/
+static qboolean FS_ReadPakFileData( fileInPack_t *pakFile, byte *buf ) {
+	inflateCache_t	*entry;
+	z_stream		stream;
+	int				err;
+
+	if ( pakFile->method == 0 ) {
+		Com_Memcpy( buf, pakFile->pack->mapped + pakFile->dataOfs, pakFile->len );
+		return qtrue;
+	}
+
+	if ( ( entry = FS_InflateCacheFind( pakFile ) ) != NULL ) {
+		Com_Memcpy( buf, entry->data, pakFile->len );
+		return qtrue;
+	}
+
+	Com_Memset( &stream, 0, sizeof( stream ) );
+	if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK ) {
+		return qfalse;
+	}
+	stream.next_in = pakFile->pack->mapped + pakFile->dataOfs;
+	stream.avail_in = pakFile->csize;
+	stream.next_out = buf;
+	stream.avail_out = pakFile->len;
+	err = inflate( &stream, Z_FINISH );
+	inflateEnd( &stream );
+
+	if ( err != Z_STREAM_END || stream.total_out != pakFile->len ) {
+		return qfalse;
+	}
+
+	FS_InflateCacheAdd( pakFile, buf );
+	return qtrue;
+}
+
 static fileHandle_t	FS_HandleForFile(void) {
 	int		i;
 
@@ -1059,6 +1573,42 @@ qboolean FS_IsDemoExt(const char *filename, int namelen)
 	return qfalse;
 }
 
+/*
+================
+FS_ReferencePakFile
+
+Mark the pak as having been referenced and mark specifics on cgame and ui.
+Shaders, txt, arena files by themselves do not count as a reference as
+these are loaded from all pk3s
+================
+*/
+static void FS_ReferencePakFile( pack_t *pak, const char *filename ) {
+	int len;
+
+	len = strlen( filename );
+
+	if ( !( pak->referenced & FS_GENERAL_REF ) ) {
+		if ( !FS_IsExt( filename, ".shader", len ) &&
+		     !FS_IsExt( filename, ".txt", len ) &&
+		     !FS_IsExt( filename, ".cfg", len ) &&
+		     !FS_IsExt( filename, ".config", len ) &&
+		     !FS_IsExt( filename, ".bot", len ) &&
+		     !FS_IsExt( filename, ".arena", len ) &&
+		     !FS_IsExt( filename, ".menu", len ) &&
+		     Q_stricmp( filename, "vm/qagame.qvm" ) != 0 &&
+		     !strstr( filename, "levelshots" ) ) {
+			pak->referenced |= FS_GENERAL_REF;
+		}
+	}
+
+	if ( strstr( filename, "cgame.qvm" ) ) {
+		pak->referenced |= FS_CGAME_REF;
+	}
+	if ( strstr( filename, "ui.qvm" ) ) {
+		pak->referenced |= FS_UI_REF;
+	}
+}
+
 /*
 ===========
 FS_FOpenFileReadDir
@@ -1183,33 +1733,7 @@ long FS_FOpenFileReadDir(const char *filename, searchpath_t *search, fileHandle_
 				if(!FS_FilenameCompare(pakFile->name, filename))
 				{
 					// found it!
-
-					// mark the pak as having been referenced and mark specifics on cgame and ui
-					// shaders, txt, arena files  by themselves do not count as a reference as
-					// these are loaded from all pk3s
-					// from every pk3 file..
-					len = strlen(filename);
-
-					if (!(pak->referenced & FS_GENERAL_REF))
-					{
-						if(!FS_IsExt(filename, ".shader", len) &&
-						   !FS_IsExt(filename, ".txt", len) &&
-						   !FS_IsExt(filename, ".cfg", len) &&
-						   !FS_IsExt(filename, ".config", len) &&
-						   !FS_IsExt(filename, ".bot", len) &&
-						   !FS_IsExt(filename, ".arena", len) &&
-						   !FS_IsExt(filename, ".menu", len) &&
-						   Q_stricmp(filename, "vm/qagame.qvm") != 0 &&
-						   !strstr(filename, "levelshots"))
-						{
-							pak->referenced |= FS_GENERAL_REF;
-						}
-					}
-
-					if(strstr(filename, "cgame.qvm"))
-						pak->referenced |= FS_CGAME_REF;
-					if(strstr(filename, "ui.qvm"))
-						pak->referenced |= FS_UI_REF;
+					FS_ReferencePakFile(pak, filename);
 
 					if(uniqueFILE)
 					{
@@ -1301,37 +1825,100 @@ long FS_FOpenFileReadDir(const char *filename, searchpath_t *search, fileHandle_
 
 /*
 ===========
-FS_FOpenFileRead
+FS_FOpenFileReadIndexed
 
-Finds the file in the search path.
-Returns filesize and an open FILE pointer.
-Used for streaming data out of either a
-separate file or a ZIP file.
+Looks "filename" up in the global file index and only probes the directory
+search paths that come before the first pure pak holding it.
+Returns qfalse if the file was not found.
 ===========
 */
-long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueFILE)
+static qboolean FS_FOpenFileReadIndexed(const char *filename, fileHandle_t *file, qboolean uniqueFILE, long *len)
 {
-	searchpath_t *search;
-	long len;
+	fileInPack_t	*pakFile;
+	searchpath_t	*search;
+	unsigned int	hash;
+	int				i;
 
-	if(!fs_searchpaths)
-		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+	if(filename[0] == '/' || filename[0] == '\\')
+		filename++;
 
-	for(search = fs_searchpaths; search; search = search->next)
+	if(strstr(filename, "..") || strstr(filename, "::"))
+		return qfalse;
+
+	// existence queries don't care about pure paks, see FS_FOpenFileReadDir
+	hash = FS_IndexHashFileName(filename);
+	for(pakFile = FS_IndexFindFile(filename, hash, NULL); pakFile; pakFile = FS_IndexFindFile(filename, hash, pakFile))
 	{
-		len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, qfalse);
+		if(file == NULL || FS_PakIsPure(pakFile->pack))
+			break;
+	}
+
+	for(i = 0; i < fs_index.numDirs; i++)
+	{
+		search = fs_index.dirs[i];
+
+		if(pakFile && pakFile->pack->searchOrder < search->order)
+			break;
+
+		*len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, qfalse);
 
 		if(file == NULL)
 		{
-			if(len > 0)
-				return len;
+			if(*len > 0)
+				return qtrue;
 		}
 		else
 		{
-			if(len >= 0 && *file)
-				return len;
+			if(*len >= 0 && *file)
+				return qtrue;
 		}
-
+	}
+
+	if(pakFile == NULL)
+		return qfalse;
+
+	*len = FS_FOpenFileReadDir(filename, pakFile->pack->search, file, uniqueFILE, qfalse);
+	return qtrue;
+}
+
+/*
+===========
+FS_FOpenFileRead
+
+Finds the file in the search path.
+Returns filesize and an open FILE pointer.
+Used for streaming data out of either a
+separate file or a ZIP file.
+===========
+*/
+long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueFILE)
+{
+	searchpath_t *search;
+	long len;
+
+	if(!fs_searchpaths)
+		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+
+	if(FS_UseFileIndex())
+	{
+		if(FS_FOpenFileReadIndexed(filename, file, uniqueFILE, &len))
+			return len;
+	}
+	else for(search = fs_searchpaths; search; search = search->next)
+	{
+		len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, qfalse);
+
+		if(file == NULL)
+		{
+			if(len > 0)
+				return len;
+		}
+		else
+		{
+			if(len >= 0 && *file)
+				return len;
+		}
+
 	}
 
 #ifdef FS_MISSING
@@ -1749,6 +2336,26 @@ int	FS_FileIsInPAK_A( qboolean alternate, const char *filename, int *pChecksum )
 		return -1;
 	}
 
+	if ( FS_UseFileIndex() ) {
+		unsigned int indexHash = FS_IndexHashFileName( filename );
+
+		for ( pakFile = FS_IndexFindFile( filename, indexHash, NULL ) ; pakFile ;
+		      pakFile = FS_IndexFindFile( filename, indexHash, pakFile ) ) {
+			pak = pakFile->pack;
+			if ( !FS_PakIsPure( pak ) ) {
+				continue;
+			}
+			if ( ( alternate && pak->onlyPrimary ) || ( !alternate && pak->onlyAlternate ) ) {
+				continue;
+			}
+			if ( pChecksum ) {
+				*pChecksum = pak->pure_checksum;
+			}
+			return 1;
+		}
+		return -1;
+	}
+
 	//
 	// search through the path, one element at a time
 	//
@@ -1786,6 +2393,74 @@ int	FS_FileIsInPAK_A( qboolean alternate, const char *filename, int *pChecksum )
 	return -1;
 }
 
+/*
+============
+FS_ReadMappedFile
+
+Reads a whole pak file straight out of the mapped pak, stored files are
+copied and deflated ones are inflated in one go (or taken from the inflate
+cache). Returns -1 if the file has to go through the regular file handles.
+============
+*/
+static long FS_ReadMappedFile( const char *qpath, byte **buffer ) {
+	fileInPack_t	*pakFile;
+	pack_t			*pak;
+	unsigned int	hash;
+	byte			*buf;
+	int				i;
+
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
+	}
+
+	if ( strstr( qpath, ".." ) || strstr( qpath, "::" ) ) {
+		return -1;
+	}
+
+	hash = FS_IndexHashFileName( qpath );
+	for ( pakFile = FS_IndexFindFile( qpath, hash, NULL ) ; pakFile ; pakFile = FS_IndexFindFile( qpath, hash, pakFile ) ) {
+		if ( FS_PakIsPure( pakFile->pack ) ) {
+			break;
+		}
+	}
+
+	if ( !pakFile ) {
+		return -1;
+	}
+	pak = pakFile->pack;
+
+	// a directory before the pak may hold its own copy
+	for ( i = 0 ; i < fs_index.numDirs && fs_index.dirs[ i ]->order < pak->searchOrder ; i++ ) {
+		if ( FS_FOpenFileReadDir( qpath, fs_index.dirs[ i ], NULL, qfalse, qfalse ) > 0 ) {
+			return -1;
+		}
+	}
+
+	if ( !FS_PakMapIsCurrent( pak ) || !FS_ResolvePakFileData( pakFile ) ) {
+		return -1;
+	}
+
+	buf = Hunk_AllocateTempMemory( pakFile->len + 1 );
+	if ( !FS_ReadPakFileData( pakFile, buf ) ) {
+		Hunk_FreeTempMemory( buf );
+		pakFile->dataOfs = -1;
+		return -1;
+	}
+
+	// guarantee that it will have a trailing 0 for string operations
+	buf[ pakFile->len ] = 0;
+
+	FS_ReferencePakFile( pak, qpath );
+	fs_readCount += pakFile->len;
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_ReadFile: %s (mapped from '%s')\n", qpath, pak->pakFilename );
+	}
+
+	*buffer = buf;
+	return pakFile->len;
+}
+
 /*
 ============
 FS_ReadFileDir
@@ -1849,200 +2524,652 @@ long FS_ReadFileDir(const char *qpath, void *searchPath, qboolean unpure, void *
 			fs_loadCount++;
 			fs_loadStack++;
 
-			// guarantee that it will have a trailing 0 for string operations
-			buf[len] = 0;
+			// guarantee that it will have a trailing 0 for string operations
+			buf[len] = 0;
+
+			return len;
+		}
+	} else {
+		isConfig = qfalse;
+	}
+
+	search = searchPath;
+
+	if ( search == NULL && buffer && fs_mmap->integer && FS_UseFileIndex() ) {
+		len = FS_ReadMappedFile( qpath, &buf );
+
+		if ( len >= 0 ) {
+			*buffer = buf;
+
+			fs_loadCount++;
+			fs_loadStack++;
+
+			if ( isConfig && com_journal && com_journal->integer == 1 ) {
+				Com_DPrintf( "Writing %s to journal file.\n", qpath );
+				FS_Write( &len, sizeof( len ), com_journalDataFile );
+				FS_Write( buf, len, com_journalDataFile );
+				FS_Flush( com_journalDataFile );
+			}
+			return len;
+		}
+	}
+
+	if(search == NULL)
+	{
+		// look for it in the filesystem or pack files
+		len = FS_FOpenFileRead(qpath, &h, qfalse);
+	}
+	else
+	{
+		// look for it in a specific search path only
+		len = FS_FOpenFileReadDir(qpath, search, &h, qfalse, unpure);
+	}
+
+	if ( h == 0 ) {
+		if ( buffer ) {
+			*buffer = NULL;
+		}
+		// if we are journalling and it is a config file, write a zero to the journal file
+		if ( isConfig && com_journal && com_journal->integer == 1 ) {
+			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
+			len = 0;
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		return -1;
+	}
+
+	if ( !buffer ) {
+		if ( isConfig && com_journal && com_journal->integer == 1 ) {
+			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		FS_FCloseFile( h);
+		return len;
+	}
+
+	fs_loadCount++;
+	fs_loadStack++;
+
+	buf = Hunk_AllocateTempMemory(len+1);
+	*buffer = buf;
+
+	FS_Read (buf, len, h);
+
+	// guarantee that it will have a trailing 0 for string operations
+	buf[len] = 0;
+	FS_FCloseFile( h );
+
+	// if we are journalling and it is a config file, write it to the journal file
+	if ( isConfig && com_journal && com_journal->integer == 1 ) {
+		Com_DPrintf( "Writing %s to journal file.\n", qpath );
+		FS_Write( &len, sizeof( len ), com_journalDataFile );
+		FS_Write( buf, len, com_journalDataFile );
+		FS_Flush( com_journalDataFile );
+	}
+	return len;
+}
+
+/*
+============
+FS_ReadFile
+
+Filename are relative to the quake search path
+a null buffer will just return the file length without loading
+============
+*/
+long FS_ReadFile(const char *qpath, void **buffer)
+{
+	return FS_ReadFileDir(qpath, NULL, qfalse, buffer);
+}
+
+/*
+=============
+FS_FreeFile
+=============
+*/
+void FS_FreeFile( void *buffer ) {
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
+	}
+	fs_loadStack--;
+
+	Hunk_FreeTempMemory( buffer );
+
+	// if all of our temp files are free, clear all of our space
+	if ( fs_loadStack == 0 ) {
+		Hunk_ClearTempMemory();
+	}
+}
+
+/*
+============
+FS_WriteFile
+
+Filename are relative to the quake search path
+============
+*/
+void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
+	fileHandle_t f;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !qpath || !buffer ) {
+		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
+	}
+
+	f = FS_FOpenFileWrite( qpath );
+	if ( !f ) {
+		Com_Printf( "Failed to open %s\n", qpath );
+		return;
+	}
+
+	FS_Write( buffer, size, f );
+
+	FS_FCloseFile( f );
+}
+
+
+
+/*
+==========================================================================
+
+ZIP FILE LOADING
+
+==========================================================================
+*/
+
+/*
+=================
+FS_PakCacheLoad
+
+Reads pakcache.dat and starts collecting the records to write back
+=================
+*/
+static void FS_PakCacheLoad( void )
+{
+	pakCache_t			*cache = &fs_pakCacheState;
+	pakCacheRecord_t	*record;
+	char				path[MAX_OSPATH];
+	FILE				*f;
+	long				len;
+	int					ofs, i, header[3], nameLen, slot;
+
+	Com_Memset( cache, 0, sizeof( *cache ) );
+	cache->active = qtrue;
+
+	Com_sprintf( path, sizeof( path ), "%s%cpakcache.dat", fs_homepath->string, PATH_SEP );
+	f = Sys_FOpen( path, "rb" );
+	if ( !f ) {
+		return;
+	}
+
+	len = FS_fplength( f );
+	if ( len < sizeof( header ) || len > 0x10000000 ) {
+		fclose( f );
+		return;
+	}
+
+	cache->data = malloc( len );
+	if ( !cache->data || fread( cache->data, 1, len, f ) != len ) {
+		fclose( f );
+		free( cache->data );
+		cache->data = NULL;
+		return;
+	}
+	fclose( f );
+
+	Com_Memcpy( header, cache->data, sizeof( header ) );
+	if ( header[0] != PAK_CACHE_IDENT || header[1] != PAK_CACHE_VERSION ||
+	     header[2] <= 0 || header[2] > MAX_SEARCH_PATHS * 4 ) {
+		free( cache->data );
+		cache->data = NULL;
+		return;
+	}
+
+	cache->records = malloc( header[2] * sizeof( *cache->records ) );
+	if ( !cache->records ) {
+		free( cache->data );
+		cache->data = NULL;
+		return;
+	}
+
+	ofs = sizeof( header );
+	for ( i = 0 ; i < header[2] ; i++ ) {
+		record = &cache->records[ i ];
+
+		if ( ofs + 4 > len ) {
+			break;
+		}
+		Com_Memcpy( &nameLen, cache->data + ofs, 4 );
+		ofs += 4;
+		if ( nameLen <= 0 || nameLen > MAX_OSPATH || ( nameLen & 3 ) || ofs + nameLen + 24 > len ||
+		     cache->data[ ofs + nameLen - 1 ] ) {
+			break;
+		}
+		record->pakFilename = (const char *)( cache->data + ofs );
+		ofs += nameLen;
+
+		Com_Memcpy( &record->size, cache->data + ofs, 8 );
+		Com_Memcpy( &record->mtime, cache->data + ofs + 8, 8 );
+		Com_Memcpy( &record->numEntries, cache->data + ofs + 16, 4 );
+		Com_Memcpy( &record->namesLen, cache->data + ofs + 20, 4 );
+		ofs += 24;
+
+		if ( record->numEntries < 0 || record->namesLen <= 0 || ( record->namesLen & 3 ) ||
+		     record->numEntries > ( len - ofs ) / sizeof( zipEntry_t ) ||
+		     ofs + record->numEntries * sizeof( zipEntry_t ) + record->namesLen > len ) {
+			break;
+		}
+		record->entries = (zipEntry_t *)( cache->data + ofs );
+		ofs += record->numEntries * sizeof( zipEntry_t );
+		record->names = (char *)( cache->data + ofs );
+		ofs += record->namesLen;
+
+		if ( record->names[ record->namesLen - 1 ] ) {
+			break;
+		}
+		for ( nameLen = 0 ; nameLen < record->numEntries ; nameLen++ ) {
+			if ( record->entries[ nameLen ].nameOfs >= record->namesLen ) {
+				break;
+			}
+		}
+		if ( nameLen < record->numEntries ) {
+			break;
+		}
+
+		slot = FS_IndexHashFileName( record->pakFilename ) & ( PAK_CACHE_HASH_SIZE - 1 );
+		record->hashNext = cache->hash[ slot ];
+		cache->hash[ slot ] = record;
+	}
+	cache->numRecords = i;
+}
+
+/*
+=================
+FS_PakCacheFind
+
+Fills in the size and modification time of the scanned pak and returns
+its cache record if it hasn't changed since. Safe to call from the scan
+threads as the cache is only read while they run.
+=================
+*/
+static const pakCacheRecord_t *FS_PakCacheFind( zipScan_t *scan )
+{
+	pakCacheRecord_t	*record;
+
+	if ( !Sys_FileStat( scan->pakFilename, &scan->size, &scan->mtime ) ) {
+		scan->size = -1;
+		return NULL;
+	}
+
+	if ( !fs_pakCacheState.active ) {
+		return NULL;
+	}
+
+	for ( record = fs_pakCacheState.hash[ FS_IndexHashFileName( scan->pakFilename ) & ( PAK_CACHE_HASH_SIZE - 1 ) ] ;
+	      record ; record = record->hashNext ) {
+		if ( !strcmp( record->pakFilename, scan->pakFilename ) ) {
+			if ( record->size == scan->size && record->mtime == scan->mtime ) {
+				return record;
+			}
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+/*
+=================
+FS_PakCacheWrite
+=================
+*/
+static void FS_PakCacheWrite( const void *data, int len )
+{
+	pakCache_t	*cache = &fs_pakCacheState;
+	byte		*out;
+
+	if ( cache->outLen + len > cache->outSize ) {
+		cache->outSize = MAX( cache->outSize * 2, cache->outLen + len + 0x10000 );
+		out = realloc( cache->out, cache->outSize );
+		if ( !out ) {
+			// give up on saving the cache this time
+			free( cache->out );
+			cache->out = NULL;
+			cache->outSize = 0;
+			cache->active = qfalse;
+			return;
+		}
+		cache->out = out;
+	}
+
+	Com_Memcpy( cache->out + cache->outLen, data, len );
+	cache->outLen += len;
+}
+
+/*
+=================
+FS_PakCacheAdd
+
+Records a scanned pak for the cache written at the end of FS_Startup
+=================
+*/
+static void FS_PakCacheAdd( const zipScan_t *scan )
+{
+	pakCache_t	*cache = &fs_pakCacheState;
+	static const byte pad[4];
+	int			len;
+
+	if ( scan->fromCache ) {
+		fs_numCachedPaks++;
+	} else {
+		fs_numScannedPaks++;
+	}
+
+	if ( !cache->active || scan->size < 0 ) {
+		return;
+	}
+
+	if ( !cache->outLen ) {
+		int header[3] = { PAK_CACHE_IDENT, PAK_CACHE_VERSION, 0 };
+		FS_PakCacheWrite( header, sizeof( header ) );
+	}
+
+	len = ( strlen( scan->pakFilename ) + 4 ) & ~3;
+	FS_PakCacheWrite( &len, 4 );
+	FS_PakCacheWrite( scan->pakFilename, strlen( scan->pakFilename ) );
+	FS_PakCacheWrite( pad, len - strlen( scan->pakFilename ) );
+
+	len = ( scan->namesLen + 4 ) & ~3;
+	FS_PakCacheWrite( &scan->size, 8 );
+	FS_PakCacheWrite( &scan->mtime, 8 );
+	FS_PakCacheWrite( &scan->numEntries, 4 );
+	FS_PakCacheWrite( &len, 4 );
+	FS_PakCacheWrite( scan->entries, scan->numEntries * sizeof( zipEntry_t ) );
+	FS_PakCacheWrite( scan->names, scan->namesLen );
+	FS_PakCacheWrite( pad, len - scan->namesLen );
+
+	cache->numOut++;
+	if ( !scan->fromCache ) {
+		cache->dirty = qtrue;
+	}
+}
+
+/*
+=================
+FS_PakCacheSave
 
-			return len;
+Writes the cache back if any pak was added, changed or removed
+=================
+*/
+static void FS_PakCacheSave( void )
+{
+	pakCache_t	*cache = &fs_pakCacheState;
+	char		path[MAX_OSPATH], tmpPath[MAX_OSPATH];
+	FILE		*f;
+	qboolean	written;
+
+	if ( cache->active && cache->out && ( cache->dirty || cache->numOut != cache->numRecords ) ) {
+		Com_Memcpy( cache->out + 8, &cache->numOut, 4 );
+
+		Com_sprintf( path, sizeof( path ), "%s%cpakcache.dat", fs_homepath->string, PATH_SEP );
+		Com_sprintf( tmpPath, sizeof( tmpPath ), "%s%cpakcache.%d.tmp", fs_homepath->string, PATH_SEP, Sys_PID( ) );
+
+		// write to a temporary file of our own first, other servers may share the home path
+		f = Sys_FOpen( tmpPath, "wb" );
+		if ( f ) {
+			written = ( fwrite( cache->out, 1, cache->outLen, f ) == cache->outLen );
+			written &= !fclose( f );
+			if ( written ) {
+				remove( path );
+				written = !rename( tmpPath, path );
+			}
+			if ( !written ) {
+				remove( tmpPath );
+				Com_Printf( S_COLOR_YELLOW "WARNING: couldn't write %s\n", path );
+			}
 		}
-	} else {
-		isConfig = qfalse;
 	}
 
-	search = searchPath;
+	free( cache->out );
+	free( cache->records );
+	free( cache->data );
+	Com_Memset( cache, 0, sizeof( *cache ) );
+}
 
-	if(search == NULL)
-	{
-		// look for it in the filesystem or pack files
-		len = FS_FOpenFileRead(qpath, &h, qfalse);
+/*
+=================
+FS_ScanZipFile
+
+Reads the central directory of scan->pakFilename and computes the pak
+checksums. Only uses malloc and the scan itself, so that it can run on a
+worker thread; unchanged paks are taken from the pak cache.
+=================
+*/
+static void FS_ScanZipFile( zipScan_t *scan )
+{
+	const pakCacheRecord_t	*record;
+	unz_global_info	gi;
+	unz_file_info	file_info;
+	char			filename_inzip[MAX_ZPATH];
+	int				*headerLongs;
+	int				numHeaderLongs;
+	int				i, len;
+
+	scan->handle = unzOpen( scan->pakFilename );
+	if ( !scan->handle ) {
+		return;
 	}
-	else
-	{
-		// look for it in a specific search path only
-		len = FS_FOpenFileReadDir(qpath, search, &h, qfalse, unpure);
+	if ( unzGetGlobalInfo( scan->handle, &gi ) != UNZ_OK ) {
+		unzClose( scan->handle );
+		scan->handle = NULL;
+		return;
 	}
 
-	if ( h == 0 ) {
-		if ( buffer ) {
-			*buffer = NULL;
+	record = FS_PakCacheFind( scan );
+
+	if ( record && record->numEntries <= gi.number_entry ) {
+		scan->numEntries = record->numEntries;
+		scan->entries = record->entries;
+		scan->namesLen = record->namesLen;
+		scan->names = record->names;
+		scan->fromCache = qtrue;
+	} else {
+		len = 0;
+		unzGoToFirstFile( scan->handle );
+		for ( i = 0 ; i < gi.number_entry ; i++ ) {
+			if ( unzGetCurrentFileInfo( scan->handle, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 ) != UNZ_OK ) {
+				break;
+			}
+			len += strlen( filename_inzip ) + 1;
+			unzGoToNextFile( scan->handle );
 		}
-		// if we are journalling and it is a config file, write a zero to the journal file
-		if ( isConfig && com_journal && com_journal->integer == 1 ) {
-			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
-			len = 0;
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
+
+		scan->entries = malloc( ( gi.number_entry + 1 ) * sizeof( *scan->entries ) );
+		scan->names = malloc( len + 1 );
+		if ( !scan->entries || !scan->names ) {
+			free( scan->entries );
+			free( scan->names );
+			scan->entries = NULL;
+			scan->names = NULL;
+			unzClose( scan->handle );
+			scan->handle = NULL;
+			return;
 		}
-		return -1;
-	}
 
-	if ( !buffer ) {
-		if ( isConfig && com_journal && com_journal->integer == 1 ) {
-			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
+		len = 0;
+		unzGoToFirstFile( scan->handle );
+		for ( i = 0 ; i < gi.number_entry ; i++ ) {
+			if ( unzGetCurrentFileInfo( scan->handle, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 ) != UNZ_OK ) {
+				break;
+			}
+			Q_strlwr( filename_inzip );
+			scan->entries[ i ].pos = unzGetOffset( scan->handle );
+			scan->entries[ i ].len = file_info.uncompressed_size;
+			scan->entries[ i ].crc = file_info.crc;
+			scan->entries[ i ].nameOfs = len;
+			strcpy( scan->names + len, filename_inzip );
+			len += strlen( filename_inzip ) + 1;
+			unzGoToNextFile( scan->handle );
 		}
-		FS_FCloseFile( h);
-		return len;
+		scan->numEntries = i;
+		scan->namesLen = len;
 	}
 
-	fs_loadCount++;
-	fs_loadStack++;
-
-	buf = Hunk_AllocateTempMemory(len+1);
-	*buffer = buf;
+	headerLongs = malloc( ( scan->numEntries + 1 ) * sizeof( *headerLongs ) );
+	if ( !headerLongs ) {
+		return;
+	}
 
-	FS_Read (buf, len, h);
+	numHeaderLongs = 0;
+	headerLongs[ numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
+	for ( i = 0 ; i < scan->numEntries ; i++ ) {
+		if ( scan->entries[ i ].len > 0 ) {
+			headerLongs[ numHeaderLongs++ ] = LittleLong( scan->entries[ i ].crc );
+		}
+	}
 
-	// guarantee that it will have a trailing 0 for string operations
-	buf[len] = 0;
-	FS_FCloseFile( h );
+	scan->checksum = Com_BlockChecksum( &headerLongs[ 1 ], sizeof( *headerLongs ) * ( numHeaderLongs - 1 ) );
+	scan->pure_checksum = Com_BlockChecksum( headerLongs, sizeof( *headerLongs ) * numHeaderLongs );
+	scan->checksum = LittleLong( scan->checksum );
+	scan->pure_checksum = LittleLong( scan->pure_checksum );
 
-	// if we are journalling and it is a config file, write it to the journal file
-	if ( isConfig && com_journal && com_journal->integer == 1 ) {
-		Com_DPrintf( "Writing %s to journal file.\n", qpath );
-		FS_Write( &len, sizeof( len ), com_journalDataFile );
-		FS_Write( buf, len, com_journalDataFile );
-		FS_Flush( com_journalDataFile );
-	}
-	return len;
+	free( headerLongs );
+	scan->valid = qtrue;
 }
 
 /*
-============
-FS_ReadFile
+=================
+FS_FreeZipScan
 
-Filename are relative to the quake search path
-a null buffer will just return the file length without loading
-============
+Releases what FS_ScanZipFile allocated, the zip handle is only closed
+if it wasn't handed over to a pak
+=================
 */
-long FS_ReadFile(const char *qpath, void **buffer)
+static void FS_FreeZipScan( zipScan_t *scan )
 {
-	return FS_ReadFileDir(qpath, NULL, qfalse, buffer);
+	if ( scan->handle ) {
+		unzClose( scan->handle );
+		scan->handle = NULL;
+	}
+	if ( !scan->fromCache ) {
+		free( scan->entries );
+		free( scan->names );
+	}
+	scan->entries = NULL;
+	scan->names = NULL;
 }
 
 /*
-=============
-FS_FreeFile
-=============
+=================
+FS_ScanZipFilesThread
+=================
 */
-void FS_FreeFile( void *buffer ) {
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
-	}
-	if ( !buffer ) {
-		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
-	}
-	fs_loadStack--;
+typedef struct {
+	zipScan_t	*scans;
+	int			numScans;
+	int			first;
+	int			stride;
+} zipScanJob_t;
 
-	Hunk_FreeTempMemory( buffer );
+static void FS_ScanZipFilesThread( void *arg )
+{
+	zipScanJob_t	*job = arg;
+	int				i;
 
-	// if all of our temp files are free, clear all of our space
-	if ( fs_loadStack == 0 ) {
-		Hunk_ClearTempMemory();
+	for ( i = job->first ; i < job->numScans ; i += job->stride ) {
+		FS_ScanZipFile( &job->scans[ i ] );
 	}
 }
 
 /*
-============
-FS_WriteFile
+=================
+FS_ScanZipFiles
 
-Filename are relative to the quake search path
-============
+Scans all the given paks, spread over fs_scanThreads threads
+(0 picks one per processor). The results are merged by the caller
+in paksort order, so the thread count never changes the outcome.
+=================
 */
-void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
-	fileHandle_t f;
+#define MAX_SCAN_THREADS	16
 
-	if ( !fs_searchpaths ) {
-		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+static int FS_ScanZipFiles( zipScan_t *scans, int numScans )
+{
+	zipScanJob_t	jobs[ MAX_SCAN_THREADS ];
+	void			*threads[ MAX_SCAN_THREADS ];
+	int				numThreads, i;
+
+	numThreads = fs_scanThreads->integer;
+	if ( numThreads <= 0 ) {
+		numThreads = Sys_ProcessorCount();
+	}
+	numThreads = MIN( numThreads, MAX_SCAN_THREADS );
+	numThreads = MIN( numThreads, numScans );
+	numThreads = MAX( numThreads, 1 );
+
+	for ( i = 0 ; i < numThreads ; i++ ) {
+		jobs[ i ].scans = scans;
+		jobs[ i ].numScans = numScans;
+		jobs[ i ].first = i;
+		jobs[ i ].stride = numThreads;
+	}
+
+	// the calling thread takes the first share
+	for ( i = 1 ; i < numThreads ; i++ ) {
+		threads[ i ] = Sys_CreateThread( FS_ScanZipFilesThread, &jobs[ i ] );
+		if ( !threads[ i ] ) {
+			FS_ScanZipFilesThread( &jobs[ i ] );
+		}
 	}
 
-	if ( !qpath || !buffer ) {
-		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
-	}
+	FS_ScanZipFilesThread( &jobs[ 0 ] );
 
-	f = FS_FOpenFileWrite( qpath );
-	if ( !f ) {
-		Com_Printf( "Failed to open %s\n", qpath );
-		return;
+	for ( i = 1 ; i < numThreads ; i++ ) {
+		if ( threads[ i ] ) {
+			Sys_JoinThread( threads[ i ] );
+		}
 	}
 
-	FS_Write( buffer, size, f );
-
-	FS_FCloseFile( f );
+	return numThreads;
 }
 
-
-
-/*
-==========================================================================
-
-ZIP FILE LOADING
-
-==========================================================================
-*/
-
 /*
 =================
-FS_LoadZipFile
+FS_LoadZipScan
 
-Creates a new pak_t in the search chain for the contents
-of a zip file.
+Creates a new pak_t for the contents of a scanned zip file
+and releases the scan
 =================
 */
-static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
+static pack_t *FS_LoadZipScan(zipScan_t *scan, const char *basename)
 {
 	fileInPack_t	*buildBuffer;
 	pack_t			*pack;
-	unzFile			uf;
-	int				err;
-	unz_global_info gi;
-	char			filename_inzip[MAX_ZPATH];
-	unz_file_info	file_info;
-	int				i, len;
+	int				i;
 	long			hash;
-	int				fs_numHeaderLongs;
-	int				*fs_headerLongs;
 	char			*namePtr;
 
-	fs_numHeaderLongs = 0;
-
-	uf = unzOpen(zipfile);
-	err = unzGetGlobalInfo (uf,&gi);
-
-	if (err != UNZ_OK)
+	if ( !scan->valid ) {
+		FS_FreeZipScan( scan );
 		return NULL;
-
-	len = 0;
-	unzGoToFirstFile(uf);
-	for (i = 0; i < gi.number_entry; i++)
-	{
-		err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
-		if (err != UNZ_OK) {
-			break;
-		}
-		len += strlen(filename_inzip) + 1;
-		unzGoToNextFile(uf);
 	}
 
-	buildBuffer = Z_Malloc( (gi.number_entry * sizeof( fileInPack_t )) + len );
-	namePtr = ((char *) buildBuffer) + gi.number_entry * sizeof( fileInPack_t );
-	fs_headerLongs = Z_Malloc( ( gi.number_entry + 1 ) * sizeof(int) );
-	fs_headerLongs[ fs_numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
+	FS_PakCacheAdd( scan );
+
+	buildBuffer = Z_Malloc( (scan->numEntries * sizeof( fileInPack_t )) + scan->namesLen );
+	namePtr = ((char *) buildBuffer) + scan->numEntries * sizeof( fileInPack_t );
+	Com_Memcpy( namePtr, scan->names, scan->namesLen );
 
 	// get the hash table size from the number of files in the zip
 	// because lots of custom pk3 files have less than 32 or 64 files
 	for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
-		if (i > gi.number_entry) {
+		if (i > scan->numEntries) {
 			break;
 		}
 	}
@@ -2054,7 +3181,7 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
 		pack->hashTable[i] = NULL;
 	}
 
-	Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
+	Q_strncpyz( pack->pakFilename, scan->pakFilename, sizeof( pack->pakFilename ) );
 	Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
 
 	// strip .pk3 if needed
@@ -2062,43 +3189,49 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
 		pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
 	}
 
-	pack->handle = uf;
-	pack->numfiles = gi.number_entry;
-	unzGoToFirstFile(uf);
+	pack->handle = scan->handle;
+	scan->handle = NULL;
+	pack->numfiles = scan->numEntries;
 
-	for (i = 0; i < gi.number_entry; i++)
+	for (i = 0; i < scan->numEntries; i++)
 	{
-		err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
-		if (err != UNZ_OK) {
-			break;
-		}
-		if (file_info.uncompressed_size > 0) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleLong(file_info.crc);
-		}
-		Q_strlwr( filename_inzip );
-		hash = FS_HashFileName(filename_inzip, pack->hashSize);
-		buildBuffer[i].name = namePtr;
-		strcpy( buildBuffer[i].name, filename_inzip );
-		namePtr += strlen(filename_inzip) + 1;
+		buildBuffer[i].name = namePtr + scan->entries[i].nameOfs;
+		hash = FS_HashFileName(buildBuffer[i].name, pack->hashSize);
 		// store the file position in the zip
-		buildBuffer[i].pos = unzGetOffset(uf);
-		buildBuffer[i].len = file_info.uncompressed_size;
+		buildBuffer[i].pos = scan->entries[i].pos;
+		buildBuffer[i].len = scan->entries[i].len;
 		buildBuffer[i].next = pack->hashTable[hash];
 		pack->hashTable[hash] = &buildBuffer[i];
-		unzGoToNextFile(uf);
 	}
 
-	pack->checksum = Com_BlockChecksum( &fs_headerLongs[ 1 ], sizeof(*fs_headerLongs) * ( fs_numHeaderLongs - 1 ) );
-	pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs );
-	pack->checksum = LittleLong( pack->checksum );
-	pack->pure_checksum = LittleLong( pack->pure_checksum );
-
-	Z_Free(fs_headerLongs);
+	pack->checksum = scan->checksum;
+	pack->pure_checksum = scan->pure_checksum;
 
 	pack->buildBuffer = buildBuffer;
+
+	FS_FreeZipScan( scan );
 	return pack;
 }
 
+/*
+=================
+FS_LoadZipFile
+
+Creates a new pak_t in the search chain for the contents
+of a zip file.
+=================
+*/
+static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
+{
+	zipScan_t	scan;
+
+	Com_Memset( &scan, 0, sizeof( scan ) );
+	Q_strncpyz( scan.pakFilename, zipfile, sizeof( scan.pakFilename ) );
+	FS_ScanZipFile( &scan );
+
+	return FS_LoadZipScan( &scan, basename );
+}
+
 /*
 =================
 FS_FreePak
@@ -2109,6 +3242,8 @@ Frees a pak structure and releases all associated resources
 
 static void FS_FreePak(pack_t *thepak)
 {
+	if(thepak->mapped)
+		Sys_UnmapFile(thepak->mapped, thepak->mappedSize);
 	unzClose(thepak->handle);
 	Z_Free(thepak->buildBuffer);
 	Z_Free(thepak);
@@ -2882,6 +4017,96 @@ void FS_Which_f( void ) {
 }
 
 
+/*
+============
+FS_Benchmark_f
+
+Reads every file of every loaded pak through FS_ReadFile, optionally only
+those with the given extension. Toggle fs_index and fs_mmap to compare.
+============
+*/
+void FS_Benchmark_f( void ) {
+	searchpath_t	*search;
+	fileInPack_t	*pakFile;
+	int				*referenced;
+	const char		*extension;
+	void			*buffer;
+	int				passes, pass, numPaks, files, start, msec, i;
+	long			len;
+	double			bytes;
+
+	if ( Cmd_Argc() > 3 ) {
+		Com_Printf( "Usage: fs_benchmark [passes] [extension]\n" );
+		return;
+	}
+
+	passes = ( Cmd_Argc() > 1 ) ? atoi( Cmd_Argv( 1 ) ) : 1;
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+	extension = ( Cmd_Argc() > 2 ) ? Cmd_Argv( 2 ) : "";
+
+	// reading everything must not change which paks are referenced
+	numPaks = 0;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			numPaks++;
+		}
+	}
+	referenced = Z_Malloc( ( numPaks + 1 ) * sizeof( *referenced ) );
+	for ( i = 0, search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			referenced[ i++ ] = search->pack->referenced;
+		}
+	}
+
+	files = 0;
+	bytes = 0;
+	start = Sys_Milliseconds();
+
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( search = fs_searchpaths ; search ; search = search->next ) {
+			if ( !search->pack ) {
+				continue;
+			}
+
+			for ( i = 0 ; i < search->pack->numfiles ; i++ ) {
+				pakFile = &search->pack->buildBuffer[ i ];
+				if ( !pakFile->name ) {
+					break;
+				}
+				if ( !pakFile->len ) {
+					continue;
+				}
+				if ( extension[0] && !FS_IsExt( pakFile->name, extension, strlen( pakFile->name ) ) ) {
+					continue;
+				}
+
+				len = FS_ReadFile( pakFile->name, &buffer );
+				if ( buffer ) {
+					bytes += len;
+					files++;
+					FS_FreeFile( buffer );
+				}
+			}
+		}
+	}
+
+	msec = Sys_Milliseconds() - start;
+
+	for ( i = 0, search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			search->pack->referenced = referenced[ i++ ];
+		}
+	}
+	Z_Free( referenced );
+
+	Com_Printf( "%d files, %.1f MB from %d paks in %d msec, %.1f usec per file (fs_index %d, fs_mmap %d)\n",
+		files, bytes / ( 1024.0 * 1024.0 ), numPaks, msec,
+		files ? ( msec * 1000.0 ) / files : 0.0, fs_useIndex->integer, fs_mmap->integer );
+	Com_Printf( "%d KB in the inflate cache\n", fs_inflateCacheBytes / 1024 );
+}
+
 //===========================================================================
 
 
@@ -2926,6 +4151,8 @@ void FS_AddGameDirectory( const char *path, const char *dir ) {
 	int				numPairs, i;
 	searchpath_t	*otherSearchpaths;
 	searchpath_t	*srch;
+	zipScan_t		*scans;
+	int				scanStart;
 
 	// Unique
 	for ( sp = fs_searchpaths ; sp ; sp = sp->next ) {
@@ -2945,6 +4172,18 @@ void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 	qsort( pakfiles, numfiles, sizeof(char*), paksort );
 
+	// scan all the pk3s up front, the results are used in paksort order below
+	scans = NULL;
+	if ( numfiles ) {
+		scanStart = Sys_Milliseconds();
+		scans = Z_Malloc( numfiles * sizeof( *scans ) );
+		for ( i = 0 ; i < numfiles ; i++ ) {
+			Q_strncpyz( scans[i].pakFilename, FS_BuildOSPath( path, dir, pakfiles[i] ), sizeof( scans[i].pakFilename ) );
+		}
+		FS_ScanZipFiles( scans, numfiles );
+		fs_scanMsec += Sys_Milliseconds() - scanStart;
+	}
+
 	if ( fs_numServerPaks ) {
 		numdirs = 0;
 		pakdirs = NULL;
@@ -3015,8 +4254,7 @@ void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 		if (pakwhich) {
 			// The next .pk3 file is before the next .pk3dir
-			pakfile = FS_BuildOSPath(path, dir, pakfiles[pakfilesi]);
-			if ((pak = FS_LoadZipFile(pakfile, pakfiles[pakfilesi])) == 0) {
+			if ((pak = FS_LoadZipScan(&scans[pakfilesi], pakfiles[pakfilesi])) == 0) {
 				// This isn't a .pk3! Next!
 				pakfilesi++;
 				continue;
@@ -3079,6 +4317,9 @@ void FS_AddGameDirectory( const char *path, const char *dir ) {
 	// done
 	Sys_FreeFileList( pakfiles );
 	Sys_FreeFileList( pakdirs );
+	if ( scans ) {
+		Z_Free( scans );
+	}
 
 	if ( numPairs > 0 ) {
 		int bnlengths[2];
@@ -3284,12 +4525,18 @@ void FS_Shutdown( qboolean closemfp ) {
 
 	// any FS_ calls will now be an error until reinitialized
 	fs_searchpaths = NULL;
+	FS_FreeFileIndex();
+
+	if ( closemfp ) {
+		FS_InflateCacheClear();
+	}
 
 	Cmd_RemoveCommand( "path" );
 	Cmd_RemoveCommand( "dir" );
 	Cmd_RemoveCommand( "fdir" );
 	Cmd_RemoveCommand( "touchFile" );
 	Cmd_RemoveCommand( "which" );
+	Cmd_RemoveCommand( "fs_benchmark" );
 
 #ifdef FS_MISSING
 	if (closemfp) {
@@ -3352,6 +4599,11 @@ static void FS_Startup( const char *gameName )
 	fs_packFiles = 0;
 
 	fs_debug = Cvar_Get( "fs_debug", "0", 0 );
+	fs_useIndex = Cvar_Get( "fs_index", "1", 0 );
+	fs_mmap = Cvar_Get( "fs_mmap", "1", 0 );
+	fs_inflateCacheSize = Cvar_Get( "fs_inflateCacheSize", "2048", CVAR_ARCHIVE );
+	fs_scanThreads = Cvar_Get( "fs_scanThreads", "0", CVAR_ARCHIVE );
+	fs_pakCache = Cvar_Get( "fs_pakCache", "1", CVAR_ARCHIVE );
 	Cvar_Get ("fs_overpath", Sys_BinaryPath(), CVAR_INIT|CVAR_PROTECTED );
 	fs_basepath = Cvar_Get ("fs_basepath", Sys_DefaultInstallPath(), CVAR_INIT|CVAR_PROTECTED );
 	fs_basegame = Cvar_Get ("fs_basegame", "gpp", CVAR_INIT );
@@ -3364,6 +4616,13 @@ static void FS_Startup( const char *gameName )
 	fs_gamedirvar = Cvar_Get ("fs_game", "gpp", CVAR_INIT|CVAR_SYSTEMINFO );
 	Cvar_Get( "fs_pk3PrefixPairs", "", CVAR_ARCHIVE|CVAR_LATCH );
 
+	fs_numCachedPaks = 0;
+	fs_numScannedPaks = 0;
+	fs_scanMsec = 0;
+	if ( fs_pakCache->integer ) {
+		FS_PakCacheLoad();
+	}
+
 	// add search path elements in reverse priority order
 	if (fs_basepath->string[0]) {
 		FS_AddGameDirectory( fs_basepath->string, gameName );
@@ -3403,17 +4662,22 @@ static void FS_Startup( const char *gameName )
 		}
 	}
 
+	FS_PakCacheSave();
+
 	// add our commands
 	Cmd_AddCommand ("path", FS_Path_f);
 	Cmd_AddCommand ("dir", FS_Dir_f );
 	Cmd_AddCommand ("fdir", FS_NewDir_f );
 	Cmd_AddCommand ("touchFile", FS_TouchFile_f );
 	Cmd_AddCommand ("which", FS_Which_f );
+	Cmd_AddCommand ("fs_benchmark", FS_Benchmark_f );
 
 	// https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=506
 	// reorder the pure pk3 files according to server order
 	FS_ReorderPurePaks();
 
+	FS_BuildFileIndex();
+
 	// print the current search paths
 	FS_Path_f();
 
@@ -3427,6 +4691,8 @@ static void FS_Startup( const char *gameName )
 	}
 #endif
 	Com_Printf( "%d files in pk3 files\n", fs_packFiles );
+	Com_Printf( "%d pk3 files scanned, %d from the pak cache, in %d msec\n",
+		fs_numScannedPaks, fs_numCachedPaks, fs_scanMsec );
 }
 
 /*
@@ -3691,6 +4957,35 @@ const char *FS_ReferencedPakNames( qboolean alternate ) {
 	return info;
 }
 
+/*
+=====================
+FS_ReferencedPakPath
+
+Returns the OS path of a pak listed by FS_ReferencedPakNames for
+either protocol, given as "gamedir/basename", or NULL if that pak
+is not referenced
+=====================
+*/
+const char *FS_ReferencedPakPath( const char *pakName ) {
+	searchpath_t	*search;
+	char			name[MAX_OSPATH * 2];
+
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		if (search->pack->referenced || (search->pack->primaryVersion && search->pack->primaryVersion->referenced) ||
+			(fs_gamedirvar->string[0] && Q_stricmp(fs_gamedirvar->string, BASEGAME) && !Q_stricmp(search->pack->pakGamename, fs_gamedirvar->string))) {
+			Com_sprintf( name, sizeof( name ), "%s/%s", search->pack->pakGamename, search->pack->pakBasename );
+			if ( !FS_FilenameCompare( name, pakName ) ) {
+				return search->pack->pakFilename;
+			}
+		}
+	}
+
+	return NULL;
+}
+
 /*
 =====================
 FS_ClearPakReferences
@@ -3936,7 +5231,10 @@ qboolean FS_ConditionalRestart(int checksumFeed, qboolean disconnect)
 	if(checksumFeed != fs_checksumFeed)
 		FS_Restart(checksumFeed);
 	else if(fs_numServerPaks && !fs_reordered)
+	{
 		FS_ReorderPurePaks();
+		FS_BuildFileIndex();
+	}
 
 	return qfalse;
 }
@@ -40,9 +40,10 @@ struct mdfour {
 /* NOTE: This code makes no attempt to be fast!
 
    It assumes that an int is at least 32 bits long
-*/
 
-static struct mdfour *m;
+   The state is passed around explicitly so that checksums can be
+   computed from several threads at once (pk3 scanning)
+*/
 
 #define F(X,Y,Z) (((X)&(Y)) | ((~(X))&(Z)))
 #define G(X,Y,Z) (((X)&(Y)) | ((X)&(Z)) | ((Y)&(Z)))
@@ -54,7 +55,7 @@ static struct mdfour *m;
 #define ROUND3(a,b,c,d,k,s) a = lshift(a + H(b,c,d) + X[k] + 0x6ED9EBA1,s)
 
 /* this applies md4 to 64 byte chunks */
-static void mdfour64(uint32_t *M)
+static void mdfour64(struct mdfour *m, uint32_t *M)
 {
 	int j;
 	uint32_t AA, BB, CC, DD;
@@ -129,7 +130,7 @@ void mdfour_begin(struct mdfour *md)
 }
 
 
-static void mdfour_tail(byte *in, int n)
+static void mdfour_tail(struct mdfour *m, byte *in, int n)
 {
 	byte buf[128];
 	uint32_t M[16];
@@ -146,13 +147,13 @@ static void mdfour_tail(byte *in, int n)
 	if (n <= 55) {
 		copy4(buf+56, b);
 		copy64(M, buf);
-		mdfour64(M);
+		mdfour64(m, M);
 	} else {
 		copy4(buf+120, b);
 		copy64(M, buf);
-		mdfour64(M);
+		mdfour64(m, M);
 		copy64(M, buf+64);
-		mdfour64(M);
+		mdfour64(m, M);
 	}
 }
 
@@ -160,19 +161,17 @@ static void mdfour_update(struct mdfour *md, byte *in, int n)
 {
 	uint32_t M[16];
 
-	m = md;
-
-	if (n == 0) mdfour_tail(in, n);
+	if (n == 0) mdfour_tail(md, in, n);
 
 	while (n >= 64) {
 		copy64(M, in);
-		mdfour64(M);
+		mdfour64(md, M);
 		in += 64;
 		n -= 64;
-		m->totalN += 64;
+		md->totalN += 64;
 	}
 
-	mdfour_tail(in, n);
+	mdfour_tail(md, in, n);
 }
 
 
@@ -24,6 +24,10 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "q_shared.h"
 #include "qcommon.h"
 
+#if idx64
+#include <emmintrin.h>
+#endif
+
 static huffman_t		msgHuff;
 
 static qboolean			msgInit = qfalse;
@@ -712,6 +716,130 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 /*
 =============================================================================
 
+precomputed huffman writes
+
+The message huffman tree never changes once it is built, so the code of
+every byte is taken out of it once and written straight into the buffer,
+a whole run of bits at a time.  This gives exactly the bits MSG_WriteBits
+does: the low bits&7 bits as they are, then each byte huffman coded.
+
+=============================================================================
+*/
+
+static unsigned int	msgHuffCode[256];		// first bit sent in bit 0
+static int			msgHuffLength[256];
+static int			msgHuffMaxLength;		// 0 if any byte can't be coded
+
+typedef struct {
+	byte		*data;
+	int			bit;
+	uint64_t	pending;			// raw bits not in data yet
+	int			pendingBits;
+} bitWriter_t;
+
+/*
+=================
+MSG_InitHuffmanCodes
+=================
+*/
+static void MSG_InitHuffmanCodes( void ) {
+	node_t	*node;
+	int		i, length;
+	unsigned int	code;
+
+	msgHuffMaxLength = 0;
+	for ( i = 0; i < 256; i++ ) {
+		if ( !msgHuff.compressor.loc[i] ) {
+			msgHuffMaxLength = 0;
+			return;
+		}
+
+		// walk up to the root, the code is sent from the root down
+		code = 0;
+		length = 0;
+		for ( node = msgHuff.compressor.loc[i]; node->parent; node = node->parent ) {
+			if ( length == 32 ) {
+				msgHuffMaxLength = 0;
+				return;
+			}
+			code = ( code << 1 ) | ( node->parent->right == node );
+			length++;
+		}
+
+		msgHuffCode[i] = code;
+		msgHuffLength[i] = length;
+		if ( length > msgHuffMaxLength ) {
+			msgHuffMaxLength = length;
+		}
+	}
+}
+
+/*
+=================
+MSG_FlushBits
+
+Whole bytes are written, each one zeroed where it is started like
+Huff_putBit does
+=================
+*/
+static ID_INLINE void MSG_FlushBits( bitWriter_t *w ) {
+	byte		*p = w->data + ( w->bit >> 3 );
+	int			shift = w->bit & 7;
+	int			bytes = ( shift + w->pendingBits + 7 ) >> 3;
+	uint64_t	value = w->pending << shift;
+	int			i;
+
+	if ( shift ) {
+		value |= p[0] & ( ( 1 << shift ) - 1 );
+	}
+	for ( i = 0; i < bytes; i++, value >>= 8 ) {
+		p[i] = (byte)value;
+	}
+
+	w->bit += w->pendingBits;
+	w->pending = 0;
+	w->pendingBits = 0;
+}
+
+/*
+=================
+MSG_PutBits
+
+Raw bits, at most 32
+=================
+*/
+static ID_INLINE void MSG_PutBits( bitWriter_t *w, unsigned int value, int bits ) {
+	if ( w->pendingBits + bits > 56 ) {
+		MSG_FlushBits( w );
+	}
+	w->pending |= (uint64_t)value << w->pendingBits;
+	w->pendingBits += bits;
+}
+
+/*
+=================
+MSG_PutHuffBits
+
+MSG_WriteBits without the checks, for positive bit counts
+=================
+*/
+static ID_INLINE void MSG_PutHuffBits( bitWriter_t *w, unsigned int value, int bits ) {
+	int		raw = bits & 7;
+	int		c;
+
+	if ( raw ) {
+		MSG_PutBits( w, value & ( ( 1 << raw ) - 1 ), raw );
+		value >>= raw;
+	}
+	for ( bits -= raw; bits > 0; bits -= 8, value >>= 8 ) {
+		c = value & 0xff;
+		MSG_PutBits( w, msgHuffCode[c], msgHuffLength[c] );
+	}
+}
+
+/*
+=============================================================================
+
 entityState_t communication
 	
 =============================================================================
@@ -804,6 +932,150 @@ netField_t	entityStateFields[] =
 #define	FLOAT_INT_BITS	13
 #define	FLOAT_INT_BIAS	(1<<(FLOAT_INT_BITS-1))
 
+/*
+Changed entity fields are found with a word by word compare of the two
+states, giving a mask of the changed words of entityState_t that is
+turned into a mask of changed fields in entityStateFields order with a
+table per byte of the word mask.
+*/
+
+#define	ENTITY_STATE_WORDS	(int)( sizeof( entityState_t ) / 4 )
+
+static uint64_t	entityFieldsForWords[ ( ENTITY_STATE_WORDS + 7 ) / 8 ][256];
+static int		entityFieldBits[3][ ARRAY_LEN( entityStateFields ) ];	// per protocol, 0 = float
+static int		entityStateMaxBits;		// most an update can take with the fast path
+
+/*
+=================
+MSG_InitEntityFields
+=================
+*/
+static void MSG_InitEntityFields( void ) {
+	int		numFields = ARRAY_LEN( entityStateFields );
+	int		i, j, word, protocol;
+
+	Com_Memset( entityFieldsForWords, 0, sizeof( entityFieldsForWords ) );
+	for ( i = 0; i < numFields; i++ ) {
+		word = entityStateFields[i].offset / 4;
+		for ( j = 0; j < 256; j++ ) {
+			if ( j & ( 1 << ( word & 7 ) ) ) {
+				entityFieldsForWords[ word >> 3 ][j] |= (uint64_t)1 << i;
+			}
+		}
+
+		for ( protocol = 0; protocol < 3; protocol++ ) {
+			entityFieldBits[protocol][i] = entityStateFields[i].bits;
+		}
+	}
+	entityFieldBits[2][33] = 8;
+
+	// per field the changed and zero bits and up to four huffman coded
+	// bytes, no fast path if the huffman codes couldn't be precomputed
+	entityStateMaxBits = 0;
+	if ( msgHuffMaxLength ) {
+		entityStateMaxBits = numFields * ( 3 + 7 + msgHuffMaxLength * 4 );
+	}
+}
+
+/*
+=================
+MSG_ChangedEntityFields
+
+Mask of the entityStateFields that differ between the states
+=================
+*/
+static uint64_t MSG_ChangedEntityFields( int alternateProtocol, entityState_t *from, entityState_t *to ) {
+	const int	*a = (const int *)from;
+	const int	*b = (const int *)to;
+	uint64_t	words = 0, fields = 0;
+	int			i = 0;
+
+#if idx64
+	for ( ; i + 4 <= ENTITY_STATE_WORDS; i += 4 ) {
+		__m128i	eq = _mm_cmpeq_epi32( _mm_loadu_si128( (const __m128i *)( a + i ) ),
+			_mm_loadu_si128( (const __m128i *)( b + i ) ) );
+		words |= (uint64_t)( ~_mm_movemask_ps( _mm_castsi128_ps( eq ) ) & 0xf ) << i;
+	}
+#endif
+	for ( ; i < ENTITY_STATE_WORDS; i++ ) {
+		words |= (uint64_t)( a[i] != b[i] ) << i;
+	}
+
+	for ( i = 0; words; i++, words >>= 8 ) {
+		fields |= entityFieldsForWords[i][ words & 0xff ];
+	}
+
+	// protocol 2 has no weaponAnim
+	if ( alternateProtocol == 2 ) {
+		fields &= ~( (uint64_t)1 << 13 );
+	}
+	return fields;
+}
+
+/*
+=================
+MSG_WriteEntityFields
+
+The field loop of MSG_WriteDeltaEntity with precomputed huffman codes,
+there must be room for entityStateMaxBits more bits
+=================
+*/
+static void MSG_WriteEntityFields( int alternateProtocol, msg_t *msg, entityState_t *to,
+	uint64_t changed, int lc ) {
+	const int	*bits = entityFieldBits[ alternateProtocol ];
+	const int	*toW = (const int *)to;
+	bitWriter_t	w;
+	float		fullFloat;
+	int			trunc, value;
+	int			i;
+
+	w.data = msg->data;
+	w.bit = msg->bit;
+	w.pending = 0;
+	w.pendingBits = 0;
+
+	for ( i = 0; i < lc; i++ ) {
+		if ( alternateProtocol == 2 && i == 13 ) {
+			continue;
+		}
+
+		if ( !( changed & ( (uint64_t)1 << i ) ) ) {
+			MSG_PutBits( &w, 0, 1 );	// no change
+			continue;
+		}
+
+		value = toW[ entityStateFields[i].offset / 4 ];
+
+		if ( bits[i] == 0 ) {
+			// float
+			fullFloat = *(float *)&value;
+			trunc = (int)fullFloat;
+
+			if ( fullFloat == 0.0f ) {
+				MSG_PutBits( &w, 1, 2 );		// changed, zero
+			} else if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 &&
+				trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) ) {
+				// changed, not zero, small integer
+				MSG_PutBits( &w, 3, 3 );
+				MSG_PutHuffBits( &w, trunc + FLOAT_INT_BIAS, FLOAT_INT_BITS );
+			} else {
+				// changed, not zero, full floating point value
+				MSG_PutBits( &w, 7, 3 );
+				MSG_PutHuffBits( &w, value, 32 );
+			}
+		} else if ( value == 0 ) {
+			MSG_PutBits( &w, 1, 2 );			// changed, zero
+		} else {
+			MSG_PutBits( &w, 3, 2 );			// changed, not zero
+			MSG_PutHuffBits( &w, (unsigned int)value & ( 0xffffffff >> ( 32 - bits[i] ) ), bits[i] );
+		}
+	}
+	MSG_FlushBits( &w );
+
+	msg->bit = w.bit;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
 /*
 ==================
 MSG_WriteDeltaEntity
@@ -822,7 +1094,8 @@ void MSG_WriteDeltaEntity( int alternateProtocol, msg_t *msg, struct entityState
 	netField_t	*field;
 	int			trunc;
 	float		fullFloat;
-	int			*fromF, *toF;
+	int			*toF;
+	uint64_t	changed;
 
 	numFields = ARRAY_LEN( entityStateFields );
 
@@ -846,17 +1119,13 @@ void MSG_WriteDeltaEntity( int alternateProtocol, msg_t *msg, struct entityState
 		Com_Error (ERR_FATAL, "MSG_WriteDeltaEntity: Bad entity number: %i", to->number );
 	}
 
-	lc = 0;
-	// build the change vector as bytes so it is endien independent
-	for ( i = 0, field = entityStateFields ; i < numFields ; i++, field++ ) {
-		if ( alternateProtocol == 2 && i == 13 ) {
-			continue;
-		}
-		fromF = (int *)( (byte *)from + field->offset );
-		toF = (int *)( (byte *)to + field->offset );
-		if ( *fromF != *toF ) {
-			lc = i+1;
-		}
+	if ( !msgInit ) {
+		MSG_initHuffman( );
+	}
+
+	// the last changed field
+	changed = MSG_ChangedEntityFields( alternateProtocol, from, to );
+	for ( lc = 0; changed >> lc; lc++ ) {
 	}
 
 	if ( lc == 0 ) {
@@ -883,15 +1152,20 @@ void MSG_WriteDeltaEntity( int alternateProtocol, msg_t *msg, struct entityState
 
 	oldsize += numFields;
 
+	if ( entityStateMaxBits && !msg->oob && !msg->overflowed &&
+		msg->bit + entityStateMaxBits <= msg->maxsize << 3 ) {
+		MSG_WriteEntityFields( alternateProtocol, msg, to, changed, lc );
+		return;
+	}
+
 	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
 		if ( alternateProtocol == 2 && i == 13 ) {
 			continue;
 		}
 
-		fromF = (int *)( (byte *)from + field->offset );
 		toF = (int *)( (byte *)to + field->offset );
 
-		if ( *fromF == *toF ) {
+		if ( !( changed & ( (uint64_t)1 << i ) ) ) {
 			MSG_WriteBits( msg, 0, 1 );	// no change
 			continue;
 		}
@@ -1265,6 +1539,117 @@ netField_t	alternatePlayerStateFields[] =
 { APSF(loopSound), 16 }
 };
 
+/*
+The stats, persistant and misc arrays follow each other in
+playerState_t, so their change masks come out of one compare of the
+words from stats on
+*/
+
+#define	PS_ARRAY_WORDS	( MAX_STATS + MAX_PERSISTANT + MAX_MISC )
+
+static int		playerArraysMaxBits;	// most the arrays can take with the fast path
+
+/*
+=================
+MSG_InitPlayerArrays
+=================
+*/
+static void MSG_InitPlayerArrays( void ) {
+	// the changed bits, and for each array its mask, as two huffman
+	// coded bytes, and the elements, the three alternate ammo values
+	// included
+	playerArraysMaxBits = 0;
+	if ( msgHuffMaxLength ) {
+		playerArraysMaxBits = 5 + msgHuffMaxLength *
+			( 2 + MAX_STATS * 2 + 2 + MAX_PERSISTANT * 2 + 2 + 3 * 2 + 2 + MAX_MISC * 4 );
+	}
+}
+
+/*
+=================
+MSG_ChangedPlayerArrays
+=================
+*/
+static void MSG_ChangedPlayerArrays( playerState_t *from, playerState_t *to,
+	int *statsbits, int *persistantbits, int *miscbits ) {
+	const int	*a = from->stats;
+	const int	*b = to->stats;
+	uint64_t	changed = 0;
+	int			i = 0;
+
+	assert( to->persistant == to->stats + MAX_STATS && to->misc == to->persistant + MAX_PERSISTANT );
+
+#if idx64
+	for ( ; i + 4 <= PS_ARRAY_WORDS; i += 4 ) {
+		__m128i	eq = _mm_cmpeq_epi32( _mm_loadu_si128( (const __m128i *)( a + i ) ),
+			_mm_loadu_si128( (const __m128i *)( b + i ) ) );
+		changed |= (uint64_t)( ~_mm_movemask_ps( _mm_castsi128_ps( eq ) ) & 0xf ) << i;
+	}
+#endif
+	for ( ; i < PS_ARRAY_WORDS; i++ ) {
+		changed |= (uint64_t)( a[i] != b[i] ) << i;
+	}
+
+	*statsbits = changed & ( ( 1 << MAX_STATS ) - 1 );
+	*persistantbits = ( changed >> MAX_STATS ) & ( ( 1 << MAX_PERSISTANT ) - 1 );
+	*miscbits = ( changed >> ( MAX_STATS + MAX_PERSISTANT ) ) & ( ( 1 << MAX_MISC ) - 1 );
+}
+
+/*
+=================
+MSG_PutPlayerArray
+
+One array with its changed mask, each element in elementBits
+=================
+*/
+static ID_INLINE void MSG_PutPlayerArray( bitWriter_t *w, const int *values, int changed,
+	int maskBits, int elementBits ) {
+	int		i;
+
+	if ( !changed ) {
+		MSG_PutBits( w, 0, 1 );		// no change
+		return;
+	}
+
+	MSG_PutBits( w, 1, 1 );			// changed
+	MSG_PutHuffBits( w, changed, maskBits );
+	for ( i = 0; changed; i++, changed >>= 1 ) {
+		if ( changed & 1 ) {
+			MSG_PutHuffBits( w, (unsigned int)values[i] & ( 0xffffffff >> ( 32 - elementBits ) ), elementBits );
+		}
+	}
+}
+
+/*
+=================
+MSG_WritePlayerArrays
+
+The arrays part of MSG_WriteDeltaPlayerstate with precomputed huffman
+codes, there must be room for playerArraysMaxBits more bits
+=================
+*/
+static void MSG_WritePlayerArrays( int alternateProtocol, msg_t *msg, playerState_t *to,
+	int statsbits, int persistantbits, int ammobits, const int *altToAmmo, int miscbits ) {
+	bitWriter_t	w;
+
+	w.data = msg->data;
+	w.bit = msg->bit;
+	w.pending = 0;
+	w.pendingBits = 0;
+
+	MSG_PutBits( &w, 1, 1 );	// changed
+	MSG_PutPlayerArray( &w, to->stats, statsbits, MAX_STATS, 16 );
+	MSG_PutPlayerArray( &w, to->persistant, persistantbits, MAX_PERSISTANT, 16 );
+	if ( alternateProtocol == 2 ) {
+		MSG_PutPlayerArray( &w, altToAmmo, ammobits, 16, 16 );
+	}
+	MSG_PutPlayerArray( &w, to->misc, miscbits, MAX_MISC, 32 );
+	MSG_FlushBits( &w );
+
+	msg->bit = w.bit;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
 /*
 =============
 MSG_WriteDeltaPlayerstate
@@ -1374,18 +1759,7 @@ void MSG_WriteDeltaPlayerstate( int alternateProtocol, msg_t *msg, struct player
 	//
 	// send the arrays
 	//
-	statsbits = 0;
-	for (i=0 ; i<MAX_STATS ; i++) {
-		if (to->stats[i] != from->stats[i]) {
-			statsbits |= 1<<i;
-		}
-	}
-	persistantbits = 0;
-	for (i=0 ; i<MAX_PERSISTANT ; i++) {
-		if (to->persistant[i] != from->persistant[i]) {
-			persistantbits |= 1<<i;
-		}
-	}
+	MSG_ChangedPlayerArrays( from, to, &statsbits, &persistantbits, &miscbits );
 	if ( alternateProtocol == 2 ) {
 		altFromAmmo[0] = ( from->weaponAnim & 0xFF ) | ( ( from->pm_flags >> 8 ) & 0xFF00 );
 		altFromAmmo[1] = ( from->ammo & 0xFFF ) | ( ( from->clips << 12 ) & 0xF000 );
@@ -1402,18 +1776,20 @@ void MSG_WriteDeltaPlayerstate( int alternateProtocol, msg_t *msg, struct player
 	} else {
 		ammobits = 0;
 	}
-	miscbits = 0;
-	for (i=0 ; i<MAX_MISC ; i++) {
-		if (to->misc[i] != from->misc[i]) {
-			miscbits |= 1<<i;
-		}
-	}
 
 	if (!statsbits && !persistantbits && !ammobits && !miscbits) {
 		MSG_WriteBits( msg, 0, 1 );	// no change
 		oldsize += 4;
 		return;
 	}
+
+	if ( playerArraysMaxBits && !msg->oob && !msg->overflowed &&
+		msg->bit + playerArraysMaxBits <= msg->maxsize << 3 ) {
+		MSG_WritePlayerArrays( alternateProtocol, msg, to, statsbits, persistantbits,
+			ammobits, altToAmmo, miscbits );
+		return;
+	}
+
 	MSG_WriteBits( msg, 1, 1 );	// changed
 
 	if ( statsbits ) {
@@ -2005,6 +2381,10 @@ void MSG_initHuffman( void ) {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+
+	MSG_InitHuffmanCodes( );
+	MSG_InitEntityFields( );
+	MSG_InitPlayerArrays( );
 }
 
 /*
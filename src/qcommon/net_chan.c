@@ -53,6 +53,7 @@ to the new value before sending out any replies.
 
 #define	FRAGMENT_SIZE			(MAX_PACKETLEN - 100)
 #define	PACKET_HEADER			10			// two ints and a short
+#define	MAX_PACKET_HEADER		14			// with the qport and fragment start and length
 
 #define	FRAGMENT_BIT	(1<<31)
 
@@ -98,6 +99,20 @@ void Netchan_Setup(int alternateProtocol, netsrc_t sock, netchan_t *chan, netadr
 	chan->alternateProtocol = alternateProtocol;
 }
 
+/*
+=================
+Netchan_ReleaseBuffer
+
+Lets go of the message buffer fragments were being sent from
+=================
+*/
+void Netchan_ReleaseBuffer( netchan_t *chan ) {
+	if ( chan->unsentNetBuffer ) {
+		NET_ReleaseBuffer( chan->unsentNetBuffer );
+		chan->unsentNetBuffer = NULL;
+	}
+}
+
 /*
 =================
 Netchan_TransmitNextFragment
@@ -107,7 +122,8 @@ Send one fragment of the current message
 */
 void Netchan_TransmitNextFragment( netchan_t *chan ) {
 	msg_t		send;
-	byte		send_buf[MAX_PACKETLEN];
+	byte		send_buf[MAX_PACKET_HEADER];
+	const byte	*unsent;
 	int			fragmentLength;
 	int			outgoingSequence;
 
@@ -133,19 +149,20 @@ void Netchan_TransmitNextFragment( netchan_t *chan ) {
 
 	MSG_WriteShort( &send, chan->unsentFragmentStart );
 	MSG_WriteShort( &send, fragmentLength );
-	MSG_WriteData( &send, chan->unsentBuffer + chan->unsentFragmentStart, fragmentLength );
 
-	// send the datagram
-	NET_SendPacket(chan->sock, send.cursize, send.data, chan->remoteAddress);
+	// send the datagram, the fragment straight from where the message is
+	unsent = chan->unsentNetBuffer ? chan->unsentNetBuffer->data : chan->unsentBuffer;
+	NET_SendPacketParts( chan->sock, send.cursize, send.data,
+		fragmentLength, unsent + chan->unsentFragmentStart, chan->remoteAddress );
 	
 	// Store send time and size of this packet for rate control
 	chan->lastSentTime = Sys_Milliseconds();
-	chan->lastSentSize = send.cursize;
+	chan->lastSentSize = send.cursize + fragmentLength;
 
 	if ( showpackets->integer ) {
 		Com_Printf ("%s send %4i : s=%i fragment=%i,%i\n"
 			, netsrcString[ chan->sock ]
-			, send.cursize
+			, chan->lastSentSize
 			, chan->outgoingSequence
 			, chan->unsentFragmentStart, fragmentLength);
 	}
@@ -159,32 +176,37 @@ void Netchan_TransmitNextFragment( netchan_t *chan ) {
 	if ( chan->unsentFragmentStart == chan->unsentLength && fragmentLength != FRAGMENT_SIZE ) {
 		chan->outgoingSequence++;
 		chan->unsentFragments = qfalse;
+		Netchan_ReleaseBuffer( chan );
 	}
 }
 
-
 /*
 ===============
-Netchan_Transmit
+Netchan_TransmitData
 
-Sends a message to a connection, fragmenting if necessary
-A 0 length will still generate a packet.
+Fragmented messages are sent from buf if there is one, or copied
 ================
 */
-void Netchan_Transmit( netchan_t *chan, int length, const byte *data ) {
+static void Netchan_TransmitData( netchan_t *chan, int length, const byte *data, netBuffer_t *buf ) {
 	msg_t		send;
-	byte		send_buf[MAX_PACKETLEN];
+	byte		send_buf[MAX_PACKET_HEADER];
 
 	if ( length > MAX_MSGLEN ) {
 		Com_Error( ERR_DROP, "Netchan_Transmit: length = %i", length );
 	}
 	chan->unsentFragmentStart = 0;
+	Netchan_ReleaseBuffer( chan );
 
 	// fragment large reliable messages
 	if ( length >= FRAGMENT_SIZE ) {
 		chan->unsentFragments = qtrue;
 		chan->unsentLength = length;
-		Com_Memcpy( chan->unsentBuffer, data, length );
+		if ( buf ) {
+			NET_RetainBuffer( buf );
+			chan->unsentNetBuffer = buf;
+		} else {
+			Com_Memcpy( chan->unsentBuffer, data, length );
+		}
 
 		// only send the first fragment now
 		Netchan_TransmitNextFragment( chan );
@@ -206,24 +228,46 @@ void Netchan_Transmit( netchan_t *chan, int length, const byte *data ) {
 
 	chan->outgoingSequence++;
 
-	MSG_WriteData( &send, data, length );
-
 	// send the datagram
-	NET_SendPacket( chan->sock, send.cursize, send.data, chan->remoteAddress );
+	NET_SendPacketParts( chan->sock, send.cursize, send.data, length, data, chan->remoteAddress );
 
 	// Store send time and size of this packet for rate control
 	chan->lastSentTime = Sys_Milliseconds();
-	chan->lastSentSize = send.cursize;
+	chan->lastSentSize = send.cursize + length;
 
 	if ( showpackets->integer ) {
 		Com_Printf( "%s send %4i : s=%i ack=%i\n"
 			, netsrcString[ chan->sock ]
-			, send.cursize
+			, chan->lastSentSize
 			, chan->outgoingSequence - 1
 			, chan->incomingSequence );
 	}
 }
 
+/*
+===============
+Netchan_Transmit
+
+Sends a message to a connection, fragmenting if necessary
+A 0 length will still generate a packet.
+================
+*/
+void Netchan_Transmit( netchan_t *chan, int length, const byte *data ) {
+	Netchan_TransmitData( chan, length, data, NULL );
+}
+
+/*
+===============
+Netchan_TransmitBuffer
+
+Netchan_Transmit for a pooled message, which is held on to instead of
+copied while its fragments go out
+================
+*/
+void Netchan_TransmitBuffer( netchan_t *chan, netBuffer_t *buf ) {
+	Netchan_TransmitData( chan, buf->msg.cursize, buf->data, buf );
+}
+
 /*
 =================
 Netchan_Process
@@ -529,8 +573,125 @@ void NET_FlushPacketQueue(void)
 	}
 }
 
+/*
+=============================================================================
+
+MESSAGE BUFFERS
+
+=============================================================================
+*/
+
+#define	NET_BUFFER_BLOCK	8		// buffers the pool grows by
+
+static netBuffer_t	*net_freeBuffers;
+static int			net_buffersAllocated;
+static int			net_buffersInUse;
+static int			net_bufferRequests;
+
+/*
+=================
+NET_AllocBuffer
+
+An empty message buffer with one reference, the pool grows as needed
+and never shrinks
+=================
+*/
+netBuffer_t *NET_AllocBuffer( void ) {
+	netBuffer_t	*buf;
+	int			i;
+
+	if ( !net_freeBuffers ) {
+		buf = Z_Malloc( NET_BUFFER_BLOCK * sizeof( *buf ) );
+		for ( i = 0; i < NET_BUFFER_BLOCK; i++ ) {
+			buf[i].next = net_freeBuffers;
+			net_freeBuffers = &buf[i];
+		}
+		net_buffersAllocated += NET_BUFFER_BLOCK;
+	}
+
+	buf = net_freeBuffers;
+	net_freeBuffers = buf->next;
+	net_buffersInUse++;
+	net_bufferRequests++;
+
+	buf->next = NULL;
+	buf->refCount = 1;
+	MSG_Init( &buf->msg, buf->data, sizeof( buf->data ) );
+	return buf;
+}
+
+/*
+=================
+NET_RetainBuffer
+=================
+*/
+void NET_RetainBuffer( netBuffer_t *buf ) {
+	buf->refCount++;
+}
+
+/*
+=================
+NET_ReleaseBuffer
+
+Returns the buffer to the pool once the last reference is gone
+=================
+*/
+void NET_ReleaseBuffer( netBuffer_t *buf ) {
+	if ( buf->refCount <= 0 ) {
+		Com_Error( ERR_FATAL, "NET_ReleaseBuffer: buffer not in use" );
+	}
+	if ( --buf->refCount ) {
+		return;
+	}
+
+	buf->next = net_freeBuffers;
+	net_freeBuffers = buf;
+	net_buffersInUse--;
+}
+
+/*
+=================
+NET_BufferStats
+
+Buffers allocated for the pool, in use, and handed out since the last call
+=================
+*/
+void NET_BufferStats( int *allocated, int *inUse, int *requests ) {
+	*allocated = net_buffersAllocated;
+	*inUse = net_buffersInUse;
+	*requests = net_bufferRequests;
+	net_bufferRequests = 0;
+}
+
+//=============================================================================
+
+static qboolean	net_discardPackets;
+static int		net_discardedPackets;
+
+/*
+=================
+NET_DiscardPackets
+
+While enabled, packets are counted and thrown away instead of sent, so
+benchmarks can feed made up traffic through the real handlers. Returns
+the number of packets discarded since it was last enabled.
+=================
+*/
+int NET_DiscardPackets( qboolean discard ) {
+	int		discarded = net_discardedPackets;
+
+	net_discardPackets = discard;
+	net_discardedPackets = 0;
+	return discarded;
+}
+
 void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to ) {
 
+	if ( net_discardPackets ) {
+		net_discardedPackets++;
+		return;
+	}
+
 	// sequenced packets are shown in netchan, so just show oob
 	if ( showpackets->integer && *(int *)data == -1 )	{
 		Com_Printf ("send packet %4i\n", length);
@@ -555,6 +716,40 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to )
 	}
 }
 
+/*
+=================
+NET_SendPacketParts
+
+Sends header and data as one packet, joining them only where the
+packet gets copied anyway
+=================
+*/
+void NET_SendPacketParts( netsrc_t sock, int headerLength, const void *header, int length, const void *data, netadr_t to ) {
+	byte	packet[MAX_PACKETLEN];
+
+	if ( net_discardPackets ) {
+		net_discardedPackets++;
+		return;
+	}
+
+	if ( to.type == NA_LOOPBACK ||
+		( sock == NS_CLIENT && cl_packetdelay->integer > 0 ) ||
+		( sock == NS_SERVER && sv_packetdelay->integer > 0 ) ) {
+		if ( headerLength + length > (int)sizeof( packet ) ) {
+			Com_Error( ERR_DROP, "NET_SendPacketParts: length = %i", headerLength + length );
+		}
+		Com_Memcpy( packet, header, headerLength );
+		Com_Memcpy( packet + headerLength, data, length );
+		NET_SendPacket( sock, headerLength + length, packet, to );
+		return;
+	}
+	if ( to.type == NA_BAD ) {
+		return;
+	}
+
+	Sys_SendPacketParts( headerLength, header, length, data, to );
+}
+
 /*
 ===============
 NET_OutOfBandPrint
@@ -74,6 +74,7 @@ static qboolean	winsockInitialized = qfalse;
 #	include <sys/ioctl.h>
 #	include <sys/types.h>
 #	include <sys/time.h>
+#	include <sys/uio.h>
 #	include <unistd.h>
 #	if !defined(__sun) && !defined(__sgi)
 #		include <ifaddrs.h>
@@ -658,12 +659,66 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 
 static char socksBuf[4096];
 
+/*
+==================
+NET_SendTo
+
+sendto with the packet in two parts, gathered by the socket layer
+==================
+*/
+static int NET_SendTo( SOCKET s, int headerLength, const void *header, int length, const void *data,
+	const struct sockaddr *addr, socklen_t addrlen ) {
+#ifdef _WIN32
+	WSABUF	bufs[2];
+	DWORD	sent;
+	int		count = 0;
+
+	if( headerLength ) {
+		bufs[count].buf = (char *)header;
+		bufs[count++].len = headerLength;
+	}
+	bufs[count].buf = (char *)data;
+	bufs[count++].len = length;
+
+	if( WSASendTo( s, bufs, count, &sent, 0, addr, addrlen, NULL, NULL ) == SOCKET_ERROR )
+		return SOCKET_ERROR;
+	return sent;
+#else
+	struct iovec	iov[2];
+	struct msghdr	msg;
+
+	memset( &msg, 0, sizeof( msg ) );
+	if( headerLength ) {
+		iov[msg.msg_iovlen].iov_base = (void *)header;
+		iov[msg.msg_iovlen++].iov_len = headerLength;
+	}
+	iov[msg.msg_iovlen].iov_base = (void *)data;
+	iov[msg.msg_iovlen++].iov_len = length;
+	msg.msg_iov = iov;
+	msg.msg_name = (void *)addr;
+	msg.msg_namelen = addrlen;
+
+	return sendmsg( s, &msg, 0 );
+#endif
+}
+
 /*
 ==================
 Sys_SendPacket
 ==================
 */
 void Sys_SendPacket( int length, const void *data, netadr_t to ) {
+	Sys_SendPacketParts( 0, NULL, length, data, to );
+}
+
+/*
+==================
+Sys_SendPacketParts
+
+Sends header and data as one datagram without joining them first
+==================
+*/
+void Sys_SendPacketParts( int headerLength, const void *header, int length, const void *data, netadr_t to ) {
 	int				ret = SOCKET_ERROR;
 	struct sockaddr_storage	addr;
 
@@ -692,14 +747,16 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 		socksBuf[3] = 1;	// address type: IPV4
 		*(int *)&socksBuf[4] = ((struct sockaddr_in *)&addr)->sin_addr.s_addr;
 		*(short *)&socksBuf[8] = ((struct sockaddr_in *)&addr)->sin_port;
-		memcpy( &socksBuf[10], data, length );
-		ret = sendto( ip_sockets[to.alternateProtocol], socksBuf, length+10, 0, &socksRelayAddr, sizeof(socksRelayAddr) );
+		if( headerLength )
+			memcpy( &socksBuf[10], header, headerLength );
+		memcpy( &socksBuf[10 + headerLength], data, length );
+		ret = sendto( ip_sockets[to.alternateProtocol], socksBuf, headerLength+length+10, 0, &socksRelayAddr, sizeof(socksRelayAddr) );
 	}
 	else {
 		if(addr.ss_family == AF_INET)
-			ret = sendto( ip_sockets[to.alternateProtocol], data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in) );
+			ret = NET_SendTo( ip_sockets[to.alternateProtocol], headerLength, header, length, data, (struct sockaddr *) &addr, sizeof(struct sockaddr_in) );
 		else if(addr.ss_family == AF_INET6)
-			ret = sendto( ip6_sockets[to.alternateProtocol], data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6) );
+			ret = NET_SendTo( ip6_sockets[to.alternateProtocol], headerLength, header, length, data, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6) );
 	}
 	if( ret == SOCKET_ERROR ) {
 		int err = socketError;
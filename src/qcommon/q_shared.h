@@ -1228,9 +1228,7 @@ struct cvar_s {
 
 	cvar_t *next;
 	cvar_t *prev;
-	cvar_t *hashNext;
-	cvar_t *hashPrev;
-	int			hashIndex;
+	unsigned int	hashValue;
 };
 
 #define	MAX_CVAR_VALUE_STRING	256
@@ -1239,6 +1237,9 @@ struct cvar_s {
 
 typedef int	cvarHandle_t;
 
+// cvar handles are indexes below MAX_CVARS
+#define	MAX_CVARS	2048
+
 // the modules that run in the virtual machine can't access the cvar_t directly,
 // so they must ask for structured updates
 typedef struct {
@@ -179,6 +179,8 @@ void		NET_Restart_f( void );
 void		NET_Config( qboolean enableNetworking );
 void		NET_FlushPacketQueue(void);
 void		NET_SendPacket (netsrc_t sock, int length, const void *data, netadr_t to);
+void		NET_SendPacketParts( netsrc_t sock, int headerLength, const void *header, int length, const void *data, netadr_t to );
+int		NET_DiscardPackets( qboolean discard );
 void		QDECL NET_OutOfBandPrint( netsrc_t net_socket, netadr_t adr, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
 void		QDECL NET_OutOfBandData( netsrc_t sock, netadr_t adr, byte *format, int len );
 
@@ -204,6 +206,23 @@ void		NET_Sleep(int msec);
 
 #define NETCHAN_GENCHECKSUM(challenge, sequence) ((challenge) ^ ((sequence) * (challenge)))
 
+/*
+Reference counted message buffers from a pool, so a message can be
+queued and fragmented without being copied along the way
+*/
+
+typedef struct netBuffer_s {
+	struct netBuffer_s	*next;		// send queue or free list
+	int			refCount;
+	msg_t		msg;
+	byte		data[MAX_MSGLEN];
+} netBuffer_t;
+
+netBuffer_t	*NET_AllocBuffer( void );
+void		NET_RetainBuffer( netBuffer_t *buf );
+void		NET_ReleaseBuffer( netBuffer_t *buf );
+void		NET_BufferStats( int *allocated, int *inUse, int *requests );
+
 /*
 Netchan handles packet fragmentation and out of order / duplicate suppression
 */
@@ -232,6 +251,7 @@ typedef struct {
 	int			unsentFragmentStart;
 	int			unsentLength;
 	byte		unsentBuffer[MAX_MSGLEN];
+	netBuffer_t	*unsentNetBuffer;	// sent from instead of unsentBuffer if set
 
 	int			challenge;
 	int		lastSentTime;
@@ -242,7 +262,9 @@ void Netchan_Init( int qport );
 void Netchan_Setup(int alternateProtocol, netsrc_t sock, netchan_t *chan, netadr_t adr, int port, int challenge);
 
 void Netchan_Transmit( netchan_t *chan, int length, const byte *data );
+void Netchan_TransmitBuffer( netchan_t *chan, netBuffer_t *buf );
 void Netchan_TransmitNextFragment( netchan_t *chan );
+void Netchan_ReleaseBuffer( netchan_t *chan );
 
 qboolean Netchan_Process( netchan_t *chan, msg_t *msg );
 
@@ -505,6 +527,9 @@ void	Cvar_Register( vmCvar_t *vmCvar, const char *varName, const char *defaultVa
 void	Cvar_Update( vmCvar_t *vmCvar );
 // updates an interpreted modules' version of a cvar
 
+int		Cvar_ChangedHandles( int *sequence, cvarHandle_t *handles, int maxHandles );
+// handles of the cvars modified since *sequence, -1 if everything must be rechecked
+
 void 	Cvar_Set( const char *var_name, const char *value );
 // will create the variable with no flags if it doesn't exist
 
@@ -709,6 +734,9 @@ const char *FS_ReferencedPakPureChecksums( void );
 // AND referenced pk3 files. Servers with sv_pure set will get this string
 // back from clients for pure validation
 
+const char *FS_ReferencedPakPath( const char *pakName );
+// Returns the OS path of a referenced pk3 named "gamedir/basename", or NULL
+
 void FS_ClearPakReferences( int flags );
 // clears referenced booleans on loaded pk3s
 
@@ -925,6 +953,7 @@ void *S_Malloc( int size );			// NOT 0 filled memory only for small allocations
 void Z_Free( void *ptr );
 void Z_FreeTags( int tag );
 int Z_AvailableMemory( void );
+int Z_Allocations( void );
 void Z_LogHeap( void );
 
 void Hunk_Clear( void );
@@ -1075,6 +1104,7 @@ cpuFeatures_t Sys_GetProcessorFeatures( void );
 void	Sys_SetErrorText( const char *text );
 
 void	Sys_SendPacket( int length, const void *data, netadr_t to );
+void	Sys_SendPacketParts( int headerLength, const void *header, int length, const void *data, netadr_t to );
 
 qboolean	Sys_StringToAdr( const char *s, netadr_t *a, netadrtype_t family );
 //Does NOT parse port numbers, only base addresses.
@@ -1085,6 +1115,10 @@ void		Sys_ShowIP(void);
 FILE	*Sys_FOpen( const char *ospath, const char *mode );
 qboolean Sys_Mkdir( const char *path );
 FILE	*Sys_Mkfifo( const char *ospath );
+void	*Sys_MapFile( const char *ospath, int *size );
+void	Sys_UnmapFile( void *base, int size );
+qboolean Sys_FileStat( const char *ospath, int64_t *size, int64_t *mtime );
+int		Sys_PID( void );
 void	Sys_SetBinaryPath(const char *path);
 char	*Sys_BinaryPath(void);
 void	Sys_SetDefaultInstallPath(const char *path);
@@ -1106,6 +1140,16 @@ void	Sys_Sleep(int msec);
 
 qboolean Sys_LowPhysicalMemory( void );
 
+// worker threads must not call into the engine (zone, cvars, console...)
+typedef void (*sysThreadFunc_t)( void *arg );
+void	*Sys_CreateThread( sysThreadFunc_t func, void *arg );
+void	Sys_JoinThread( void *thread );
+int		Sys_ProcessorCount( void );
+void	*Sys_CreateMutex( void );
+void	Sys_DestroyMutex( void *mutex );
+void	Sys_LockMutex( void *mutex );
+void	Sys_UnlockMutex( void *mutex );
+
 typedef enum
 {
 	DR_YES = 0,
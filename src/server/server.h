@@ -66,6 +66,7 @@ typedef struct svEntity_s {
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
 	int			snapshotCounter;	// used to prevent double adding from portal views
+	int			snapshotEntity;		// last shared copy of its state in svs.snapshotEntities
 } svEntity_t;
 
 typedef enum {
@@ -79,6 +80,8 @@ typedef struct configString_s {
 
 	qboolean			restricted; // if true, don't send to clientList
 	clientList_t	clientList;
+
+	char					*commands[3];	// cs or bcs commands per alternateProtocol, built when first sent
 } configString_t;
 
 typedef struct {
@@ -118,8 +121,8 @@ typedef struct {
 	int				areabytes;
 	byte			areabits[MAX_MAP_AREA_BYTES];		// portalarea visibility bits
 	playerState_t	ps;
-	int				num_entities;
-	int				first_entity;		// into the circular sv_packet_entities[]
+	int				num_entities;		// -1 if the entities had to be reclaimed
+	int				entities[MAX_SNAPSHOT_ENTITIES];	// into svs.snapshotEntities[]
 										// the entities MUST be in increasing state number
 										// order, otherwise the delta compression will fail
 	int				messageSent;		// time the message was transmitted
@@ -136,12 +139,6 @@ typedef enum {
 	CS_ACTIVE		// client is fully in game
 } clientState_t;
 
-typedef struct netchan_buffer_s {
-	msg_t           msg;
-	byte            msgBuffer[MAX_MSGLEN];
-	struct netchan_buffer_s *next;
-} netchan_buffer_t;
-
 typedef struct client_s {
 	clientState_t	state;
 	char			userinfo[MAX_INFO_STRING];		// name, etc
@@ -186,6 +183,7 @@ typedef struct client_s {
 	qboolean		rateDelayed;		// true if nextSnapshotTime was set based on rate instead of snapshotMsec
 	int				timeoutCount;		// must timeout a few frames in a row so debugging doesn't break
 	clientSnapshot_t	frames[PACKET_BACKUP];	// updates can be delta'd from here
+	byte			snapshotDeferred[MAX_GENTITIES];	// snapshots in a row an entity was held back from
 	int				ping;
 	int				rate;				// bytes / second
 	int				snapshotMsec;		// requests a snapshot every snapshotMsec unless rate choked
@@ -196,8 +194,8 @@ typedef struct client_s {
 	// queuing outgoing fragmented messages to send them properly, without udp packet bursts
 	// in case large fragmented messages are stacking up
 	// buffer them into this queue, and hand them out to netchan as needed
-	netchan_buffer_t *netchan_start_queue;
-	netchan_buffer_t **netchan_end_queue;
+	netBuffer_t		*netchan_start_queue;
+	netBuffer_t		**netchan_end_queue;
 
 #ifdef USE_VOIP
 	qboolean hasVoip;
@@ -232,6 +230,20 @@ typedef struct
 	float avg;
 } svstats_t;
 
+/**
+ * @struct svProtocolStats_t
+ * @brief what the clients on one alternateProtocol cost, see protocolstats
+ */
+typedef struct
+{
+	int snapshots;
+	double snapshotBytes;
+	int snapshotMsec;        ///< summed Sys_Milliseconds differences
+	int gamestates;
+	int configstrings;       ///< configstring updates sent
+	int configstringsBuilt;  ///< the rest reused the shared commands
+} svProtocolStats_t;
+
 // MAX_CHALLENGES is made large to prevent a denial
 // of service attack that could cycle all of them
 // out before legitimate users connected
@@ -262,6 +274,7 @@ typedef struct
 {
 	netadr_t adr;
 	int time;
+	int hash;	// into svs.infoReceiptCounts
 } receipt_t;
 
 /**
@@ -271,6 +284,12 @@ typedef struct
  */
 #define MAX_INFO_RECEIPTS  48
 
+/**
+ * @def MAX_INFO_RECEIPT_HASHES
+ * @brief size of the table counting recent receipts by address hash
+ */
+#define MAX_INFO_RECEIPT_HASHES  256
+
 /**
  * @struct tempBan_s
  * @typedef tempBan_t
@@ -287,6 +306,13 @@ typedef struct tempBan_s
 #define SERVER_PERFORMANCECOUNTER_FRAMES    600
 #define SERVER_PERFORMANCECOUNTER_SAMPLES   6
 
+// an entity state shared by all the client frames that saw it
+typedef struct {
+	entityState_t	s;
+	int				refCount;			// client frames holding it, 0 if free
+	int				nextFree;
+} snapshotEntity_t;
+
 // this structure will be cleared only when the game dll changes
 typedef struct {
 	qboolean	initialized;				// sv_init has completed
@@ -296,12 +322,15 @@ typedef struct {
 	int			snapFlagServerBit;			// ^= SNAPFLAG_SERVERCOUNT every SV_SpawnServer()
 
 	client_t	*clients;					// [sv_maxclients->integer];
-	int			numSnapshotEntities;		// sv_maxclients->integer*PACKET_BACKUP*MAX_SNAPSHOT_ENTITIES
-	int			nextSnapshotEntities;		// next snapshotEntities to use
-	entityState_t	*snapshotEntities;		// [numSnapshotEntities]
+	int			numSnapshotEntities;		// see SV_SnapshotEntitiesForClients
+	int			freeSnapshotEntities;		// first unused snapshotEntities, -1 if none
+	snapshotEntity_t	*snapshotEntities;	// [numSnapshotEntities]
 	int			nextHeartbeatTime;
 	challenge_t	challenges[MAX_CHALLENGES];	// to prevent invalid IPs from connecting
 	receipt_t	infoReceipts[MAX_INFO_RECEIPTS];
+	int			infoReceiptHead;			// oldest receipt, the next to be reused
+	int			infoReceiptsLive;			// receipts sent in the last two seconds
+	byte		infoReceiptCounts[MAX_INFO_RECEIPT_HASHES];	// live receipts by address hash
 	netadr_t	redirectAddress;			// for rcon return messages
 
 	netadr_t	authorizeAddress;			// for rcon return messages
@@ -312,6 +341,7 @@ typedef struct {
 	int currentFrameIndex;
 	int serverLoad;
 	svstats_t stats;
+	svProtocolStats_t protocolStats[3];	// per alternateProtocol
 } serverStatic_t;
 
 //=============================================================================
@@ -345,7 +375,13 @@ extern	cvar_t	*sv_minPing;
 extern	cvar_t	*sv_maxPing;
 extern	cvar_t	*sv_pure;
 extern	cvar_t	*sv_lanForceRate;
+extern	cvar_t	*sv_snapshotPriority;
 extern	cvar_t	*sv_banFile;
+extern	cvar_t	*sv_dlURL;
+extern	cvar_t	*sv_alternatePaks;
+extern	cvar_t	*sv_alternatePakNames;
+extern	cvar_t	*sv_referencedAlternatePaks;
+extern	cvar_t	*sv_referencedAlternatePakNames;
 
 extern	cvar_t *sv_protect;
 extern	cvar_t *sv_protectLog;
@@ -375,6 +411,7 @@ struct leakyBucket_s {
 	long					hash;
 
 	leakyBucket_t *prev, *next;
+	leakyBucket_t *lruPrev, *lruNext;
 };
 
 extern leakyBucket_t outboundLeakyBucket;
@@ -391,8 +428,17 @@ void SV_RemoveOperatorCommands (void);
 
 
 void SV_MasterShutdown (void);
+#define UDPIP_HEADER_SIZE 28
+#define UDPIP6_HEADER_SIZE 48
+
+int SV_ClientRate(client_t *client);
 int SV_RateMsec(client_t *client);
 
+void SV_FloodBenchmark_f( void );
+
+void SV_InvalidateStatusCache( void );
+void SV_CheckStatusCache( void );
+
 
 
 //
@@ -420,6 +466,13 @@ void      SV_ChangeMaxClients( void );
 void      SV_SpawnServer( char *server, qboolean killBots );
 void      SV_WriteAttackLog(const char *log);
 
+typedef struct {
+	int		lastTime;
+	int		suppressed;
+} attackLogLimit_t;
+
+qboolean  SV_AttackLogAllowed(attackLogLimit_t *limit);
+
 #ifdef NDEBUG
 #define SV_WriteAttackLogD(x)
 #else
@@ -451,6 +504,27 @@ int SV_SendQueuedMessages(void);
 void SV_SendClientGameState( client_t *client );
 
 
+//
+// sv_http.c
+//
+void SV_HTTP_Init( void );
+void SV_HTTP_Shutdown( void );
+void SV_HTTP_Frame( void );
+void SV_HTTP_UpdatePaks( void );
+const char *SV_HTTP_BaseURL( void );
+
+//
+// sv_demo.c
+//
+void SV_DemoConfigstring( int index );
+void SV_DemoServerCommand( client_t *cl, const char *cmd );
+void SV_DemoFrame( void );
+void SV_DemoStopRecord( void );
+void SV_DemoRecord_f( void );
+void SV_DemoStopRecord_f( void );
+void SV_DemoView_f( void );
+void SV_DemoBenchmark_f( void );
+
 //
 // sv_ccmds.c
 //
@@ -462,9 +536,15 @@ void SV_Heartbeat_f( void );
 void SV_AddServerCommand( client_t *client, const char *cmd );
 void SV_UpdateServerCommandsToClient( client_t *client, msg_t *msg );
 void SV_WriteFrameToClient (client_t *client, msg_t *msg);
-void SV_SendMessageToClient( msg_t *msg, client_t *client );
+void SV_SendMessageToClient( netBuffer_t *buf, client_t *client );
 void SV_SendClientMessages( void );
+int SV_SnapshotEntitiesForClients( int maxclients );
+void SV_InitSnapshotEntities( void );
+void SV_ReleaseClientSnapshots( client_t *client );
+int SV_ShareSnapshotEntity( clientSnapshot_t *building, int entnum );
+void SV_ReleaseSnapshotEntity( int index );
 void SV_SendClientSnapshot( client_t *client );
+void SV_SendBenchmarkSnapshot( client_t *client, const int *entityNums, int numEntities );
 
 //
 // sv_game.c
@@ -551,7 +631,7 @@ void SV_ClipToTestArea(
 //
 // sv_net_chan.c
 //
-void SV_Netchan_Transmit( client_t *client, msg_t *msg);
+void SV_Netchan_Transmit( client_t *client, netBuffer_t *buf );
 int SV_Netchan_TransmitNextFragment(client_t *client);
 qboolean SV_Netchan_Process( client_t *client, msg_t *msg );
 void SV_Netchan_FreeQueue(client_t *client);
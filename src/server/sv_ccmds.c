@@ -303,6 +303,54 @@ static void SV_Status_f(void)
 	Com_Printf("\n");
 }
 
+/*
+===========
+SV_ProtocolStats_f
+
+How many clients are on each protocol and what they have cost since the
+server started or "protocolstats reset"
+===========
+*/
+static void SV_ProtocolStats_f( void ) {
+	static const int	versions[3] = { PROTOCOL_VERSION, 70, 69 };
+	svProtocolStats_t	*stats;
+	client_t			*cl;
+	int					i, j, clients;
+
+	// make sure server is running
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( svs.protocolStats, 0, sizeof( svs.protocolStats ) );
+		return;
+	}
+
+	Com_Printf( "protocol clients snapshots  bytes/snap  snap msec  msec/1000 snaps  gamestates  cs updates (built)\n"
+	            "-------- ------- ---------- ---------- ---------- ---------------- ---------- -------------------\n" );
+
+	for ( i = 0; i < 3; i++ ) {
+		stats = &svs.protocolStats[i];
+
+		clients = 0;
+		for ( j = 0, cl = svs.clients; j < sv_maxclients->integer; j++, cl++ ) {
+			if ( cl->state >= CS_CONNECTED && cl->netchan.alternateProtocol == i ) {
+				clients++;
+			}
+		}
+
+		Com_Printf( "%8i %7i %10i %10i %10i %16.1f %10i %10i (%6i)\n", versions[i],
+			clients, stats->snapshots,
+			stats->snapshots ? (int)( stats->snapshotBytes / stats->snapshots ) : 0,
+			stats->snapshotMsec,
+			stats->snapshots ? stats->snapshotMsec * 1000.0f / stats->snapshots : 0.0f,
+			stats->gamestates,
+			stats->configstrings, stats->configstringsBuilt );
+	}
+}
+
 /*
 ==================
 SV_Heartbeat_f
@@ -390,6 +438,7 @@ void SV_AddOperatorCommands( void ) {
 
 	Cmd_AddCommand ("heartbeat", SV_Heartbeat_f);
 	Cmd_AddCommand ("status", SV_Status_f);
+	Cmd_AddCommand ("protocolstats", SV_ProtocolStats_f);
 	Cmd_AddCommand ("serverinfo", SV_Serverinfo_f);
 	Cmd_AddCommand ("systeminfo", SV_Systeminfo_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
@@ -399,6 +448,11 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("devmap", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "devmap", SV_CompleteMapName );
 	Cmd_AddCommand ("killserver", SV_KillServer_f);
+	Cmd_AddCommand ("floodbench", SV_FloodBenchmark_f);
+	Cmd_AddCommand ("svrecord", SV_DemoRecord_f);
+	Cmd_AddCommand ("svstoprecord", SV_DemoStopRecord_f);
+	Cmd_AddCommand ("svdemoview", SV_DemoView_f);
+	Cmd_AddCommand ("snapbench", SV_DemoBenchmark_f);
 }
 
 /*
@@ -66,10 +66,15 @@ void SV_GetChallenge(netadr_t from)
 	if (sv_protect->integer & SVP_IOQ3)
 	{
 		// Prevent using getchallenge as an amplifier
+		static attackLogLimit_t addressLimit, outboundLimit;
+
 		if (SVC_RateLimitAddress(from, 10, 1000))
 		{
-			SV_WriteAttackLog(va("SV_GetChallenge: rate limit from %s exceeded, dropping request\n",
-			                     NET_AdrToString(from)));
+			if (SV_AttackLogAllowed(&addressLimit))
+			{
+				SV_WriteAttackLog(va("SV_GetChallenge: rate limit from %s exceeded, dropping request\n",
+				                     NET_AdrToString(from)));
+			}
 			return;
 		}
 
@@ -77,7 +82,10 @@ void SV_GetChallenge(netadr_t from)
 		// excess outbound bandwidth usage when being flooded inbound
 		if (SVC_RateLimit(&outboundLeakyBucket, 10, 100))
 		{
-			SV_WriteAttackLog("SV_GetChallenge: rate limit exceeded, dropping request\n");
+			if (SV_AttackLogAllowed(&outboundLimit))
+			{
+				SV_WriteAttackLog("SV_GetChallenge: rate limit exceeded, dropping request\n");
+			}
 			return;
 		}
 	}
@@ -331,7 +339,10 @@ void SV_DirectConnect( netadr_t from ) {
 gotnewcl:
 	// build a new connection
 	// accept the new client
-	// this is the only place a client_t is ever initialized
+	// this is the only place a client_t is ever initialized, a client
+	// reconnecting over itself still holds pooled buffers to give back
+	SV_FreeClient( newcl );
+	SV_ReleaseClientSnapshots( newcl );
 	*newcl = temp;
 	clientNum = newcl - svs.clients;
 	ent = SV_GentityNum( clientNum );
@@ -369,6 +380,7 @@ gotnewcl:
 	Com_DPrintf( "Going from CS_FREE to CS_CONNECTED for %s\n", newcl->name );
 
 	newcl->state = CS_CONNECTED;
+	SV_InvalidateStatusCache( );
 	newcl->lastSnapshotTime = 0;
 	newcl->lastPacketTime = svs.time;
 	newcl->lastConnectTime = svs.time;
@@ -446,6 +458,7 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 
 	// Free all allocated data on the client structure
 	SV_FreeClient(drop);
+	SV_ReleaseClientSnapshots(drop);
 
 	// tell everyone why they got dropped
 	SV_SendServerCommand( NULL, "print \"%s" S_COLOR_WHITE " %s\n\"", drop->name, reason );
@@ -462,6 +475,7 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 
 	Com_DPrintf( "Going to CS_ZOMBIE for %s\n", drop->name );
 	drop->state = CS_ZOMBIE;		// become free in a few seconds
+	SV_InvalidateStatusCache( );
 
 	// if this was the last client on the server, send a heartbeat
 	// to the master so it is known the server is empty
@@ -493,8 +507,8 @@ the wrong gamestate.
 void SV_SendClientGameState( client_t *client ) {
 	int			start;
 	entityState_t	*base, nullstate;
-	msg_t		msg;
-	byte		msgBuffer[MAX_MSGLEN];
+	netBuffer_t	*buf;
+	msg_t		*msg;
 	const char	*configstring;
 
  	Com_DPrintf ("SV_SendClientGameState() for %s\n", client->name);
@@ -508,21 +522,22 @@ void SV_SendClientGameState( client_t *client ) {
 	// gamestate message was not just sent, forcing a retransmit
 	client->gamestateMessageNum = client->netchan.outgoingSequence;
 
-	MSG_Init( &msg, msgBuffer, sizeof( msgBuffer ) );
+	buf = NET_AllocBuffer( );
+	msg = &buf->msg;
 
 	// NOTE, MRE: all server->client messages now acknowledge
 	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	MSG_WriteLong( msg, client->lastClientCommand );
 
 	// send any server commands waiting to be sent first.
 	// we have to do this cause we send the client->reliableSequence
 	// with a gamestate and it sets the clc.serverCommandSequence at
 	// the client side
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_UpdateServerCommandsToClient( client, msg );
 
 	// send the gamestate
-	MSG_WriteByte( &msg, svc_gamestate );
-	MSG_WriteLong( &msg, client->reliableSequence );
+	MSG_WriteByte( msg, svc_gamestate );
+	MSG_WriteLong( msg, client->reliableSequence );
 
 	// write the configstrings
 	for ( start = 0 ; start < MAX_CONFIGSTRINGS ; start++ ) {
@@ -533,9 +548,9 @@ void SV_SendClientGameState( client_t *client ) {
 		}
 
 		if (configstring[0]) {
-			MSG_WriteByte( &msg, svc_configstring );
-			MSG_WriteShort( &msg, start );
-			MSG_WriteBigString( &msg, configstring );
+			MSG_WriteByte( msg, svc_configstring );
+			MSG_WriteShort( msg, start );
+			MSG_WriteBigString( msg, configstring );
 		}
 	}
 
@@ -570,22 +585,24 @@ void SV_SendClientGameState( client_t *client ) {
 		if ( !base->number ) {
 			continue;
 		}
-        if ( msg.cursize > msg.maxsize - 64 ) { //Ensure that there is extra space for the last few bytes.
+        if ( msg->cursize > msg->maxsize - 64 ) { //Ensure that there is extra space for the last few bytes.
             break;
         }
-		MSG_WriteByte( &msg, svc_baseline );
-		MSG_WriteDeltaEntity( client->netchan.alternateProtocol, &msg, &nullstate, base, qtrue );
+		MSG_WriteByte( msg, svc_baseline );
+		MSG_WriteDeltaEntity( client->netchan.alternateProtocol, msg, &nullstate, base, qtrue );
 	}
 
-	MSG_WriteByte( &msg, svc_EOF );
+	svs.protocolStats[ client->netchan.alternateProtocol ].gamestates++;
+
+	MSG_WriteByte( msg, svc_EOF );
 
-	MSG_WriteLong( &msg, client - svs.clients);
+	MSG_WriteLong( msg, client - svs.clients);
 
 	// write the checksum feed
-	MSG_WriteLong( &msg, sv.checksumFeed);
+	MSG_WriteLong( msg, sv.checksumFeed);
 
 	// deliver this to the client
-	SV_SendMessageToClient( &msg, client );
+	SV_SendMessageToClient( buf, client );
 }
 
 void SV_SendClientGameState2( int clientNum ) {
@@ -962,8 +979,7 @@ int SV_SendDownloadMessages(void)
 {
 	int i, numDLs = 0, retval;
 	client_t *cl;
-	msg_t msg;
-	byte msgBuffer[MAX_MSGLEN];
+	netBuffer_t *buf;
 
 	for(i=0; i < sv_maxclients->integer; i++)
 	{
@@ -971,17 +987,19 @@ int SV_SendDownloadMessages(void)
 
 		if(cl->state && *cl->downloadName)
 		{
-			MSG_Init(&msg, msgBuffer, sizeof(msgBuffer));
-			MSG_WriteLong(&msg, cl->lastClientCommand);
+			buf = NET_AllocBuffer();
+			MSG_WriteLong(&buf->msg, cl->lastClientCommand);
 
-			retval = SV_WriteDownloadToClient(cl, &msg);
+			retval = SV_WriteDownloadToClient(cl, &buf->msg);
 
 			if(retval)
 			{
-				MSG_WriteByte(&msg, svc_EOF);
-				SV_Netchan_Transmit(cl, &msg);
+				MSG_WriteByte(&buf->msg, svc_EOF);
+				SV_Netchan_Transmit(cl, buf);
 				numDLs += retval;
 			}
+			else
+				NET_ReleaseBuffer(buf);
 		}
 	}
 
@@ -1191,6 +1209,7 @@ void SV_UserinfoChanged( client_t *cl ) {
 
 	// name for C code
 	Q_strncpyz( cl->name, Info_ValueForKey (cl->userinfo, "name"), sizeof(cl->name) );
+	SV_InvalidateStatusCache( );
 
 	//for backwards compatibility approx hex color codes to hardcoded ansi
 	//color codes
@@ -0,0 +1,1771 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+
+// sv_demo.c -- server side match recording
+//
+// svrecord writes the whole match rather than one client's view: every
+// linked entity, the player states of all active clients, configstring
+// changes and server commands.  Each frame is delta compressed against
+// the previous one with the usual MSG_WriteDelta* functions, so the
+// main thread only pays for the entities that changed.  The records are
+// appended to a ring of blocks that a writer thread deflates to disk.
+//
+// svdemoview turns a recording into an ordinary client demo seen
+// through one player's eyes, which the client plays with "demo".
+//
+// snapbench replays a recording through the snapshot code for made up
+// clients, as the baseline for network optimizations.
+
+#include "server.h"
+
+#include <zlib.h>
+
+#define SVDEMO_MAGIC		"SVDM"
+#define SVDEMO_VERSION		1
+#define SVDEMO_DIR			"svdemos"
+#define SVDEMO_EXT			"svdm"
+
+#define SVDEMO_BLOCKS		8
+#define SVDEMO_BLOCK_SIZE	( 256 * 1024 )
+#define SVDEMO_FRAME_SIZE	( 256 * 1024 )	// room for every entity and player changing
+
+#define SVDEMO_ALL_CLIENTS	255
+
+typedef enum {
+	SVDM_CONFIGSTRING = 1,	// short index, long length, string
+	SVDM_COMMAND,			// byte client, short length, string
+	SVDM_FRAME,				// long serverTime, long length, frame message
+	SVDM_END
+} svDemoRecord_t;
+
+// the entityShared_t bits that decide which clients get an entity
+#define SVDEMO_SEND_FLAGS	( SVF_SINGLECLIENT | SVF_NOTSINGLECLIENT | \
+							  SVF_CLIENTMASK_EXCLUSIVE | SVF_BROADCAST )
+
+typedef struct {
+	int		svFlags;
+	int		singleClient;
+	int		generic1;
+} svDemoSendFilter_t;
+
+typedef struct {
+	byte		*data;
+	int			length;
+	qboolean	full;			// handed to the writer, guarded by the mutex
+} svDemoBlock_t;
+
+typedef struct {
+	qboolean			recording;
+	char				name[MAX_QPATH];
+	int					frames;
+	int					stalls;
+
+	// writer thread, only the block flags and stopping are shared
+	FILE				*file;
+	void				*thread;
+	void				*mutex;
+	svDemoBlock_t		blocks[SVDEMO_BLOCKS];
+	int					fill;			// main thread
+	int					drain;			// writer thread
+	qboolean			stopping;
+	qboolean			writeError;		// set by the writer, read after the join
+	z_stream			zs;
+	byte				deflated[64 * 1024];
+
+	// what the previous frame recorded
+	byte				*frameData;
+	int					numEntities;
+	int					entities[MAX_GENTITIES];	// index into svs.snapshotEntities or -1
+	svDemoSendFilter_t	filters[MAX_GENTITIES];
+	qboolean			active[MAX_CLIENTS];
+	playerState_t		playerStates[MAX_CLIENTS];
+} svDemo_t;
+
+static svDemo_t	svd;
+
+/*
+=============================================================================
+
+WRITER THREAD
+
+=============================================================================
+*/
+
+/*
+==================
+SV_DemoDeflate
+==================
+*/
+static void SV_DemoDeflate( byte *data, int length, int flush ) {
+	size_t	n;
+
+	svd.zs.next_in = data;
+	svd.zs.avail_in = length;
+
+	do {
+		svd.zs.next_out = svd.deflated;
+		svd.zs.avail_out = sizeof( svd.deflated );
+		deflate( &svd.zs, flush );
+
+		n = sizeof( svd.deflated ) - svd.zs.avail_out;
+		if ( n && fwrite( svd.deflated, 1, n, svd.file ) != n ) {
+			svd.writeError = qtrue;
+		}
+	} while ( svd.zs.avail_out == 0 );
+}
+
+/*
+==================
+SV_DemoWriterThread
+
+Compresses the handed over blocks in order until told to stop
+and nothing is left
+==================
+*/
+static void SV_DemoWriterThread( void *arg ) {
+	svDemoBlock_t	*block;
+	qboolean		full, stopping;
+
+	for ( ;; ) {
+		block = &svd.blocks[ svd.drain ];
+
+		Sys_LockMutex( svd.mutex );
+		full = block->full;
+		stopping = svd.stopping;
+		Sys_UnlockMutex( svd.mutex );
+
+		if ( !full ) {
+			if ( stopping ) {
+				break;
+			}
+			Sys_Sleep( 5 );
+			continue;
+		}
+
+		SV_DemoDeflate( block->data, block->length, Z_NO_FLUSH );
+
+		Sys_LockMutex( svd.mutex );
+		block->length = 0;
+		block->full = qfalse;
+		Sys_UnlockMutex( svd.mutex );
+
+		svd.drain = ( svd.drain + 1 ) % SVDEMO_BLOCKS;
+	}
+
+	SV_DemoDeflate( NULL, 0, Z_FINISH );
+}
+
+/*
+==================
+SV_DemoHandOff
+
+Gives the block being filled to the writer.  The next one is only
+busy when the writer is a whole ring behind, then the frame waits.
+==================
+*/
+static void SV_DemoHandOff( void ) {
+	svDemoBlock_t	*next;
+	qboolean		busy;
+
+	Sys_LockMutex( svd.mutex );
+	svd.blocks[ svd.fill ].full = qtrue;
+	Sys_UnlockMutex( svd.mutex );
+
+	svd.fill = ( svd.fill + 1 ) % SVDEMO_BLOCKS;
+	next = &svd.blocks[ svd.fill ];
+
+	Sys_LockMutex( svd.mutex );
+	busy = next->full;
+	Sys_UnlockMutex( svd.mutex );
+
+	if ( busy ) {
+		svd.stalls++;
+	}
+
+	while ( busy ) {
+		Sys_Sleep( 1 );
+
+		Sys_LockMutex( svd.mutex );
+		busy = next->full;
+		Sys_UnlockMutex( svd.mutex );
+	}
+}
+
+/*
+==================
+SV_DemoWrite
+==================
+*/
+static void SV_DemoWrite( const void *data, int length ) {
+	const byte		*p = data;
+	svDemoBlock_t	*block;
+	int				n;
+
+	while ( length > 0 ) {
+		block = &svd.blocks[ svd.fill ];
+		n = MIN( length, SVDEMO_BLOCK_SIZE - block->length );
+
+		Com_Memcpy( block->data + block->length, p, n );
+		block->length += n;
+		p += n;
+		length -= n;
+
+		if ( block->length == SVDEMO_BLOCK_SIZE ) {
+			SV_DemoHandOff( );
+		}
+	}
+}
+
+static void SV_DemoWriteByte( int c ) {
+	byte	b = c;
+
+	SV_DemoWrite( &b, 1 );
+}
+
+static void SV_DemoWriteShort( int c ) {
+	short	s = LittleShort( c );
+
+	SV_DemoWrite( &s, 2 );
+}
+
+static void SV_DemoWriteLong( int c ) {
+	int		l = LittleLong( c );
+
+	SV_DemoWrite( &l, 4 );
+}
+
+/*
+=============================================================================
+
+RECORDING
+
+=============================================================================
+*/
+
+/*
+==================
+SV_DemoConfigstring
+
+Called whenever a configstring changes
+==================
+*/
+void SV_DemoConfigstring( int index ) {
+	const char	*s = sv.configstrings[ index ].s;
+	int			len;
+
+	if ( !svd.recording ) {
+		return;
+	}
+
+	len = strlen( s );
+	SV_DemoWriteByte( SVDM_CONFIGSTRING );
+	SV_DemoWriteShort( index );
+	SV_DemoWriteLong( len );
+	SV_DemoWrite( s, len );
+}
+
+/*
+==================
+SV_DemoServerCommand
+
+Called for every reliable command, cl is NULL for a broadcast.
+Configstring updates are rebuilt from the SVDM_CONFIGSTRING records
+so they aren't stored twice.
+==================
+*/
+void SV_DemoServerCommand( client_t *cl, const char *cmd ) {
+	int		len;
+
+	if ( !svd.recording ) {
+		return;
+	}
+
+	if ( !strncmp( cmd, "cs ", 3 ) || !strncmp( cmd, "bcs", 3 ) ) {
+		return;
+	}
+
+	len = strlen( cmd );
+
+	SV_DemoWriteByte( SVDM_COMMAND );
+	SV_DemoWriteByte( cl ? cl - svs.clients : SVDEMO_ALL_CLIENTS );
+	SV_DemoWriteShort( len );
+	SV_DemoWrite( cmd, len );
+}
+
+/*
+==================
+SV_DemoWriteEntities
+
+Deltas every linked entity against the previous frame.  The entities
+are held through the shared snapshot entities, an unchanged one is
+the same copy as last frame and costs a compare.
+==================
+*/
+static void SV_DemoWriteEntities( msg_t *msg ) {
+	static entityState_t	nullstate;
+	sharedEntity_t			*ent;
+	int						e, numEntities;
+	int						index, old;
+
+	numEntities = MAX( sv.num_entities, svd.numEntities );
+
+	for ( e = 0; e < numEntities; e++ ) {
+		index = -1;
+		if ( e < sv.num_entities ) {
+			ent = SV_GentityNum( e );
+			if ( ent->r.linked && !( ent->r.svFlags & SVF_NOCLIENT ) ) {
+				if ( ent->s.number != e ) {
+					Com_DPrintf( "FIXING ENT->S.NUMBER!!!\n" );
+					ent->s.number = e;
+				}
+				index = SV_ShareSnapshotEntity( NULL, e );
+			}
+		}
+
+		old = svd.entities[ e ];
+		if ( index == old ) {
+			if ( index >= 0 ) {
+				SV_ReleaseSnapshotEntity( index );
+			}
+			continue;
+		}
+
+		if ( index < 0 ) {
+			MSG_WriteDeltaEntity( 0, msg, &svs.snapshotEntities[ old ].s, NULL, qtrue );
+		} else if ( old < 0 ) {
+			MSG_WriteDeltaEntity( 0, msg, &nullstate, &svs.snapshotEntities[ index ].s, qtrue );
+		} else {
+			MSG_WriteDeltaEntity( 0, msg, &svs.snapshotEntities[ old ].s,
+				&svs.snapshotEntities[ index ].s, qfalse );
+		}
+
+		if ( old >= 0 ) {
+			SV_ReleaseSnapshotEntity( old );
+		}
+		if ( index < 0 ) {
+			Com_Memset( &svd.filters[ e ], 0, sizeof( svd.filters[ e ] ) );
+		}
+		svd.entities[ e ] = index;
+	}
+
+	MSG_WriteBits( msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
+	svd.numEntities = sv.num_entities;
+}
+
+/*
+==================
+SV_DemoWriteSendFilters
+
+The fields SV_AddEntitiesVisibleFromPoint filters on, for the
+entities whose filter changed
+==================
+*/
+static void SV_DemoWriteSendFilters( msg_t *msg ) {
+	svDemoSendFilter_t	filter;
+	sharedEntity_t		*ent;
+	int					e;
+
+	for ( e = 0; e < svd.numEntities; e++ ) {
+		if ( svd.entities[ e ] < 0 ) {
+			continue;
+		}
+
+		ent = SV_GentityNum( e );
+		filter.svFlags = ent->r.svFlags & SVDEMO_SEND_FLAGS;
+		filter.singleClient = ent->r.singleClient;
+		filter.generic1 = ent->r.hack.generic1;
+
+		if ( !memcmp( &filter, &svd.filters[ e ], sizeof( filter ) ) ) {
+			continue;
+		}
+
+		MSG_WriteBits( msg, e, GENTITYNUM_BITS );
+		MSG_WriteLong( msg, filter.svFlags );
+		MSG_WriteLong( msg, filter.singleClient );
+		MSG_WriteLong( msg, filter.generic1 );
+		svd.filters[ e ] = filter;
+	}
+
+	MSG_WriteBits( msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
+}
+
+/*
+==================
+SV_DemoWritePlayers
+==================
+*/
+static void SV_DemoWritePlayers( msg_t *msg ) {
+	playerState_t	*ps;
+	qboolean		active;
+	int				i;
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		active = svs.clients[ i ].state == CS_ACTIVE;
+
+		if ( !active ) {
+			if ( svd.active[ i ] ) {
+				MSG_WriteByte( msg, i );
+				MSG_WriteBits( msg, 0, 1 );
+				svd.active[ i ] = qfalse;
+			}
+			continue;
+		}
+
+		ps = SV_GameClientNum( i );
+		if ( svd.active[ i ] && !memcmp( ps, &svd.playerStates[ i ], sizeof( *ps ) ) ) {
+			continue;
+		}
+
+		MSG_WriteByte( msg, i );
+		MSG_WriteBits( msg, 1, 1 );
+		MSG_WriteDeltaPlayerstate( 0, msg, svd.active[ i ] ? &svd.playerStates[ i ] : NULL, ps );
+		svd.playerStates[ i ] = *ps;
+		svd.active[ i ] = qtrue;
+	}
+
+	MSG_WriteByte( msg, SVDEMO_ALL_CLIENTS );
+}
+
+/*
+==================
+SV_DemoFrame
+
+Called after the snapshots went out
+==================
+*/
+void SV_DemoFrame( void ) {
+	msg_t	msg;
+
+	if ( !svd.recording ) {
+		return;
+	}
+
+	MSG_Init( &msg, svd.frameData, SVDEMO_FRAME_SIZE );
+	MSG_Bitstream( &msg );
+
+	SV_DemoWriteEntities( &msg );
+	SV_DemoWriteSendFilters( &msg );
+	SV_DemoWritePlayers( &msg );
+
+	if ( msg.overflowed ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: server demo frame overflowed, stopping\n" );
+		SV_DemoStopRecord( );
+		return;
+	}
+
+	SV_DemoWriteByte( SVDM_FRAME );
+	SV_DemoWriteLong( sv.time );
+	SV_DemoWriteLong( msg.cursize );
+	SV_DemoWrite( msg.data, msg.cursize );
+	svd.frames++;
+}
+
+/*
+==================
+SV_DemoFilename
+==================
+*/
+static void SV_DemoFilename( const char *name, char *path, int size ) {
+	Com_sprintf( path, size, SVDEMO_DIR "/%s." SVDEMO_EXT, name );
+}
+
+/*
+==================
+SV_DemoFreeBlocks
+==================
+*/
+static void SV_DemoFreeBlocks( void ) {
+	int		i;
+
+	for ( i = 0; i < SVDEMO_BLOCKS; i++ ) {
+		if ( svd.blocks[ i ].data ) {
+			Z_Free( svd.blocks[ i ].data );
+		}
+		svd.blocks[ i ].data = NULL;
+	}
+
+	if ( svd.frameData ) {
+		Z_Free( svd.frameData );
+	}
+	svd.frameData = NULL;
+}
+
+/*
+==================
+SV_DemoStartRecord
+==================
+*/
+static void SV_DemoStartRecord( const char *name ) {
+	char	path[MAX_QPATH];
+	char	*ospath;
+	int		i;
+
+	SV_DemoFilename( name, path, sizeof( path ) );
+	ospath = FS_BuildOSPath( Cvar_VariableString( "fs_homepath" ), FS_GetCurrentGameDir( ), path );
+
+	if ( FS_CreatePath( ospath ) ) {
+		Com_Printf( "ERROR: couldn't create the path for %s\n", path );
+		return;
+	}
+
+	svd.file = Sys_FOpen( ospath, "wb" );
+	if ( !svd.file ) {
+		Com_Printf( "ERROR: couldn't open %s\n", path );
+		return;
+	}
+
+	Com_Memset( &svd.zs, 0, sizeof( svd.zs ) );
+	if ( deflateInit( &svd.zs, Z_DEFAULT_COMPRESSION ) != Z_OK ) {
+		Com_Printf( "ERROR: deflateInit failed\n" );
+		fclose( svd.file );
+		svd.file = NULL;
+		return;
+	}
+
+	for ( i = 0; i < SVDEMO_BLOCKS; i++ ) {
+		svd.blocks[ i ].data = Z_Malloc( SVDEMO_BLOCK_SIZE );
+		svd.blocks[ i ].length = 0;
+		svd.blocks[ i ].full = qfalse;
+	}
+	svd.frameData = Z_Malloc( SVDEMO_FRAME_SIZE );
+	svd.fill = svd.drain = 0;
+	svd.stopping = qfalse;
+	svd.writeError = qfalse;
+
+	svd.mutex = Sys_CreateMutex( );
+	if ( svd.mutex ) {
+		svd.thread = Sys_CreateThread( SV_DemoWriterThread, NULL );
+	}
+	if ( !svd.thread ) {
+		Com_Printf( "ERROR: could not start the server demo writer thread\n" );
+		if ( svd.mutex ) {
+			Sys_DestroyMutex( svd.mutex );
+		}
+		svd.mutex = NULL;
+		SV_DemoFreeBlocks( );
+		deflateEnd( &svd.zs );
+		fclose( svd.file );
+		svd.file = NULL;
+		return;
+	}
+
+	Q_strncpyz( svd.name, path, sizeof( svd.name ) );
+	svd.recording = qtrue;
+	svd.frames = 0;
+	svd.stalls = 0;
+	svd.numEntities = 0;
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		svd.entities[ i ] = -1;
+	}
+	Com_Memset( svd.filters, 0, sizeof( svd.filters ) );
+	Com_Memset( svd.active, 0, sizeof( svd.active ) );
+
+	SV_DemoWrite( SVDEMO_MAGIC, 4 );
+	SV_DemoWriteLong( SVDEMO_VERSION );
+	SV_DemoWriteLong( PROTOCOL_VERSION );
+	SV_DemoWriteLong( sv_maxclients->integer );
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		if ( sv.configstrings[ i ].s && sv.configstrings[ i ].s[0] ) {
+			SV_DemoConfigstring( i );
+		}
+	}
+
+	Com_Printf( "recording server demo to %s.\n", path );
+}
+
+/*
+==================
+SV_DemoStopRecord
+
+Also called before the snapshot entities are reallocated
+==================
+*/
+void SV_DemoStopRecord( void ) {
+	int		i;
+
+	if ( !svd.recording ) {
+		return;
+	}
+
+	SV_DemoWriteByte( SVDM_END );
+	SV_DemoHandOff( );
+
+	Sys_LockMutex( svd.mutex );
+	svd.stopping = qtrue;
+	Sys_UnlockMutex( svd.mutex );
+
+	Sys_JoinThread( svd.thread );
+	svd.thread = NULL;
+	Sys_DestroyMutex( svd.mutex );
+	svd.mutex = NULL;
+
+	deflateEnd( &svd.zs );
+	if ( fclose( svd.file ) ) {
+		svd.writeError = qtrue;
+	}
+	svd.file = NULL;
+
+	SV_DemoFreeBlocks( );
+
+	for ( i = 0; i < svd.numEntities; i++ ) {
+		if ( svd.entities[ i ] >= 0 ) {
+			SV_ReleaseSnapshotEntity( svd.entities[ i ] );
+		}
+		svd.entities[ i ] = -1;
+	}
+
+	svd.recording = qfalse;
+
+	if ( svd.writeError ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: errors writing %s, the demo is incomplete\n", svd.name );
+	}
+	Com_Printf( "Stopped server demo %s, %d frames", svd.name, svd.frames );
+	if ( svd.stalls ) {
+		Com_Printf( ", waited on the writer %d times", svd.stalls );
+	}
+	Com_Printf( ".\n" );
+}
+
+/*
+==================
+SV_DemoRecord_f
+
+svrecord [demoname]
+==================
+*/
+void SV_DemoRecord_f( void ) {
+	char	name[MAX_QPATH];
+	char	path[MAX_QPATH];
+	int		number;
+
+	if ( Cmd_Argc( ) > 2 ) {
+		Com_Printf( "usage: svrecord [demoname]\n" );
+		return;
+	}
+
+	if ( svd.recording ) {
+		Com_Printf( "Already recording %s.\n", svd.name );
+		return;
+	}
+
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( Cmd_Argc( ) == 2 ) {
+		Q_strncpyz( name, Cmd_Argv( 1 ), sizeof( name ) );
+	} else {
+		// scan for a free demo name
+		for ( number = 0; number <= 9999; number++ ) {
+			Com_sprintf( name, sizeof( name ), "svdemo%04d", number );
+			SV_DemoFilename( name, path, sizeof( path ) );
+			if ( !FS_FileExists( path ) ) {
+				break;
+			}
+		}
+	}
+
+	SV_DemoStartRecord( name );
+}
+
+/*
+==================
+SV_DemoStopRecord_f
+==================
+*/
+void SV_DemoStopRecord_f( void ) {
+	if ( !svd.recording ) {
+		Com_Printf( "Not recording a server demo.\n" );
+		return;
+	}
+
+	SV_DemoStopRecord( );
+}
+
+/*
+=============================================================================
+
+CLIENT DEMO CONVERSION
+
+=============================================================================
+*/
+
+#define SVDEMO_MAX_COMMANDS		1024
+
+typedef struct {
+	fileHandle_t	f;
+	z_stream		zs;
+	qboolean		error;
+	byte			in[32 * 1024];
+	byte			out[64 * 1024];
+	int				outPos;
+	int				outLength;
+} svDemoReader_t;
+
+typedef struct {
+	svDemoReader_t		reader;
+	fileHandle_t		demo;
+	int					view;
+	int					maxclients;
+
+	char				*configstrings[MAX_CONFIGSTRINGS];
+	entityState_t		entities[MAX_GENTITIES];
+	qboolean			present[MAX_GENTITIES];
+	svDemoSendFilter_t	filters[MAX_GENTITIES];
+	playerState_t		playerStates[MAX_CLIENTS];
+	qboolean			active[MAX_CLIENTS];
+
+	// commands for the view, waiting for the next message
+	char				*commands[SVDEMO_MAX_COMMANDS];
+	int					numCommands;
+	int					droppedCommands;
+
+	// what the client has been sent
+	qboolean			gamestate;
+	int					messageSequence;
+	int					commandSequence;
+	int					lastSnapshot;		// message sequence, -1 for none
+	playerState_t		lastPs;
+	int					numLastEntities;
+	entityState_t		lastEntities[MAX_SNAPSHOT_ENTITIES];
+	int					snapshots;
+
+	byte				frameData[SVDEMO_FRAME_SIZE];
+} svDemoView_t;
+
+/*
+==================
+SV_DemoRead
+
+Inflates the next length bytes of the recording
+==================
+*/
+static qboolean SV_DemoRead( svDemoReader_t *r, void *data, int length ) {
+	byte	*p = data;
+	int		n, ret;
+
+	while ( length > 0 ) {
+		if ( r->outPos == r->outLength ) {
+			if ( r->error ) {
+				return qfalse;
+			}
+
+			r->zs.next_out = r->out;
+			r->zs.avail_out = sizeof( r->out );
+			r->outPos = 0;
+
+			while ( r->zs.avail_out == sizeof( r->out ) ) {
+				if ( r->zs.avail_in == 0 ) {
+					n = FS_Read( r->in, sizeof( r->in ), r->f );
+					if ( n <= 0 ) {
+						r->error = qtrue;
+						break;
+					}
+					r->zs.next_in = r->in;
+					r->zs.avail_in = n;
+				}
+
+				ret = inflate( &r->zs, Z_NO_FLUSH );
+				if ( ret != Z_OK && ret != Z_BUF_ERROR ) {
+					// a clean Z_STREAM_END only happens after SVDM_END
+					r->error = qtrue;
+					break;
+				}
+			}
+
+			r->outLength = sizeof( r->out ) - r->zs.avail_out;
+			if ( r->outLength == 0 ) {
+				return qfalse;
+			}
+		}
+
+		n = MIN( length, r->outLength - r->outPos );
+		Com_Memcpy( p, r->out + r->outPos, n );
+		r->outPos += n;
+		p += n;
+		length -= n;
+	}
+
+	return qtrue;
+}
+
+static qboolean SV_DemoReadByte( svDemoReader_t *r, int *c ) {
+	byte	b;
+
+	if ( !SV_DemoRead( r, &b, 1 ) ) {
+		return qfalse;
+	}
+	*c = b;
+	return qtrue;
+}
+
+static qboolean SV_DemoReadShort( svDemoReader_t *r, int *c ) {
+	short	s;
+
+	if ( !SV_DemoRead( r, &s, 2 ) ) {
+		return qfalse;
+	}
+	*c = LittleShort( s );
+	return qtrue;
+}
+
+static qboolean SV_DemoReadLong( svDemoReader_t *r, int *c ) {
+	int		l;
+
+	if ( !SV_DemoRead( r, &l, 4 ) ) {
+		return qfalse;
+	}
+	*c = LittleLong( l );
+	return qtrue;
+}
+
+/*
+==================
+SV_DemoReadString
+
+Reads length bytes into a new string
+==================
+*/
+static char *SV_DemoReadString( svDemoReader_t *r, int length ) {
+	char	*s;
+
+	if ( length < 0 || length > BIG_INFO_STRING * 4 ) {
+		return NULL;
+	}
+
+	s = Z_Malloc( length + 1 );
+	if ( !SV_DemoRead( r, s, length ) ) {
+		Z_Free( s );
+		return NULL;
+	}
+	s[ length ] = '\0';
+
+	return s;
+}
+
+/*
+==================
+SV_DemoQueueCommand
+==================
+*/
+static void SV_DemoQueueCommand( svDemoView_t *v, const char *cmd ) {
+	if ( v->numCommands == SVDEMO_MAX_COMMANDS ) {
+		v->droppedCommands++;
+		return;
+	}
+
+	v->commands[ v->numCommands++ ] = CopyString( cmd );
+}
+
+/*
+==================
+SV_DemoQueueConfigstring
+
+The same commands SV_SendConfigstring sends
+==================
+*/
+static void SV_DemoQueueConfigstring( svDemoView_t *v, int index ) {
+	const char	*configstring = v->configstrings[ index ] ? v->configstrings[ index ] : "";
+	int			maxChunkSize = MAX_STRING_CHARS - 24;
+	int			len = strlen( configstring );
+	int			sent, remaining;
+	char		*cmd;
+	char		buf[MAX_STRING_CHARS];
+
+	if ( len < maxChunkSize ) {
+		SV_DemoQueueCommand( v, va( "cs %i \"%s\"\n", index, configstring ) );
+		return;
+	}
+
+	for ( sent = 0, remaining = len; remaining > 0; ) {
+		if ( sent == 0 ) {
+			cmd = "bcs0";
+		} else if ( remaining < maxChunkSize ) {
+			cmd = "bcs2";
+		} else {
+			cmd = "bcs1";
+		}
+		Q_strncpyz( buf, &configstring[ sent ], maxChunkSize );
+
+		SV_DemoQueueCommand( v, va( "%s %i \"%s\"\n", cmd, index, buf ) );
+
+		sent += maxChunkSize - 1;
+		remaining -= maxChunkSize - 1;
+	}
+}
+
+/*
+==================
+SV_DemoWriteMessage
+
+Appends a message to the client demo the way CL_WriteDemoMessage does
+==================
+*/
+static void SV_DemoWriteMessage( svDemoView_t *v, msg_t *msg, int sequence ) {
+	int		len;
+
+	len = LittleLong( sequence );
+	FS_Write( &len, 4, v->demo );
+	len = LittleLong( msg->cursize );
+	FS_Write( &len, 4, v->demo );
+	FS_Write( msg->data, msg->cursize, v->demo );
+}
+
+/*
+==================
+SV_DemoWriteGamestate
+
+As CL_Record_f writes it, without baselines
+==================
+*/
+static qboolean SV_DemoWriteGamestate( svDemoView_t *v ) {
+	byte	bufData[MAX_MSGLEN];
+	msg_t	buf;
+	int		i;
+
+	MSG_Init( &buf, bufData, sizeof( bufData ) );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, 0 );
+
+	MSG_WriteByte( &buf, svc_gamestate );
+	MSG_WriteLong( &buf, v->commandSequence );
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		if ( !v->configstrings[ i ] || !v->configstrings[ i ][0] ) {
+			continue;
+		}
+		MSG_WriteByte( &buf, svc_configstring );
+		MSG_WriteShort( &buf, i );
+		MSG_WriteBigString( &buf, v->configstrings[ i ] );
+	}
+
+	MSG_WriteByte( &buf, svc_EOF );
+
+	MSG_WriteLong( &buf, v->view );
+	MSG_WriteLong( &buf, 0 );
+
+	MSG_WriteByte( &buf, svc_EOF );
+
+	if ( buf.overflowed ) {
+		Com_Printf( "ERROR: the gamestate doesn't fit in a message\n" );
+		return qfalse;
+	}
+
+	SV_DemoWriteMessage( v, &buf, v->messageSequence - 1 );
+	v->gamestate = qtrue;
+	return qtrue;
+}
+
+/*
+==================
+SV_DemoCanSend
+
+The send flag checks of SV_AddEntitiesVisibleFromPoint
+==================
+*/
+static qboolean SV_DemoCanSend( svDemoSendFilter_t *f, int client ) {
+	if ( ( f->svFlags & SVF_SINGLECLIENT ) && f->singleClient != client ) {
+		return qfalse;
+	}
+	if ( ( f->svFlags & SVF_NOTSINGLECLIENT ) && f->singleClient == client ) {
+		return qfalse;
+	}
+	if ( f->svFlags & SVF_CLIENTMASK_EXCLUSIVE ) {
+		if ( client >= 32 ) {
+			return ( f->generic1 & ( 1 << ( client - 32 ) ) ) != 0;
+		}
+		return ( f->singleClient & ( 1 << client ) ) != 0;
+	}
+	return qtrue;
+}
+
+static vec3_t	svDemoViewOrigin;
+
+/*
+==================
+SV_DemoCompareEntities
+
+Nearest to the view first
+==================
+*/
+static int QDECL SV_DemoCompareEntities( const void *a, const void *b ) {
+	const entityState_t	*ea = *(const entityState_t **)a;
+	const entityState_t	*eb = *(const entityState_t **)b;
+	float				da, db;
+
+	da = DistanceSquared( ea->pos.trBase, svDemoViewOrigin );
+	db = DistanceSquared( eb->pos.trBase, svDemoViewOrigin );
+
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+static int QDECL SV_DemoCompareNumbers( const void *a, const void *b ) {
+	return (*(const entityState_t **)a)->number - (*(const entityState_t **)b)->number;
+}
+
+/*
+==================
+SV_DemoViewEntities
+
+What a client in the view's slot would have been sent.  There is no
+map to cull with, so every entity passing the send flags is visible
+and the nearest ones are kept when there are too many.
+==================
+*/
+static int SV_DemoViewEntities( svDemoView_t *v, entityState_t **list ) {
+	static entityState_t	*others[MAX_GENTITIES];
+	int						e, count = 0, numOthers = 0;
+	int						clientNum = v->playerStates[ v->view ].clientNum;
+
+	for ( e = 0; e < MAX_GENTITIES - 1; e++ ) {
+		// never send client's own entity, like SV_BuildClientSnapshot
+		if ( e == clientNum ) {
+			continue;
+		}
+		if ( !v->present[ e ] || !SV_DemoCanSend( &v->filters[ e ], v->view ) ) {
+			continue;
+		}
+
+		if ( ( v->filters[ e ].svFlags & SVF_BROADCAST ) && count < MAX_SNAPSHOT_ENTITIES ) {
+			list[ count++ ] = &v->entities[ e ];
+		} else {
+			others[ numOthers++ ] = &v->entities[ e ];
+		}
+	}
+
+	if ( count + numOthers > MAX_SNAPSHOT_ENTITIES ) {
+		VectorCopy( v->playerStates[ v->view ].origin, svDemoViewOrigin );
+		qsort( others, numOthers, sizeof( others[0] ), SV_DemoCompareEntities );
+		numOthers = MAX_SNAPSHOT_ENTITIES - count;
+	}
+
+	Com_Memcpy( list + count, others, numOthers * sizeof( others[0] ) );
+	count += numOthers;
+
+	qsort( list, count, sizeof( list[0] ), SV_DemoCompareNumbers );
+	return count;
+}
+
+/*
+==================
+SV_DemoEmitEntities
+
+SV_EmitPacketEntities against what the client was last sent.  New
+entities are left out once the message is nearly full, they come
+along in a later snapshot.
+==================
+*/
+static void SV_DemoEmitEntities( svDemoView_t *v, msg_t *msg, qboolean delta ) {
+	static entityState_t	nullstate;
+	static entityState_t	sent[MAX_SNAPSHOT_ENTITIES];
+	entityState_t			*list[MAX_SNAPSHOT_ENTITIES];
+	entityState_t			*oldent, *newent;
+	int						numNew, numOld, numSent = 0;
+	int						oldindex = 0, newindex = 0;
+	int						oldnum, newnum;
+	int						room = msg->maxsize - 1024;
+
+	numNew = SV_DemoViewEntities( v, list );
+	numOld = delta ? v->numLastEntities : 0;
+
+	while ( newindex < numNew || oldindex < numOld ) {
+		newent = newindex < numNew ? list[ newindex ] : NULL;
+		oldent = oldindex < numOld ? &v->lastEntities[ oldindex ] : NULL;
+		newnum = newent ? newent->number : 9999;
+		oldnum = oldent ? oldent->number : 9999;
+
+		if ( newnum == oldnum ) {
+			MSG_WriteDeltaEntity( 0, msg, oldent, newent, qfalse );
+			sent[ numSent++ ] = *newent;
+			oldindex++;
+			newindex++;
+		} else if ( newnum < oldnum ) {
+			if ( msg->cursize < room ) {
+				MSG_WriteDeltaEntity( 0, msg, &nullstate, newent, qtrue );
+				sent[ numSent++ ] = *newent;
+			}
+			newindex++;
+		} else {
+			MSG_WriteBits( msg, oldnum, GENTITYNUM_BITS );
+			MSG_WriteBits( msg, 1, 1 );
+			oldindex++;
+		}
+	}
+
+	MSG_WriteBits( msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
+
+	Com_Memcpy( v->lastEntities, sent, numSent * sizeof( sent[0] ) );
+	v->numLastEntities = numSent;
+}
+
+/*
+==================
+SV_DemoWriteViewMessage
+
+One client demo message for the frame: the commands waiting for the
+view and, while the view is in the game, a snapshot
+==================
+*/
+static void SV_DemoWriteViewMessage( svDemoView_t *v, int serverTime ) {
+	byte		bufData[MAX_MSGLEN];
+	msg_t		buf;
+	qboolean	active = v->active[ v->view ];
+	qboolean	delta;
+	int			i, written;
+	int			room = sizeof( bufData ) - MAX_STRING_CHARS - 16;
+
+	if ( !active && !v->numCommands ) {
+		return;
+	}
+
+	MSG_Init( &buf, bufData, sizeof( bufData ) );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, 0 );
+
+	// a full message holds the rest of the commands back
+	for ( written = 0; written < v->numCommands && buf.cursize < room / 2; written++ ) {
+		MSG_WriteByte( &buf, svc_serverCommand );
+		MSG_WriteLong( &buf, ++v->commandSequence );
+		MSG_WriteString( &buf, v->commands[ written ] );
+		Z_Free( v->commands[ written ] );
+	}
+	for ( i = written; i < v->numCommands; i++ ) {
+		v->commands[ i - written ] = v->commands[ i ];
+	}
+	v->numCommands -= written;
+
+	if ( active ) {
+		delta = v->lastSnapshot == v->messageSequence - 1;
+
+		MSG_WriteByte( &buf, svc_snapshot );
+		MSG_WriteLong( &buf, serverTime );
+		MSG_WriteByte( &buf, delta ? 1 : 0 );
+		MSG_WriteByte( &buf, 0 );
+
+		// an all clear area mask, everything is visible
+		MSG_WriteByte( &buf, MAX_MAP_AREA_BYTES );
+		for ( i = 0; i < MAX_MAP_AREA_BYTES; i++ ) {
+			MSG_WriteByte( &buf, 0 );
+		}
+
+		MSG_WriteDeltaPlayerstate( 0, &buf, delta ? &v->lastPs : NULL, &v->playerStates[ v->view ] );
+		v->lastPs = v->playerStates[ v->view ];
+
+		SV_DemoEmitEntities( v, &buf, delta );
+
+		v->lastSnapshot = v->messageSequence;
+		v->snapshots++;
+	}
+
+	MSG_WriteByte( &buf, svc_EOF );
+
+	if ( buf.overflowed ) {
+		// the next snapshot can't delta from this one
+		Com_DPrintf( "SV_DemoWriteViewMessage: overflowed at %d\n", serverTime );
+		v->lastSnapshot = -1;
+		return;
+	}
+
+	SV_DemoWriteMessage( v, &buf, v->messageSequence );
+	v->messageSequence++;
+}
+
+/*
+==================
+SV_DemoReadFrame
+
+Applies a recorded frame to the converter's copy of the world
+==================
+*/
+static qboolean SV_DemoReadFrame( svDemoView_t *v, int length ) {
+	msg_t	msg;
+	int		e, i;
+
+	if ( length < 0 || length > SVDEMO_FRAME_SIZE ||
+		!SV_DemoRead( &v->reader, v->frameData, length ) ) {
+		return qfalse;
+	}
+
+	MSG_Init( &msg, v->frameData, SVDEMO_FRAME_SIZE );
+	MSG_Bitstream( &msg );
+	msg.cursize = length;
+	MSG_BeginReading( &msg );
+
+	for ( ;; ) {
+		e = MSG_ReadBits( &msg, GENTITYNUM_BITS );
+		if ( e == MAX_GENTITIES - 1 || msg.readcount > msg.cursize ) {
+			break;
+		}
+
+		MSG_ReadDeltaEntity( 0, &msg, &v->entities[ e ], &v->entities[ e ], e );
+		v->present[ e ] = v->entities[ e ].number != MAX_GENTITIES - 1;
+		if ( !v->present[ e ] ) {
+			Com_Memset( &v->filters[ e ], 0, sizeof( v->filters[ e ] ) );
+		}
+	}
+
+	for ( ;; ) {
+		e = MSG_ReadBits( &msg, GENTITYNUM_BITS );
+		if ( e == MAX_GENTITIES - 1 || msg.readcount > msg.cursize ) {
+			break;
+		}
+
+		v->filters[ e ].svFlags = MSG_ReadLong( &msg );
+		v->filters[ e ].singleClient = MSG_ReadLong( &msg );
+		v->filters[ e ].generic1 = MSG_ReadLong( &msg );
+	}
+
+	for ( ;; ) {
+		i = MSG_ReadByte( &msg );
+		if ( i == SVDEMO_ALL_CLIENTS || i < 0 || i >= MAX_CLIENTS ) {
+			break;
+		}
+
+		if ( !MSG_ReadBits( &msg, 1 ) ) {
+			v->active[ i ] = qfalse;
+			continue;
+		}
+
+		MSG_ReadDeltaPlayerstate( &msg, v->active[ i ] ? &v->playerStates[ i ] : NULL,
+			&v->playerStates[ i ] );
+		v->active[ i ] = qtrue;
+	}
+
+	return msg.readcount <= msg.cursize;
+}
+
+/*
+==================
+SV_DemoOpen
+
+Opens a recording and checks its header
+==================
+*/
+static qboolean SV_DemoOpen( svDemoView_t *v, const char *name ) {
+	svDemoReader_t	*r = &v->reader;
+	char			path[MAX_QPATH];
+	char			magic[4];
+	int				version, protocol;
+
+	SV_DemoFilename( name, path, sizeof( path ) );
+	if ( FS_FOpenFileRead( path, &r->f, qtrue ) < 0 || !r->f ) {
+		Com_Printf( "Couldn't open %s\n", path );
+		return qfalse;
+	}
+
+	if ( inflateInit( &r->zs ) != Z_OK ) {
+		Com_Printf( "ERROR: inflateInit failed\n" );
+		FS_FCloseFile( r->f );
+		return qfalse;
+	}
+
+	if ( !SV_DemoRead( r, magic, 4 ) || memcmp( magic, SVDEMO_MAGIC, 4 ) ||
+		!SV_DemoReadLong( r, &version ) || !SV_DemoReadLong( r, &protocol ) ||
+		!SV_DemoReadLong( r, &v->maxclients ) ) {
+		Com_Printf( "%s is not a server demo\n", path );
+	} else if ( version != SVDEMO_VERSION || protocol != PROTOCOL_VERSION ) {
+		Com_Printf( "%s is version %d protocol %d, expected version %d protocol %d\n",
+			path, version, protocol, SVDEMO_VERSION, PROTOCOL_VERSION );
+	} else if ( v->maxclients < 1 || v->maxclients > MAX_CLIENTS ) {
+		Com_Printf( "%s has a bad sv_maxclients %d\n", path, v->maxclients );
+	} else {
+		return qtrue;
+	}
+
+	inflateEnd( &r->zs );
+	FS_FCloseFile( r->f );
+	return qfalse;
+}
+
+/*
+==================
+SV_DemoClose
+
+Frees the reader and whatever was read
+==================
+*/
+static void SV_DemoClose( svDemoView_t *v ) {
+	int		i;
+
+	inflateEnd( &v->reader.zs );
+	FS_FCloseFile( v->reader.f );
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		if ( v->configstrings[ i ] ) {
+			Z_Free( v->configstrings[ i ] );
+		}
+	}
+	for ( i = 0; i < v->numCommands; i++ ) {
+		Z_Free( v->commands[ i ] );
+	}
+	Z_Free( v );
+}
+
+/*
+==================
+SV_DemoView_f
+
+svdemoview <svdemo> <clientnum> [demoname]
+==================
+*/
+void SV_DemoView_f( void ) {
+	svDemoView_t	*v;
+	svDemoReader_t	*r;
+	char			path[MAX_QPATH];
+	char			demoName[MAX_QPATH];
+	char			*s;
+	int				type, index, length, serverTime;
+	int				i;
+	qboolean		ok = qfalse;
+
+	if ( Cmd_Argc( ) < 3 || Cmd_Argc( ) > 4 ) {
+		Com_Printf( "usage: svdemoview <svdemo> <clientnum> [demoname]\n" );
+		return;
+	}
+
+	v = Z_Malloc( sizeof( *v ) );
+	r = &v->reader;
+
+	v->view = atoi( Cmd_Argv( 2 ) );
+	if ( v->view < 0 || v->view >= MAX_CLIENTS ) {
+		Com_Printf( "Bad client number %s\n", Cmd_Argv( 2 ) );
+		Z_Free( v );
+		return;
+	}
+
+	if ( !SV_DemoOpen( v, Cmd_Argv( 1 ) ) ) {
+		Z_Free( v );
+		return;
+	}
+
+	if ( v->view >= v->maxclients ) {
+		Com_Printf( "The demo was recorded with sv_maxclients %d\n", v->maxclients );
+		SV_DemoClose( v );
+		return;
+	}
+
+	if ( Cmd_Argc( ) == 4 ) {
+		Q_strncpyz( demoName, Cmd_Argv( 3 ), sizeof( demoName ) );
+	} else {
+		Com_sprintf( demoName, sizeof( demoName ), "%s-%d", Cmd_Argv( 1 ), v->view );
+	}
+	Com_sprintf( path, sizeof( path ), "demos/%s.%s%d", demoName, DEMOEXT, PROTOCOL_VERSION );
+
+	v->demo = FS_FOpenFileWrite( path );
+	if ( !v->demo ) {
+		Com_Printf( "ERROR: couldn't open %s\n", path );
+		SV_DemoClose( v );
+		return;
+	}
+
+	v->messageSequence = 1;
+	v->lastSnapshot = -1;
+
+	while ( SV_DemoReadByte( r, &type ) ) {
+		if ( type == SVDM_END ) {
+			ok = qtrue;
+			break;
+		}
+
+		if ( type == SVDM_CONFIGSTRING ) {
+			if ( !SV_DemoReadShort( r, &index ) || index < 0 || index >= MAX_CONFIGSTRINGS ||
+				!SV_DemoReadLong( r, &length ) || !( s = SV_DemoReadString( r, length ) ) ) {
+				break;
+			}
+
+			if ( v->configstrings[ index ] ) {
+				Z_Free( v->configstrings[ index ] );
+			}
+			v->configstrings[ index ] = s;
+
+			if ( v->gamestate ) {
+				SV_DemoQueueConfigstring( v, index );
+			}
+		} else if ( type == SVDM_COMMAND ) {
+			if ( !SV_DemoReadByte( r, &i ) || !SV_DemoReadShort( r, &length ) ||
+				!( s = SV_DemoReadString( r, length ) ) ) {
+				break;
+			}
+
+			if ( v->gamestate && ( i == SVDEMO_ALL_CLIENTS || i == v->view ) ) {
+				SV_DemoQueueCommand( v, s );
+			}
+			Z_Free( s );
+		} else if ( type == SVDM_FRAME ) {
+			if ( !SV_DemoReadLong( r, &serverTime ) || !SV_DemoReadLong( r, &length ) ||
+				!SV_DemoReadFrame( v, length ) ) {
+				break;
+			}
+
+			// the demo starts when the view first is in the game
+			if ( !v->gamestate ) {
+				if ( !v->active[ v->view ] ) {
+					continue;
+				}
+				if ( !SV_DemoWriteGamestate( v ) ) {
+					break;
+				}
+			}
+
+			SV_DemoWriteViewMessage( v, serverTime );
+		} else {
+			break;
+		}
+	}
+
+	if ( !ok ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: %s ends early or is corrupt\n", Cmd_Argv( 1 ) );
+	}
+
+	i = -1;
+	FS_Write( &i, 4, v->demo );
+	FS_Write( &i, 4, v->demo );
+	FS_FCloseFile( v->demo );
+
+	if ( !v->gamestate ) {
+		Com_Printf( "Client %d never entered the game, %s is empty\n", v->view, path );
+	} else {
+		Com_Printf( "Wrote %s, %d snapshots", path, v->snapshots );
+		if ( v->droppedCommands ) {
+			Com_Printf( ", %d commands dropped", v->droppedCommands );
+		}
+		Com_Printf( ".\n" );
+	}
+
+	SV_DemoClose( v );
+}
+
+/*
+=============================================================================
+
+SNAPSHOT BENCHMARK
+
+snapbench stands in for a running server, borrowing the sv and svs
+fields the snapshot code reads, and sends every recorded frame to made
+up clients through SV_SendBenchmarkSnapshot and the netchan, with the
+packets thrown away.  Each client sees the entities its send flags
+allow plus a fixed share of the rest in place of the PVS, and acks a
+snapshot ping msec after it went out, losing some of the acks.
+
+=============================================================================
+*/
+
+#define SVDEMO_BENCH_MSEC	50		// sv_fps 20, a snapshot every frame
+
+/*
+==================
+SV_DemoBenchVisible
+
+The hash keeps the same entities in view from frame to frame, the
+way the PVS would
+==================
+*/
+static qboolean SV_DemoBenchVisible( svDemoView_t *v, int client, int e, int pvs ) {
+	unsigned int	h;
+
+	if ( !SV_DemoCanSend( &v->filters[ e ], client ) ) {
+		return qfalse;
+	}
+	if ( v->filters[ e ].svFlags & SVF_BROADCAST ) {
+		return qtrue;
+	}
+
+	h = (unsigned int)client * 2654435761u ^ (unsigned int)e * 40503u;
+	h ^= h >> 15;
+	h *= 2246822519u;
+	h ^= h >> 13;
+
+	return (int)( h % 100 ) < pvs;
+}
+
+/*
+==================
+SV_DemoBenchWorld
+
+Puts a recorded frame in the borrowed game entities and player states
+==================
+*/
+static void SV_DemoBenchWorld( svDemoView_t *v, int numClients ) {
+	sharedEntity_t	*ent;
+	int				e, i;
+
+	sv.num_entities = 0;
+	for ( e = 0; e < MAX_GENTITIES - 1; e++ ) {
+		ent = SV_GentityNum( e );
+		ent->r.linked = v->present[ e ];
+		if ( !v->present[ e ] ) {
+			continue;
+		}
+
+		ent->s = v->entities[ e ];
+		ent->r.svFlags = v->filters[ e ].svFlags;
+		ent->r.singleClient = v->filters[ e ].singleClient;
+		ent->r.hack.generic1 = v->filters[ e ].generic1;
+		sv.num_entities = e + 1;
+	}
+
+	// more clients than were recorded play the recorded ones again
+	for ( i = 0; i < numClients; i++ ) {
+		*SV_GameClientNum( i ) = v->playerStates[ i % v->maxclients ];
+	}
+}
+
+/*
+==================
+SV_DemoBenchStart
+==================
+*/
+static void SV_DemoBenchStart( int numClients ) {
+	client_t	*cl;
+	netadr_t	adr;
+	int			i;
+
+	svs.clients = Z_Malloc( MAX( numClients, sv_maxclients->integer ) * sizeof( client_t ) );
+	svs.numSnapshotEntities = SV_SnapshotEntitiesForClients( numClients );
+	svs.snapshotEntities = Z_Malloc( svs.numSnapshotEntities * sizeof( snapshotEntity_t ) );
+	SV_InitSnapshotEntities( );
+
+	Com_Memset( sv.svEntities, 0, sizeof( sv.svEntities ) );
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		sv.svEntities[ i ].snapshotEntity = -1;
+	}
+	sv.gentities = Z_Malloc( MAX_GENTITIES * sizeof( sharedEntity_t ) );
+	sv.gentitySize = sizeof( sharedEntity_t );
+	sv.gameClients = Z_Malloc( MAX_CLIENTS * sizeof( playerState_t ) );
+	sv.gameClientSize = sizeof( playerState_t );
+
+	// a documentation address, so the rate limits apply as for
+	// internet clients
+	Com_Memset( &adr, 0, sizeof( adr ) );
+	adr.type = NA_IP;
+	adr.ip[0] = 198;
+	adr.ip[1] = 51;
+	adr.ip[2] = 100;
+	adr.ip[3] = 1;
+
+	for ( i = 0; i < numClients; i++ ) {
+		cl = &svs.clients[ i ];
+		adr.port = BigShort( 27960 + i );
+		Netchan_Setup( 0, NS_SERVER, &cl->netchan, adr, i, 0 );
+		cl->netchan_end_queue = &cl->netchan_start_queue;
+		cl->state = CS_ACTIVE;
+		cl->gentity = SV_GentityNum( i );
+		cl->rate = 25000;
+		cl->snapshotMsec = SVDEMO_BENCH_MSEC;
+		Com_sprintf( cl->name, sizeof( cl->name ), "bench%d", i );
+	}
+}
+
+/*
+==================
+SV_DemoBenchStop
+
+Gives back what SV_DemoBenchStart borrowed
+==================
+*/
+static void SV_DemoBenchStop( int numClients ) {
+	int		i;
+
+	for ( i = 0; i < numClients; i++ ) {
+		SV_Netchan_FreeQueue( &svs.clients[ i ] );
+	}
+
+	Z_Free( svs.clients );
+	svs.clients = NULL;
+	Z_Free( svs.snapshotEntities );
+	svs.snapshotEntities = NULL;
+	svs.numSnapshotEntities = 0;
+
+	Z_Free( sv.gentities );
+	sv.gentities = NULL;
+	Z_Free( sv.gameClients );
+	sv.gameClients = NULL;
+	sv.num_entities = 0;
+	Com_Memset( sv.svEntities, 0, sizeof( sv.svEntities ) );
+	sv.time = svs.time = 0;
+}
+
+/*
+==================
+SV_DemoBenchmark_f
+
+snapbench <svdemo> [clients] [pvs%] [ping] [loss%]
+==================
+*/
+void SV_DemoBenchmark_f( void ) {
+	static int		entityNums[MAX_CLIENTS][MAX_SNAPSHOT_ENTITIES];
+	int				numEntityNums[MAX_CLIENTS];
+	svDemoView_t	*v;
+	svDemoReader_t	*r;
+	client_t		*cl;
+	char			*s;
+	int				numClients, pvs, ping, loss, lag;
+	int				type, index, length, serverTime;
+	int				i, e, clientNum, sequence;
+	int				frames = 0, snapshots = 0, msec = 0, allocations = 0;
+	int				start, packets, buffers, buffersInUse, bufferRequests, inUse;
+	int				seed = 0x5eed;
+	double			bytes = 0;
+
+	if ( Cmd_Argc( ) < 2 || Cmd_Argc( ) > 6 ) {
+		Com_Printf( "usage: snapbench <svdemo> [clients] [pvs%%] [ping] [loss%%]\n" );
+		return;
+	}
+
+	if ( com_sv_running->integer || sv.state != SS_DEAD ) {
+		Com_Printf( "snapbench borrows the server state, kill the server first.\n" );
+		return;
+	}
+
+	if ( svs.clients ) {
+		for ( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ ) {
+			if ( cl->state != CS_FREE ) {
+				Com_Printf( "snapbench borrows the server state, drop client %d first.\n", i );
+				return;
+			}
+		}
+	}
+
+	v = Z_Malloc( sizeof( *v ) );
+	r = &v->reader;
+	if ( !SV_DemoOpen( v, Cmd_Argv( 1 ) ) ) {
+		Z_Free( v );
+		return;
+	}
+
+	numClients = Cmd_Argc( ) > 2 ? atoi( Cmd_Argv( 2 ) ) : v->maxclients;
+	numClients = MAX( 1, MIN( numClients, MAX_CLIENTS ) );
+	pvs = Cmd_Argc( ) > 3 ? atoi( Cmd_Argv( 3 ) ) : 50;
+	ping = Cmd_Argc( ) > 4 ? atoi( Cmd_Argv( 4 ) ) : 100;
+	loss = Cmd_Argc( ) > 5 ? atoi( Cmd_Argv( 5 ) ) : 0;
+	lag = MAX( 0, ping ) / SVDEMO_BENCH_MSEC;
+
+	SV_DemoBenchStart( numClients );
+
+	NET_DiscardPackets( qtrue );
+	NET_BufferStats( &buffers, &buffersInUse, &bufferRequests );
+
+	while ( SV_DemoReadByte( r, &type ) && type != SVDM_END ) {
+		if ( type == SVDM_CONFIGSTRING ) {
+			if ( !SV_DemoReadShort( r, &index ) || !SV_DemoReadLong( r, &length ) ||
+				!( s = SV_DemoReadString( r, length ) ) ) {
+				break;
+			}
+			Z_Free( s );
+			continue;
+		}
+
+		if ( type == SVDM_COMMAND ) {
+			if ( !SV_DemoReadByte( r, &i ) || !SV_DemoReadShort( r, &length ) ||
+				!( s = SV_DemoReadString( r, length ) ) ) {
+				break;
+			}
+			Z_Free( s );
+			continue;
+		}
+
+		if ( type != SVDM_FRAME || !SV_DemoReadLong( r, &serverTime ) ||
+			!SV_DemoReadLong( r, &length ) || !SV_DemoReadFrame( v, length ) ) {
+			break;
+		}
+
+		SV_DemoBenchWorld( v, numClients );
+		sv.time = svs.time = serverTime;
+
+		// what every client sees, outside of the timing
+		for ( i = 0; i < numClients; i++ ) {
+			numEntityNums[ i ] = 0;
+			if ( !v->active[ i % v->maxclients ] ) {
+				continue;
+			}
+
+			clientNum = SV_GameClientNum( i )->clientNum;
+			for ( e = 0; e < sv.num_entities && numEntityNums[ i ] < MAX_SNAPSHOT_ENTITIES; e++ ) {
+				if ( v->present[ e ] && e != clientNum && SV_DemoBenchVisible( v, i, e, pvs ) ) {
+					entityNums[ i ][ numEntityNums[ i ]++ ] = e;
+				}
+			}
+		}
+
+		start = Sys_Milliseconds( );
+		allocations -= Z_Allocations( );
+
+		for ( i = 0; i < numClients; i++ ) {
+			if ( !v->active[ i % v->maxclients ] ) {
+				continue;
+			}
+
+			cl = &svs.clients[ i ];
+			sequence = cl->netchan.outgoingSequence;
+
+			// the ack for the snapshot lag frames back, unless it got lost
+			if ( sequence - lag - 1 <= 0 ) {
+				cl->deltaMessage = -1;
+			} else if ( loss <= 0 || Q_rand( &seed ) % 100 >= loss ) {
+				cl->deltaMessage = sequence - lag - 1;
+			}
+
+			SV_SendBenchmarkSnapshot( cl, entityNums[ i ], numEntityNums[ i ] );
+			bytes += cl->frames[ sequence & PACKET_MASK ].messageSize;
+			snapshots++;
+
+			// the rate delay isn't simulated, fragments go out at once
+			while ( cl->netchan.unsentFragments || cl->netchan_start_queue ) {
+				SV_Netchan_TransmitNextFragment( cl );
+			}
+		}
+
+		allocations += Z_Allocations( );
+		msec += Sys_Milliseconds( ) - start;
+		frames++;
+	}
+
+	packets = NET_DiscardPackets( qfalse );
+	NET_BufferStats( &buffers, &buffersInUse, &bufferRequests );
+
+	inUse = 0;
+	for ( i = 0; i < svs.numSnapshotEntities; i++ ) {
+		if ( svs.snapshotEntities[ i ].refCount > 0 ) {
+			inUse++;
+		}
+	}
+
+	Com_Printf( "%d frames, %d clients, pvs %d%%, ping %d, loss %d%%\n",
+		frames, numClients, pvs, ping, loss );
+	if ( snapshots ) {
+		Com_Printf( "%d snapshots in %d msec, %.0f ns per client per frame\n",
+			snapshots, msec, msec * 1000000.0 / snapshots );
+		Com_Printf( "%.1f bytes per snapshot, %d packets\n", bytes / snapshots, packets );
+		Com_Printf( "%d zone allocations, %d net buffers for %d messages, "
+			"%d of %d snapshot entities in use\n", allocations, buffers, bufferRequests,
+			inUse, svs.numSnapshotEntities );
+	}
+
+	SV_DemoBenchStop( numClients );
+	SV_DemoClose( v );
+}
@@ -0,0 +1,948 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+
+// sv_http.c -- built in HTTP/1.1 listener for pk3 downloads
+//
+// Clients that are allowed to redirect downloads fetch
+// sv_dlURL/gamedir/pak.pk3 with cURL.  When sv_httpPort is set the
+// server answers those requests itself on a separate thread, so pk3
+// data never goes through the netchan or the frame loop.  Only the
+// paks listed in sv_referencedPakNames / sv_referencedAlternatePakNames
+// are served; the main thread publishes that list after each map load.
+
+#include "server.h"
+
+#ifdef _WIN32
+#	include <winsock2.h>
+#	include <ws2tcpip.h>
+
+typedef int socklen_t;
+#	define EAGAIN				WSAEWOULDBLOCK
+typedef u_long	ioctlarg_t;
+#	define socketError			WSAGetLastError( )
+#	define MSG_NOSIGNAL			0
+
+#else
+
+#	include <sys/socket.h>
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <sys/time.h>
+#	include <sys/ioctl.h>
+#	include <netinet/in.h>
+#	include <arpa/inet.h>
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <signal.h>
+#	include <unistd.h>
+#	ifdef __linux__
+#		include <sys/sendfile.h>
+#	endif
+
+#	ifdef __sun
+#		include <sys/filio.h>
+#	endif
+
+typedef int SOCKET;
+#	define INVALID_SOCKET		-1
+#	define SOCKET_ERROR			-1
+#	define closesocket			close
+#	define ioctlsocket			ioctl
+typedef int	ioctlarg_t;
+#	define socketError			errno
+#	ifndef MSG_NOSIGNAL
+#		define MSG_NOSIGNAL		0
+#	endif
+
+#endif
+
+#define MAX_HTTP_CLIENTS		64
+#define HTTP_REQUEST_SIZE		2048
+#define HTTP_HEADER_SIZE		512
+#define HTTP_SEND_CHUNK			( 256 * 1024 )
+#define HTTP_IDLE_TIMEOUT		30000
+#define HTTP_POLL_MSEC			100
+
+typedef enum {
+	HC_FREE,
+	HC_READING,		// waiting for a complete request header
+	HC_SENDING		// sending the response header and file body
+} httpConnState_t;
+
+typedef struct {
+	SOCKET			sock;
+	httpConnState_t	state;
+	int				lastActivity;
+	qboolean		keepAlive;
+
+	char			request[HTTP_REQUEST_SIZE];
+	int				requestLen;
+
+	char			header[HTTP_HEADER_SIZE];
+	int				headerLen;
+	int				headerSent;
+
+#if defined( __linux__ )
+	int				fd;				// sendfile source, -1 if none
+#else
+	void			*mapped;		// Sys_MapFile'd body, NULL if none
+#endif
+	int				bodySize;
+	int				bodySent;
+} httpConn_t;
+
+typedef struct {
+	char			name[MAX_QPATH];	// gamedir/basename.pk3
+	char			path[MAX_OSPATH];
+} httpPak_t;
+
+typedef struct {
+	void			*thread;
+	void			*mutex;
+	volatile int	quit;
+	SOCKET			listener;
+	int				port;
+	int				maxClients;
+	httpConn_t		*conns;
+
+	// guarded by mutex
+	httpPak_t		*paks;
+	int				numPaks;
+	int				requests;
+	int				served;
+	int				notFound;
+	int				rejected;
+	double			bytesSent;
+
+	char			baseURL[MAX_CVAR_VALUE_STRING];
+} httpServer_t;
+
+static httpServer_t	svh = { NULL, NULL, 0, INVALID_SOCKET };
+
+static cvar_t	*sv_httpPort;
+static cvar_t	*sv_httpAddress;
+static cvar_t	*sv_httpURL;
+static cvar_t	*sv_httpMaxClients;
+
+/*
+====================
+SV_HTTP_SetNonBlocking
+====================
+*/
+static qboolean SV_HTTP_SetNonBlocking( SOCKET sock )
+{
+	ioctlarg_t	_true = 1;
+
+	return ioctlsocket( sock, FIONBIO, &_true ) != SOCKET_ERROR;
+}
+
+/*
+====================
+SV_HTTP_WouldBlock
+====================
+*/
+static qboolean SV_HTTP_WouldBlock( void )
+{
+	int err = socketError;
+
+#ifdef _WIN32
+	return err == EAGAIN;
+#else
+	return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+#endif
+}
+
+/*
+====================
+SV_HTTP_CloseBody
+====================
+*/
+static void SV_HTTP_CloseBody( httpConn_t *conn )
+{
+#if defined( __linux__ )
+	if( conn->fd >= 0 )
+		close( conn->fd );
+	conn->fd = -1;
+#else
+	if( conn->mapped )
+		Sys_UnmapFile( conn->mapped, conn->bodySize );
+	conn->mapped = NULL;
+#endif
+	conn->bodySize = conn->bodySent = 0;
+}
+
+/*
+====================
+SV_HTTP_CloseConn
+====================
+*/
+static void SV_HTTP_CloseConn( httpConn_t *conn )
+{
+	SV_HTTP_CloseBody( conn );
+	closesocket( conn->sock );
+	conn->sock = INVALID_SOCKET;
+	conn->state = HC_FREE;
+}
+
+/*
+====================
+SV_HTTP_OpenBody
+
+Looks up a published pak and opens it for sending, returns the
+file size or -1 if the name is not referenced or can't be opened
+====================
+*/
+static int SV_HTTP_OpenBody( httpConn_t *conn, const char *name )
+{
+	char	path[MAX_OSPATH];
+	int		i;
+
+	path[0] = '\0';
+	Sys_LockMutex( svh.mutex );
+	for( i = 0; i < svh.numPaks; i++ )
+	{
+		if( !Q_stricmp( svh.paks[i].name, name ) )
+		{
+			Q_strncpyz( path, svh.paks[i].path, sizeof( path ) );
+			break;
+		}
+	}
+	Sys_UnlockMutex( svh.mutex );
+
+	if( !path[0] )
+		return -1;
+
+#if defined( __linux__ )
+	{
+		struct stat	buf;
+
+		conn->fd = open( path, O_RDONLY );
+		if( conn->fd < 0 )
+			return -1;
+		if( fstat( conn->fd, &buf ) || !S_ISREG( buf.st_mode ) || buf.st_size > INT_MAX )
+		{
+			SV_HTTP_CloseBody( conn );
+			return -1;
+		}
+		conn->bodySize = (int)buf.st_size;
+	}
+#else
+	conn->mapped = Sys_MapFile( path, &conn->bodySize );
+	if( !conn->mapped )
+		return -1;
+#endif
+
+	conn->bodySent = 0;
+	return conn->bodySize;
+}
+
+/*
+====================
+SV_HTTP_Respond
+====================
+*/
+static void SV_HTTP_Respond( httpConn_t *conn, const char *status, int contentLength, const char *body )
+{
+	conn->headerLen = Q_snprintf( conn->header, sizeof( conn->header ),
+		"HTTP/1.1 %s\r\n"
+		"Server: " PRODUCT_NAME "\r\n"
+		"Content-Type: %s\r\n"
+		"Content-Length: %d\r\n"
+		"%s"
+		"Connection: %s\r\n"
+		"\r\n"
+		"%s",
+		status,
+		body ? "text/plain" : "application/zip",
+		contentLength,
+		!strncmp( status, "405", 3 ) ? "Allow: GET, HEAD\r\n" : "",
+		conn->keepAlive ? "keep-alive" : "close",
+		body ? body : "" );
+	if( conn->headerLen < 0 || conn->headerLen >= sizeof( conn->header ) )
+		conn->headerLen = sizeof( conn->header ) - 1;
+	conn->headerSent = 0;
+	conn->state = HC_SENDING;
+}
+
+/*
+====================
+SV_HTTP_RespondError
+====================
+*/
+static void SV_HTTP_RespondError( httpConn_t *conn, const char *status )
+{
+	char	body[64];
+
+	SV_HTTP_CloseBody( conn );
+	Q_snprintf( body, sizeof( body ), "%s\n", status );
+	SV_HTTP_Respond( conn, status, strlen( body ), body );
+}
+
+/*
+====================
+SV_HTTP_DecodePath
+
+Turns "/gamedir/pak.pk3?query" into "gamedir/pak.pk3"
+====================
+*/
+static qboolean SV_HTTP_DecodePath( const char *in, char *out, int outSize )
+{
+	int	len = 0;
+
+	while( *in == '/' )
+		in++;
+
+	for( ; *in && *in != '?' && *in != '#'; in++ )
+	{
+		int c = *in;
+
+		if( c == '%' )
+		{
+			int hi, lo;
+
+			if( !isxdigit( (unsigned char)in[1] ) || !isxdigit( (unsigned char)in[2] ) )
+				return qfalse;
+			hi = isdigit( in[1] ) ? in[1] - '0' : tolower( in[1] ) - 'a' + 10;
+			lo = isdigit( in[2] ) ? in[2] - '0' : tolower( in[2] ) - 'a' + 10;
+			c = ( hi << 4 ) | lo;
+			in += 2;
+		}
+
+		if( c < ' ' || c == '\\' || len >= outSize - 1 )
+			return qfalse;
+		out[len++] = c;
+	}
+	out[len] = '\0';
+
+	return len > 0 && !strstr( out, ".." );
+}
+
+/*
+====================
+SV_HTTP_HeaderHasToken
+
+Case insensitive search for a token in the value of a header line
+====================
+*/
+static qboolean SV_HTTP_HeaderHasToken( const char *headers, const char *name, const char *token )
+{
+	const char	*line;
+	int			nameLen = strlen( name );
+	int			tokenLen = strlen( token );
+
+	for( line = headers; line && *line; line = strstr( line, "\r\n" ), line = line ? line + 2 : NULL )
+	{
+		const char *p;
+
+		if( Q_stricmpn( line, name, nameLen ) || line[nameLen] != ':' )
+			continue;
+
+		for( p = line + nameLen + 1; *p && *p != '\r'; p++ )
+		{
+			if( !Q_stricmpn( p, token, tokenLen ) )
+				return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+/*
+====================
+SV_HTTP_ParseRequest
+
+Returns qfalse if the request header is not complete yet
+====================
+*/
+static qboolean SV_HTTP_ParseRequest( httpConn_t *conn )
+{
+	char		*end, *headers;
+	char		method[16], target[MAX_OSPATH], version[16];
+	char		name[MAX_QPATH];
+	int			consumed, size;
+	qboolean	head;
+
+	conn->request[conn->requestLen] = '\0';
+	end = strstr( conn->request, "\r\n\r\n" );
+	if( !end )
+	{
+		if( conn->requestLen >= sizeof( conn->request ) - 1 )
+		{
+			conn->keepAlive = qfalse;
+			conn->requestLen = 0;
+			SV_HTTP_RespondError( conn, "431 Request Header Fields Too Large" );
+			return qtrue;
+		}
+		return qfalse;
+	}
+	end[2] = '\0';
+	consumed = end + 4 - conn->request;
+
+	headers = strstr( conn->request, "\r\n" ) + 2;
+	if( sscanf( conn->request, "%15s %255s %15s", method, target, version ) != 3 ||
+		Q_stricmpn( version, "HTTP/1.", 7 ) )
+	{
+		conn->keepAlive = qfalse;
+		SV_HTTP_RespondError( conn, "400 Bad Request" );
+	}
+	else
+	{
+		if( !strcmp( version, "HTTP/1.0" ) )
+			conn->keepAlive = SV_HTTP_HeaderHasToken( headers, "Connection", "keep-alive" );
+		else
+			conn->keepAlive = !SV_HTTP_HeaderHasToken( headers, "Connection", "close" );
+
+		head = !strcmp( method, "HEAD" );
+		if( !head && strcmp( method, "GET" ) )
+		{
+			SV_HTTP_RespondError( conn, "405 Method Not Allowed" );
+		}
+		else if( !SV_HTTP_DecodePath( target, name, sizeof( name ) ) ||
+			( size = SV_HTTP_OpenBody( conn, name ) ) < 0 )
+		{
+			Sys_LockMutex( svh.mutex );
+			svh.notFound++;
+			Sys_UnlockMutex( svh.mutex );
+			SV_HTTP_RespondError( conn, "404 Not Found" );
+		}
+		else
+		{
+			if( head )
+				SV_HTTP_CloseBody( conn );
+			SV_HTTP_Respond( conn, "200 OK", size, NULL );
+
+			Sys_LockMutex( svh.mutex );
+			svh.served++;
+			Sys_UnlockMutex( svh.mutex );
+		}
+	}
+
+	Sys_LockMutex( svh.mutex );
+	svh.requests++;
+	Sys_UnlockMutex( svh.mutex );
+
+	// keep anything pipelined behind this request
+	memmove( conn->request, conn->request + consumed, conn->requestLen - consumed );
+	conn->requestLen -= consumed;
+	return qtrue;
+}
+
+/*
+====================
+SV_HTTP_Read
+====================
+*/
+static void SV_HTTP_Read( httpConn_t *conn )
+{
+	int	len;
+
+	len = recv( conn->sock, conn->request + conn->requestLen,
+		sizeof( conn->request ) - 1 - conn->requestLen, 0 );
+	if( len == 0 || ( len == SOCKET_ERROR && !SV_HTTP_WouldBlock( ) ) )
+	{
+		SV_HTTP_CloseConn( conn );
+		return;
+	}
+	if( len > 0 )
+	{
+		conn->requestLen += len;
+		conn->lastActivity = Sys_Milliseconds( );
+	}
+
+	SV_HTTP_ParseRequest( conn );
+}
+
+/*
+====================
+SV_HTTP_Write
+====================
+*/
+static void SV_HTTP_Write( httpConn_t *conn )
+{
+	int	len;
+
+	if( conn->headerSent < conn->headerLen )
+	{
+		len = send( conn->sock, conn->header + conn->headerSent,
+			conn->headerLen - conn->headerSent, MSG_NOSIGNAL );
+		if( len == SOCKET_ERROR )
+		{
+			if( !SV_HTTP_WouldBlock( ) )
+				SV_HTTP_CloseConn( conn );
+			return;
+		}
+		conn->headerSent += len;
+		conn->lastActivity = Sys_Milliseconds( );
+		if( conn->headerSent < conn->headerLen )
+			return;
+	}
+
+	if( conn->bodySent < conn->bodySize )
+	{
+		int chunk = MIN( conn->bodySize - conn->bodySent, HTTP_SEND_CHUNK );
+
+#if defined( __linux__ )
+		off_t offset = conn->bodySent;
+
+		len = sendfile( conn->sock, conn->fd, &offset, chunk );
+#else
+		len = send( conn->sock, (const char *)conn->mapped + conn->bodySent, chunk, MSG_NOSIGNAL );
+#endif
+		if( len == SOCKET_ERROR || len == 0 )
+		{
+			if( len == 0 || !SV_HTTP_WouldBlock( ) )
+				SV_HTTP_CloseConn( conn );
+			return;
+		}
+		conn->bodySent += len;
+		conn->lastActivity = Sys_Milliseconds( );
+
+		Sys_LockMutex( svh.mutex );
+		svh.bytesSent += len;
+		Sys_UnlockMutex( svh.mutex );
+
+		if( conn->bodySent < conn->bodySize )
+			return;
+	}
+
+	// response complete
+	SV_HTTP_CloseBody( conn );
+	if( !conn->keepAlive )
+	{
+		SV_HTTP_CloseConn( conn );
+		return;
+	}
+
+	conn->state = HC_READING;
+	if( conn->requestLen > 0 )
+		SV_HTTP_ParseRequest( conn );
+}
+
+/*
+====================
+SV_HTTP_Accept
+====================
+*/
+static void SV_HTTP_Accept( void )
+{
+	struct sockaddr_storage	from;
+	socklen_t				fromLen = sizeof( from );
+	SOCKET					sock;
+	int						i;
+
+	sock = accept( svh.listener, (struct sockaddr *)&from, &fromLen );
+	if( sock == INVALID_SOCKET )
+		return;
+
+	for( i = 0; i < svh.maxClients; i++ )
+	{
+		if( svh.conns[i].state == HC_FREE )
+			break;
+	}
+
+	if( i == svh.maxClients || !SV_HTTP_SetNonBlocking( sock ) )
+	{
+		static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\n"
+			"Content-Length: 0\r\nConnection: close\r\n\r\n";
+
+		send( sock, busy, sizeof( busy ) - 1, MSG_NOSIGNAL );
+		closesocket( sock );
+
+		Sys_LockMutex( svh.mutex );
+		svh.rejected++;
+		Sys_UnlockMutex( svh.mutex );
+		return;
+	}
+
+	Com_Memset( &svh.conns[i], 0, sizeof( svh.conns[i] ) );
+	svh.conns[i].sock = sock;
+#if defined( __linux__ )
+	svh.conns[i].fd = -1;
+#endif
+	svh.conns[i].state = HC_READING;
+	svh.conns[i].lastActivity = Sys_Milliseconds( );
+}
+
+/*
+====================
+SV_HTTP_Thread
+
+Never touches the zone, cvars or the console
+====================
+*/
+static void SV_HTTP_Thread( void *arg )
+{
+	while( !svh.quit )
+	{
+		fd_set			readSet, writeSet;
+		struct timeval	timeout;
+		SOCKET			highest = svh.listener;
+		int				i, now;
+
+		FD_ZERO( &readSet );
+		FD_ZERO( &writeSet );
+		FD_SET( svh.listener, &readSet );
+
+		for( i = 0; i < svh.maxClients; i++ )
+		{
+			httpConn_t *conn = &svh.conns[i];
+
+			if( conn->state == HC_READING )
+				FD_SET( conn->sock, &readSet );
+			else if( conn->state == HC_SENDING )
+				FD_SET( conn->sock, &writeSet );
+			else
+				continue;
+
+			if( conn->sock > highest )
+				highest = conn->sock;
+		}
+
+		timeout.tv_sec = 0;
+		timeout.tv_usec = HTTP_POLL_MSEC * 1000;
+		if( select( highest + 1, &readSet, &writeSet, NULL, &timeout ) < 0 )
+			continue;
+
+		now = Sys_Milliseconds( );
+		for( i = 0; i < svh.maxClients; i++ )
+		{
+			httpConn_t *conn = &svh.conns[i];
+
+			if( conn->state == HC_READING && FD_ISSET( conn->sock, &readSet ) )
+				SV_HTTP_Read( conn );
+			else if( conn->state == HC_SENDING && FD_ISSET( conn->sock, &writeSet ) )
+				SV_HTTP_Write( conn );
+			else if( conn->state != HC_FREE && now - conn->lastActivity > HTTP_IDLE_TIMEOUT )
+				SV_HTTP_CloseConn( conn );
+		}
+
+		if( FD_ISSET( svh.listener, &readSet ) )
+			SV_HTTP_Accept( );
+	}
+}
+
+/*
+====================
+SV_HTTP_UpdatePaks
+
+Hands the current list of downloadable paks to the listener thread,
+called after the referenced pak lists change
+====================
+*/
+void SV_HTTP_UpdatePaks( void )
+{
+	httpPak_t	*paks = NULL, *old;
+	int			numPaks = 0, i, alternate;
+
+	if( !svh.thread )
+		return;
+
+	if( ( sv_allowDownload->integer & DLF_ENABLE ) &&
+		!( sv_allowDownload->integer & DLF_NO_REDIRECT ) )
+	{
+		char	names[BIG_INFO_STRING * 2];
+
+		Q_strncpyz( names, FS_ReferencedPakNames( qfalse ), sizeof( names ) );
+		Q_strcat( names, sizeof( names ), " " );
+		Q_strcat( names, sizeof( names ), FS_ReferencedPakNames( qtrue ) );
+
+		Cmd_TokenizeStringIgnoreQuotes( names );
+		paks = Z_Malloc( MAX( Cmd_Argc( ), 1 ) * sizeof( *paks ) );
+		for( i = 0; i < Cmd_Argc( ); i++ )
+		{
+			const char	*path = FS_ReferencedPakPath( Cmd_Argv( i ) );
+			char		name[MAX_QPATH];
+
+			if( !path )
+				continue;
+
+			Com_sprintf( name, sizeof( name ), "%s.pk3", Cmd_Argv( i ) );
+			for( alternate = 0; alternate < numPaks; alternate++ )
+			{
+				if( !Q_stricmp( paks[alternate].name, name ) )
+					break;
+			}
+			if( alternate < numPaks )
+				continue;
+
+			Q_strncpyz( paks[numPaks].name, name, sizeof( paks[numPaks].name ) );
+			Q_strncpyz( paks[numPaks].path, path, sizeof( paks[numPaks].path ) );
+			numPaks++;
+		}
+	}
+
+	Sys_LockMutex( svh.mutex );
+	old = svh.paks;
+	svh.paks = paks;
+	svh.numPaks = numPaks;
+	Sys_UnlockMutex( svh.mutex );
+
+	if( old )
+		Z_Free( old );
+}
+
+/*
+====================
+SV_HTTP_Stop
+====================
+*/
+static void SV_HTTP_Stop( void )
+{
+	int	i;
+
+	if( !svh.thread )
+		return;
+
+	svh.quit = 1;
+	Sys_JoinThread( svh.thread );
+	svh.thread = NULL;
+
+	for( i = 0; i < svh.maxClients; i++ )
+	{
+		if( svh.conns[i].state != HC_FREE )
+			SV_HTTP_CloseConn( &svh.conns[i] );
+	}
+	Z_Free( svh.conns );
+	svh.conns = NULL;
+
+	closesocket( svh.listener );
+	svh.listener = INVALID_SOCKET;
+
+	if( svh.paks )
+		Z_Free( svh.paks );
+	svh.paks = NULL;
+	svh.numPaks = 0;
+
+	Sys_DestroyMutex( svh.mutex );
+	svh.mutex = NULL;
+	svh.baseURL[0] = '\0';
+
+	// drop the redirect from the serverinfo
+	cvar_modifiedFlags |= CVAR_SERVERINFO | CVAR_SYSTEMINFO;
+
+	Com_Printf( "HTTP download listener stopped\n" );
+}
+
+/*
+====================
+SV_HTTP_Start
+====================
+*/
+static void SV_HTTP_Start( void )
+{
+	struct sockaddr_in	address;
+	const char			*host;
+	int					i;
+
+	sv_httpPort->modified = qfalse;
+	sv_httpAddress->modified = qfalse;
+	sv_httpURL->modified = qfalse;
+	sv_httpMaxClients->modified = qfalse;
+
+	if( sv_httpPort->integer <= 0 || sv_httpPort->integer > 65535 )
+		return;
+
+	Com_Memset( &address, 0, sizeof( address ) );
+	address.sin_family = AF_INET;
+	address.sin_port = htons( (unsigned short)sv_httpPort->integer );
+	if( sv_httpAddress->string[0] )
+	{
+		address.sin_addr.s_addr = inet_addr( sv_httpAddress->string );
+		if( address.sin_addr.s_addr == INADDR_NONE )
+		{
+			Com_Printf( S_COLOR_YELLOW "WARNING: sv_httpAddress \"%s\" is not an IPv4 address\n",
+				sv_httpAddress->string );
+			return;
+		}
+	}
+	else
+		address.sin_addr.s_addr = INADDR_ANY;
+
+	svh.listener = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if( svh.listener == INVALID_SOCKET )
+	{
+		Com_Printf( S_COLOR_YELLOW "WARNING: SV_HTTP_Start: socket: %d\n", socketError );
+		return;
+	}
+
+	i = 1;
+	setsockopt( svh.listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&i, sizeof( i ) );
+
+	if( bind( svh.listener, (struct sockaddr *)&address, sizeof( address ) ) == SOCKET_ERROR ||
+		listen( svh.listener, 16 ) == SOCKET_ERROR ||
+		!SV_HTTP_SetNonBlocking( svh.listener ) )
+	{
+		Com_Printf( S_COLOR_YELLOW "WARNING: could not listen for HTTP downloads on port %d: %d\n",
+			sv_httpPort->integer, socketError );
+		closesocket( svh.listener );
+		svh.listener = INVALID_SOCKET;
+		return;
+	}
+
+#ifndef _WIN32
+	// sendfile and send report a dropped peer with EPIPE as well
+	signal( SIGPIPE, SIG_IGN );
+#endif
+
+	svh.port = sv_httpPort->integer;
+	svh.maxClients = sv_httpMaxClients->integer;
+	svh.maxClients = MAX( 1, MIN( svh.maxClients, MAX_HTTP_CLIENTS ) );
+	svh.conns = Z_Malloc( svh.maxClients * sizeof( *svh.conns ) );
+	for( i = 0; i < svh.maxClients; i++ )
+		svh.conns[i].sock = INVALID_SOCKET;
+
+	svh.requests = svh.served = svh.notFound = svh.rejected = 0;
+	svh.bytesSent = 0;
+	svh.quit = 0;
+	svh.mutex = Sys_CreateMutex( );
+	if( svh.mutex )
+		svh.thread = Sys_CreateThread( SV_HTTP_Thread, NULL );
+	if( !svh.thread )
+	{
+		Com_Printf( S_COLOR_YELLOW "WARNING: could not start the HTTP download thread\n" );
+		if( svh.mutex )
+			Sys_DestroyMutex( svh.mutex );
+		svh.mutex = NULL;
+		Z_Free( svh.conns );
+		svh.conns = NULL;
+		closesocket( svh.listener );
+		svh.listener = INVALID_SOCKET;
+		return;
+	}
+
+	// work out what to advertise as sv_dlURL
+	host = sv_httpAddress->string;
+	if( !host[0] || !strcmp( host, "0.0.0.0" ) )
+		host = Cvar_VariableString( "net_ip" );
+
+	if( sv_httpURL->string[0] )
+		Q_strncpyz( svh.baseURL, sv_httpURL->string, sizeof( svh.baseURL ) );
+	else if( host[0] && strcmp( host, "0.0.0.0" ) && Q_stricmp( host, "localhost" ) )
+		Com_sprintf( svh.baseURL, sizeof( svh.baseURL ), "http://%s:%d", host, svh.port );
+	else
+		Com_Printf( S_COLOR_YELLOW "WARNING: set sv_httpURL or net_ip so clients can be "
+			"redirected to the HTTP download listener\n" );
+
+	SV_HTTP_UpdatePaks( );
+	cvar_modifiedFlags |= CVAR_SERVERINFO | CVAR_SYSTEMINFO;
+
+	Com_Printf( "HTTP download listener on port %d%s%s\n", svh.port,
+		svh.baseURL[0] ? ", advertised as " : "", svh.baseURL );
+}
+
+/*
+====================
+SV_HTTP_BaseURL
+
+The URL to advertise in place of sv_dlURL, or an empty string
+====================
+*/
+const char *SV_HTTP_BaseURL( void )
+{
+	return svh.thread ? svh.baseURL : "";
+}
+
+/*
+====================
+SV_HTTP_Frame
+
+Restarts the listener when its cvars change
+====================
+*/
+void SV_HTTP_Frame( void )
+{
+	if( sv_httpPort->modified || sv_httpAddress->modified ||
+		sv_httpURL->modified || sv_httpMaxClients->modified )
+	{
+		SV_HTTP_Stop( );
+		SV_HTTP_Start( );
+	}
+
+	if( sv_allowDownload->modified )
+	{
+		sv_allowDownload->modified = qfalse;
+		SV_HTTP_UpdatePaks( );
+	}
+}
+
+/*
+====================
+SV_HTTP_Status_f
+====================
+*/
+static void SV_HTTP_Status_f( void )
+{
+	int	i, active = 0;
+
+	if( !svh.thread )
+	{
+		Com_Printf( "HTTP download listener is not running (sv_httpPort is %d)\n",
+			sv_httpPort->integer );
+		return;
+	}
+
+	Sys_LockMutex( svh.mutex );
+	for( i = 0; i < svh.maxClients; i++ )
+	{
+		if( svh.conns[i].state == HC_SENDING )
+			active++;
+	}
+	Com_Printf( "port %d, %d paks downloadable, %d of %d connections sending\n",
+		svh.port, svh.numPaks, active, svh.maxClients );
+	Com_Printf( "%d requests, %d served, %d not found, %d rejected, %.1f MB sent\n",
+		svh.requests, svh.served, svh.notFound, svh.rejected, svh.bytesSent / ( 1024.0 * 1024.0 ) );
+	for( i = 0; i < svh.numPaks; i++ )
+		Com_Printf( "  %s\n", svh.paks[i].name );
+	Sys_UnlockMutex( svh.mutex );
+}
+
+/*
+====================
+SV_HTTP_Init
+====================
+*/
+void SV_HTTP_Init( void )
+{
+	sv_httpPort = Cvar_Get( "sv_httpPort", "0", CVAR_ARCHIVE );
+	sv_httpAddress = Cvar_Get( "sv_httpAddress", "", CVAR_ARCHIVE );
+	sv_httpURL = Cvar_Get( "sv_httpURL", "", CVAR_ARCHIVE );
+	sv_httpMaxClients = Cvar_Get( "sv_httpMaxClients", "32", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_httpMaxClients, 1, MAX_HTTP_CLIENTS, qtrue );
+
+	// pick up the initial values on the first frame
+	sv_httpPort->modified = qtrue;
+
+	Cmd_AddCommand( "httpstatus", SV_HTTP_Status_f );
+}
+
+/*
+====================
+SV_HTTP_Shutdown
+====================
+*/
+void SV_HTTP_Shutdown( void )
+{
+	SV_HTTP_Stop( );
+	sv_httpPort->modified = qtrue;
+}
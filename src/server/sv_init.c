@@ -764,38 +764,58 @@ size_t SV_Scrim_Get_Last_Roster_ID(void) {
 
 /*
 ===============
-SV_SendConfigstring
+SV_ClearConfigstringCommands
+===============
+*/
+static void SV_ClearConfigstringCommands( configString_t *cs, int alternateProtocol )
+{
+	if ( cs->commands[ alternateProtocol ] ) {
+		Z_Free( cs->commands[ alternateProtocol ] );
+		cs->commands[ alternateProtocol ] = NULL;
+	}
+}
 
-Creates and sends the server command necessary to update the CS index for the
-given client
+/*
+===============
+SV_ConfigstringCommands
+
+The server commands that update the CS index for clients on the given
+protocol, each with its terminating zero and ended by an empty one.  They
+are built the first time they are needed after the configstring changes
+and shared by all those clients.
 ===============
 */
-static void SV_SendConfigstring(client_t *client, int index)
+static const char *SV_ConfigstringCommands( int index, int alternateProtocol )
 {
+	configString_t *cs = &sv.configstrings[index];
 	const char *configstring;
 	int maxChunkSize = MAX_STRING_CHARS - 24;
-	int len;
+	int len, size;
+	char *p, *end;
 
-	if( sv.configstrings[index].restricted && Com_ClientListContains(
-		&sv.configstrings[index].clientList, client - svs.clients ) ) {
-		// Send a blank config string for this client if it's listed
-		SV_SendServerCommand( client, "cs %i \"\"\n", index );
-		return;
+	if ( cs->commands[ alternateProtocol ] ) {
+		return cs->commands[ alternateProtocol ];
 	}
 
-	if ( index <= CS_SYSTEMINFO && client->netchan.alternateProtocol != 0 ) {
-		configstring = alternateInfos[index][ client->netchan.alternateProtocol - 1 ];
+	svs.protocolStats[ alternateProtocol ].configstringsBuilt++;
+
+	if ( index <= CS_SYSTEMINFO && alternateProtocol != 0 ) {
+		configstring = alternateInfos[index][ alternateProtocol - 1 ];
 	} else {
-		configstring = sv.configstrings[index].s;
+		configstring = cs->s;
 	}
 
 	len = strlen(configstring);
 
+	// no more than 32 characters around each chunk, and the last zero
+	size = len + ( len / ( maxChunkSize - 1 ) + 1 ) * 32 + 1;
+	p = cs->commands[ alternateProtocol ] = Z_Malloc( size );
+	end = p + size - 1;
+
 	if( len >= maxChunkSize ) {
 		int		sent = 0;
 		int		remaining = len;
 		char	*cmd;
-		char	buf[MAX_STRING_CHARS];
 
 		while (remaining > 0 ) {
 			if ( sent == 0 ) {
@@ -807,19 +827,45 @@ static void SV_SendConfigstring(client_t *client, int index)
 			else {
 				cmd = "bcs1";
 			}
-			Q_strncpyz( buf, &configstring[sent],
-				maxChunkSize );
 
-			SV_SendServerCommand( client, "%s %i \"%s\"\n", cmd,
-				index, buf );
+			p += Com_sprintf( p, end - p, "%s %i \"%.*s\"\n", cmd,
+				index, maxChunkSize - 1, &configstring[sent] ) + 1;
 
 			sent += (maxChunkSize - 1);
 			remaining -= (maxChunkSize - 1);
 		}
 	} else {
 		// standard cs, just send it
-		SV_SendServerCommand( client, "cs %i \"%s\"\n", index,
-			configstring );
+		Com_sprintf( p, end - p, "cs %i \"%s\"\n", index, configstring );
+	}
+
+	return cs->commands[ alternateProtocol ];
+}
+
+/*
+===============
+SV_SendConfigstring
+
+Sends the server commands necessary to update the CS index for the
+given client
+===============
+*/
+static void SV_SendConfigstring(client_t *client, int index)
+{
+	const char *cmd;
+
+	if( sv.configstrings[index].restricted && Com_ClientListContains(
+		&sv.configstrings[index].clientList, client - svs.clients ) ) {
+		// Send a blank config string for this client if it's listed
+		SV_SendServerCommand( client, "cs %i \"\"\n", index );
+		return;
+	}
+
+	svs.protocolStats[ client->netchan.alternateProtocol ].configstrings++;
+
+	for ( cmd = SV_ConfigstringCommands( index, client->netchan.alternateProtocol );
+		*cmd; cmd += strlen( cmd ) + 1 ) {
+		SV_AddServerCommand( client, cmd );
 	}
 }
 
@@ -860,6 +906,7 @@ void SV_SetConfigstring (int index, const char *val) {
 	qboolean modified[3] = { qfalse, qfalse, qfalse };
 	int		i;
 	client_t	*client;
+	char	serverInfo[MAX_INFO_STRING];
 
 	if ( index < 0 || index >= MAX_CONFIGSTRINGS ) {
 		Com_Error (ERR_DROP, "SV_SetConfigstring: bad index %i", index);
@@ -869,7 +916,16 @@ void SV_SetConfigstring (int index, const char *val) {
 		val = "";
 	}
 
+	// point download redirects at the built in HTTP listener
+	if ( index == CS_SERVERINFO && *SV_HTTP_BaseURL( ) ) {
+		Q_strncpyz( serverInfo, val, sizeof( serverInfo ) );
+		Info_SetValueForKey( serverInfo, "sv_dlURL", SV_HTTP_BaseURL( ) );
+		val = serverInfo;
+	}
+
 	if ( index <= CS_SYSTEMINFO ) {
+		SV_InvalidateStatusCache( );
+
 		for ( i = 1; i < 3; ++i ) {
 			char info[BIG_INFO_STRING];
 
@@ -877,13 +933,14 @@ void SV_SetConfigstring (int index, const char *val) {
 			if ( index == CS_SERVERINFO ) {
 				Info_SetValueForKey_Big( info, "protocol", ( i == 1 ? "70" : "69" ) );
 			} else if ( i == 2 ) {
-				Info_SetValueForKey_Big( info, "sv_paks", Cvar_VariableString( "sv_alternatePaks" ) );
-				Info_SetValueForKey_Big( info, "sv_pakNames", Cvar_VariableString( "sv_alternatePakNames" ) );
-				Info_SetValueForKey_Big( info, "sv_referencedPaks", Cvar_VariableString( "sv_referencedAlternatePaks" ) );
-				Info_SetValueForKey_Big( info, "sv_referencedPakNames", Cvar_VariableString( "sv_referencedAlternatePakNames" ) );
+				Info_SetValueForKey_Big( info, "sv_paks", sv_alternatePaks->string );
+				Info_SetValueForKey_Big( info, "sv_pakNames", sv_alternatePakNames->string );
+				Info_SetValueForKey_Big( info, "sv_referencedPaks", sv_referencedAlternatePaks->string );
+				Info_SetValueForKey_Big( info, "sv_referencedPakNames", sv_referencedAlternatePakNames->string );
 				Info_SetValueForKey_Big( info, "cl_allowDownload", "1, you should set it yourself" );
 				if ( !( sv_allowDownload->integer & DLF_NO_REDIRECT ) ) {
-					Info_SetValueForKey_Big( info, "sv_wwwBaseURL", Cvar_VariableString( "sv_dlUrl" ) );
+					Info_SetValueForKey_Big( info, "sv_wwwBaseURL", *SV_HTTP_BaseURL( ) ?
+						SV_HTTP_BaseURL( ) : sv_dlURL->string );
 					Info_SetValueForKey_Big( info, "sv_wwwDownload", Cvar_VariableString( "1, you should set it yourself" ) );
 				}
 			}
@@ -891,6 +948,7 @@ void SV_SetConfigstring (int index, const char *val) {
 			if ( strcmp( info, alternateInfos[index][i - 1] ) ) {
 				modified[i] = qtrue;
 				strcpy( alternateInfos[index][i - 1], info );
+				SV_ClearConfigstringCommands( &sv.configstrings[index], i );
 			}
 		}
 
@@ -898,6 +956,7 @@ void SV_SetConfigstring (int index, const char *val) {
 			modified[0] = qtrue;
 			Z_Free( sv.configstrings[index].s );
 			sv.configstrings[index].s = CopyString( val );
+			SV_ClearConfigstringCommands( &sv.configstrings[index], 0 );
 		}
 
 		if ( !modified[0] && !modified[1] && !modified[2] ) {
@@ -912,6 +971,13 @@ void SV_SetConfigstring (int index, const char *val) {
 		// change the string in sv
 		Z_Free( sv.configstrings[index].s );
 		sv.configstrings[index].s = CopyString( val );
+		for ( i = 0; i < 3; i++ ) {
+			SV_ClearConfigstringCommands( &sv.configstrings[index], i );
+		}
+	}
+
+	if ( index > CS_SYSTEMINFO || modified[0] ) {
+		SV_DemoConfigstring( index );
 	}
 
 	// send it to all the clients if we aren't
@@ -1086,12 +1152,7 @@ static void SV_Startup( void ) {
 	SV_BoundMaxClients( 1 );
 
 	svs.clients = Z_Malloc (sizeof(client_t) * sv_maxclients->integer );
-	if ( com_dedicated->integer ) {
-		svs.numSnapshotEntities = sv_maxclients->integer * PACKET_BACKUP * MAX_SNAPSHOT_ENTITIES;
-	} else {
-		// we don't need nearly as many when playing locally
-		svs.numSnapshotEntities = sv_maxclients->integer * 4 * MAX_SNAPSHOT_ENTITIES;
-	}
+	svs.numSnapshotEntities = SV_SnapshotEntitiesForClients( sv_maxclients->integer );
 	svs.initialized = qtrue;
 
 	// Don't respect sv_killserver unless a server is actually running
@@ -1164,12 +1225,7 @@ void SV_ChangeMaxClients( void ) {
 	Hunk_FreeTempMemory( oldClients );
 
 	// allocate new snapshot entities
-	if ( com_dedicated->integer ) {
-		svs.numSnapshotEntities = sv_maxclients->integer * PACKET_BACKUP * MAX_SNAPSHOT_ENTITIES;
-	} else {
-		// we don't need nearly as many when playing locally
-		svs.numSnapshotEntities = sv_maxclients->integer * 4 * MAX_SNAPSHOT_ENTITIES;
-	}
+	svs.numSnapshotEntities = SV_SnapshotEntitiesForClients( sv_maxclients->integer );
 }
 
 /*
@@ -1178,7 +1234,7 @@ SV_ClearServer
 ================
 */
 static void SV_ClearServer(void) {
-	int i;
+	int i, j;
 
 	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
 		if ( i <= CS_SYSTEMINFO ) {
@@ -1187,6 +1243,9 @@ static void SV_ClearServer(void) {
 		if ( sv.configstrings[i].s ) {
 			Z_Free( sv.configstrings[i].s );
 		}
+		for ( j = 0; j < 3; j++ ) {
+			SV_ClearConfigstringCommands( &sv.configstrings[i], j );
+		}
 	}
 	Com_Memset (&sv, 0, sizeof(sv));
 }
@@ -1224,6 +1283,9 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	char		systemInfo[16384];
 	const char	*p;
 
+	// the recording holds on to the snapshot entities about to be freed
+	SV_DemoStopRecord();
+
 	// shut down the existing game if it is running
 	SV_ShutdownGameProgs();
 
@@ -1257,8 +1319,8 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	FS_ClearPakReferences(0);
 
 	// allocate the snapshot entities on the hunk
-	svs.snapshotEntities = Hunk_Alloc( sizeof(entityState_t)*svs.numSnapshotEntities, h_high );
-	svs.nextSnapshotEntities = 0;
+	svs.snapshotEntities = Hunk_Alloc( sizeof(snapshotEntity_t)*svs.numSnapshotEntities, h_high );
+	SV_InitSnapshotEntities();
 
 	// toggle the server bit so clients can detect that a
 	// server has changed
@@ -1269,6 +1331,9 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 		if (svs.clients[i].state >= CS_CONNECTED) {
 			svs.clients[i].oldServerTime = sv.time;
 		}
+
+		// entity numbers will mean something else on the new map
+		Com_Memset( svs.clients[i].snapshotDeferred, 0, sizeof( svs.clients[i].snapshotDeferred ) );
 	}
 
 	// wipe the entire per-level structure
@@ -1388,6 +1453,7 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	Cvar_Set( "sv_referencedPakNames", p );
 	p = FS_ReferencedPakNames( qtrue );
 	Cvar_Set( "sv_referencedAlternatePakNames", p );
+	SV_HTTP_UpdatePaks();
 
 	// save systeminfo and serverinfo strings
 	Q_strncpyz( systemInfo, Cvar_InfoString_Big( CVAR_SYSTEMINFO ), sizeof( systemInfo ) );
@@ -1440,6 +1506,33 @@ void SV_WriteAttackLog(const char *log)
 	}
 }
 
+/**
+ * @brief Lets one message of a kind through per second, so a flood doesn't
+ * turn into a synced attack log write per packet. Writes how many were
+ * held back when the next one is let through.
+ * @param[in,out] limit
+ * @return qtrue if the message should be written
+ */
+qboolean SV_AttackLogAllowed(attackLogLimit_t *limit)
+{
+	int now = Sys_Milliseconds();
+
+	if (limit->lastTime && now - limit->lastTime < 1000 && now >= limit->lastTime)
+	{
+		limit->suppressed++;
+		return qfalse;
+	}
+
+	if (limit->suppressed)
+	{
+		SV_WriteAttackLog(va("(%i similar messages suppressed)\n", limit->suppressed));
+		limit->suppressed = 0;
+	}
+
+	limit->lastTime = now;
+	return qtrue;
+}
+
 /**
  * @brief SV_InitAttackLog
  */
@@ -1530,10 +1623,10 @@ void SV_Init (void)
 	Cvar_Get ("sv_pakNames", "", CVAR_SYSTEMINFO | CVAR_ROM );
 	Cvar_Get ("sv_referencedPaks", "", CVAR_SYSTEMINFO | CVAR_ROM );
 	Cvar_Get ("sv_referencedPakNames", "", CVAR_SYSTEMINFO | CVAR_ROM );
-	Cvar_Get ("sv_alternatePaks", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
-	Cvar_Get ("sv_alternatePakNames", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
-	Cvar_Get ("sv_referencedAlternatePaks", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
-	Cvar_Get ("sv_referencedAlternatePakNames", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
+	sv_alternatePaks = Cvar_Get ("sv_alternatePaks", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
+	sv_alternatePakNames = Cvar_Get ("sv_alternatePakNames", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
+	sv_referencedAlternatePaks = Cvar_Get ("sv_referencedAlternatePaks", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
+	sv_referencedAlternatePakNames = Cvar_Get ("sv_referencedAlternatePakNames", "", CVAR_ALTERNATE_SYSTEMINFO | CVAR_ROM );
 
 	// server vars
 	sv_rconPassword = Cvar_Get ("rconPassword", "", CVAR_TEMP );
@@ -1543,7 +1636,8 @@ void SV_Init (void)
 	sv_zombietime = Cvar_Get ("sv_zombietime", "2", CVAR_TEMP );
 
 	sv_allowDownload = Cvar_Get ("sv_allowDownload", "0", CVAR_SERVERINFO);
-	Cvar_Get ("sv_dlURL", "http://downloads.tremulous.net", CVAR_SERVERINFO | CVAR_ARCHIVE);
+	sv_dlURL = Cvar_Get ("sv_dlURL", "http://downloads.tremulous.net", CVAR_SERVERINFO | CVAR_ARCHIVE);
+	SV_HTTP_Init();
 
 	sv_protect    = Cvar_Get("sv_protect", "7", CVAR_ARCHIVE);
 	sv_protectLog = Cvar_Get("sv_protectLog", "sv_protect.log", CVAR_ARCHIVE);
@@ -1562,6 +1656,7 @@ void SV_Init (void)
 	sv_killserver = Cvar_Get ("sv_killserver", "0", 0);
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
 	sv_lanForceRate = Cvar_Get ("sv_lanForceRate", "1", CVAR_ARCHIVE );
+	sv_snapshotPriority = Cvar_Get ("sv_snapshotPriority", "1", CVAR_ARCHIVE );
 }
 
 
@@ -1623,6 +1718,8 @@ void SV_Shutdown( char *finalmsg ) {
 
 	SV_RemoveOperatorCommands();
 	SV_MasterShutdown();
+	SV_HTTP_Shutdown();
+	SV_DemoStopRecord();
 	SV_ShutdownGameProgs();
 
 	// free current level
@@ -58,7 +58,15 @@ cvar_t	*sv_minPing;
 cvar_t	*sv_maxPing;
 cvar_t	*sv_pure;
 cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
+cvar_t	*sv_snapshotPriority;	// hold back the least important entities instead of overflowing the rate
 cvar_t	*sv_banFile;
+cvar_t	*sv_dlURL;
+
+// 1.1 clients get these in place of sv_paks and friends
+cvar_t	*sv_alternatePaks;
+cvar_t	*sv_alternatePakNames;
+cvar_t	*sv_referencedAlternatePaks;
+cvar_t	*sv_referencedAlternatePakNames;
 
 // server attack protection
 cvar_t *sv_protect;     // 0 - unprotected
@@ -203,6 +211,8 @@ void QDECL SV_SendServerCommand(client_t *cl, const char *fmt, ...) {
 	  return;
 	}
 
+	SV_DemoServerCommand( cl, (char *)message );
+
 	if ( cl != NULL ) {
 		SV_AddServerCommand( cl, (char *)message );
 		return;
@@ -375,22 +385,60 @@ CONNECTIONLESS COMMANDS
 
 // This is deliberately quite large to make it more of an effort to DoS
 #define MAX_BUCKETS			16384
-#define MAX_HASHES			1024
+#define MAX_HASHES			4096
 
 static leakyBucket_t buckets[ MAX_BUCKETS ];
 static leakyBucket_t *bucketHashes[ MAX_HASHES ];
 leakyBucket_t outboundLeakyBucket;
 
+// buckets not in use, and buckets in use from least to most recently hit
+static leakyBucket_t *freeBuckets;
+static leakyBucket_t *bucketLRUHead, *bucketLRUTail;
+static qboolean bucketsInitialized;
+static unsigned int bucketHashSeed;
+
+/*
+================
+SVC_ClearBuckets
+
+Forgets every address bucket
+================
+*/
+static void SVC_ClearBuckets( void ) {
+	int		i;
+
+	Com_Memset( buckets, 0, sizeof( buckets ) );
+	Com_Memset( bucketHashes, 0, sizeof( bucketHashes ) );
+
+	freeBuckets = NULL;
+	for ( i = MAX_BUCKETS - 1; i >= 0; i-- ) {
+		buckets[ i ].next = freeBuckets;
+		freeBuckets = &buckets[ i ];
+	}
+	bucketLRUHead = bucketLRUTail = NULL;
+	bucketsInitialized = qtrue;
+}
+
 /*
 ================
 SVC_HashForAddress
+
+FNV-1a over the address bytes followed by a full avalanche, so that
+neighbouring IPv4 addresses spread over the whole table
 ================
 */
 static long SVC_HashForAddress( netadr_t address ) {
 	byte 		*ip = NULL;
 	size_t	size = 0;
 	int			i;
-	long		hash = 0;
+	unsigned int	hash;
+
+	if ( !bucketsInitialized ) {
+		// seeded so the chains can't be lined up from outside, once for
+		// the server's lifetime as the info receipts keep these hashes
+		Com_RandomBytes( (byte *)&bucketHashSeed, sizeof( bucketHashSeed ) );
+		SVC_ClearBuckets( );
+	}
 
 	switch ( address.type ) {
 		case NA_IP:  ip = address.ip;  size = 4; break;
@@ -398,14 +446,79 @@ static long SVC_HashForAddress( netadr_t address ) {
 		default: break;
 	}
 
+	hash = 2166136261u ^ bucketHashSeed;
 	for ( i = 0; i < size; i++ ) {
-		hash += (long)( ip[ i ] ) * ( i + 119 );
+		hash ^= ip[ i ];
+		hash *= 16777619u;
 	}
 
-	hash = ( hash ^ ( hash >> 10 ) ^ ( hash >> 20 ) );
-	hash &= ( MAX_HASHES - 1 );
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
 
-	return hash;
+	return hash & ( MAX_HASHES - 1 );
+}
+
+/*
+================
+SVC_UnlinkBucketLRU
+================
+*/
+static void SVC_UnlinkBucketLRU( leakyBucket_t *bucket ) {
+	if ( bucket->lruPrev != NULL ) {
+		bucket->lruPrev->lruNext = bucket->lruNext;
+	} else {
+		bucketLRUHead = bucket->lruNext;
+	}
+
+	if ( bucket->lruNext != NULL ) {
+		bucket->lruNext->lruPrev = bucket->lruPrev;
+	} else {
+		bucketLRUTail = bucket->lruPrev;
+	}
+}
+
+/*
+================
+SVC_LinkBucketLRU
+
+Makes the bucket the most recently used
+================
+*/
+static void SVC_LinkBucketLRU( leakyBucket_t *bucket ) {
+	bucket->lruNext = NULL;
+	bucket->lruPrev = bucketLRUTail;
+	if ( bucketLRUTail != NULL ) {
+		bucketLRUTail->lruNext = bucket;
+	} else {
+		bucketLRUHead = bucket;
+	}
+	bucketLRUTail = bucket;
+}
+
+/*
+================
+SVC_FreeBucket
+================
+*/
+static void SVC_FreeBucket( leakyBucket_t *bucket ) {
+	if ( bucket->prev != NULL ) {
+		bucket->prev->next = bucket->next;
+	} else {
+		bucketHashes[ bucket->hash ] = bucket->next;
+	}
+
+	if ( bucket->next != NULL ) {
+		bucket->next->prev = bucket->prev;
+	}
+
+	SVC_UnlinkBucketLRU( bucket );
+
+	Com_Memset( bucket, 0, sizeof( leakyBucket_t ) );
+	bucket->next = freeBuckets;
+	freeBuckets = bucket;
 }
 
 /*
@@ -417,74 +530,60 @@ Find or allocate a bucket for an address
 */
 static leakyBucket_t *SVC_BucketForAddress( netadr_t address, int burst, int period ) {
 	leakyBucket_t	*bucket = NULL;
-	int						i;
 	long					hash = SVC_HashForAddress( address );
 	int						now = Sys_Milliseconds();
 
 	for ( bucket = bucketHashes[ hash ]; bucket; bucket = bucket->next ) {
-		switch ( bucket->type ) {
-			case NA_IP:
-				if ( memcmp( bucket->ipv._4, address.ip, 4 ) == 0 ) {
-					return bucket;
-				}
-				break;
-
-			case NA_IP6:
-				if ( memcmp( bucket->ipv._6, address.ip6, 16 ) == 0 ) {
-					return bucket;
-				}
-				break;
+		if ( bucket->type != address.type ) {
+			continue;
+		}
 
-			default:
-				break;
+		if ( ( address.type == NA_IP && memcmp( bucket->ipv._4, address.ip, 4 ) == 0 ) ||
+			( address.type == NA_IP6 && memcmp( bucket->ipv._6, address.ip6, 16 ) == 0 ) ) {
+			SVC_UnlinkBucketLRU( bucket );
+			SVC_LinkBucketLRU( bucket );
+			return bucket;
 		}
 	}
 
-	for ( i = 0; i < MAX_BUCKETS; i++ ) {
-		int interval;
+	// Reclaim expired buckets, the least recently hit ones are at the head
+	while ( bucketLRUHead != NULL ) {
+		int interval = now - bucketLRUHead->lastTime;
 
-		bucket = &buckets[ i ];
-		interval = now - bucket->lastTime;
+		if ( interval <= ( burst * period ) && interval >= 0 ) {
+			break;
+		}
 
-		// Reclaim expired buckets
-		if ( bucket->lastTime > 0 && ( interval > ( burst * period ) ||
-					interval < 0 ) ) {
-			if ( bucket->prev != NULL ) {
-				bucket->prev->next = bucket->next;
-			} else {
-				bucketHashes[ bucket->hash ] = bucket->next;
-			}
+		SVC_FreeBucket( bucketLRUHead );
+	}
 
-			if ( bucket->next != NULL ) {
-				bucket->next->prev = bucket->prev;
-			}
+	if ( freeBuckets != NULL ) {
+		bucket = freeBuckets;
+		freeBuckets = bucket->next;
 
-			Com_Memset( bucket, 0, sizeof( leakyBucket_t ) );
+		bucket->type = address.type;
+		switch ( address.type ) {
+			case NA_IP:  Com_Memcpy( bucket->ipv._4, address.ip, 4 );   break;
+			case NA_IP6: Com_Memcpy( bucket->ipv._6, address.ip6, 16 ); break;
+			default: break;
 		}
 
-		if ( bucket->type == NA_BAD ) {
-			bucket->type = address.type;
-			switch ( address.type ) {
-				case NA_IP:  Com_Memcpy( bucket->ipv._4, address.ip, 4 );   break;
-				case NA_IP6: Com_Memcpy( bucket->ipv._6, address.ip6, 16 ); break;
-				default: break;
-			}
+		bucket->lastTime = now;
+		bucket->burst = 0;
+		bucket->hash = hash;
 
-			bucket->lastTime = now;
-			bucket->burst = 0;
-			bucket->hash = hash;
+		// Add to the head of the relevant hash chain
+		bucket->next = bucketHashes[ hash ];
+		if ( bucketHashes[ hash ] != NULL ) {
+			bucketHashes[ hash ]->prev = bucket;
+		}
 
-			// Add to the head of the relevant hash chain
-			bucket->next = bucketHashes[ hash ];
-			if ( bucketHashes[ hash ] != NULL ) {
-				bucketHashes[ hash ]->prev = bucket;
-			}
+		bucket->prev = NULL;
+		bucketHashes[ hash ] = bucket;
 
-			bucket->prev = NULL;
-			bucketHashes[ hash ] = bucket;
+		SVC_LinkBucketLRU( bucket );
 
-			return bucket;
-		}
+		return bucket;
 	}
 
 	// Couldn't allocate a bucket for this address
@@ -546,32 +645,293 @@ qboolean SVC_RateLimitAddress( netadr_t from, int burst, int period ) {
 	return SVC_RateLimit( bucket, burst, period );
 }
 
+/*
+=============================================================================
+
+Cached getstatus / getinfo responses
+
+Everything but the challenge is serialized once and reused until the
+serverinfo or systeminfo changes, a name changes, or SV_CheckStatusCache
+notices a connect, disconnect, score or ping change at the end of a
+frame.  Requests then only splice their challenge in.  The splicing
+reproduces what the Info_SetValueForKey calls in the uncached builders
+would give; a challenge that would be refused by them takes the slow
+path so the result stays identical.
+
+=============================================================================
+*/
+
+typedef struct {
+	qboolean	statusValid;
+	char		serverInfo[MAX_INFO_STRING];	// without challenge
+	int			serverInfoLen;
+	char		serverInfoNoProtocol[MAX_INFO_STRING];	// also without protocol
+	int			serverInfoNoProtocolLen;
+	char		players[MAX_MSGLEN];
+	int			playersLen;
+
+	qboolean	infoValid;
+	char		info[3][MAX_INFO_STRING];	// per alternateProtocol, without challenge
+	int			infoLen[3];
+
+	// what the player lines and client count were built from
+	qboolean	connected[MAX_CLIENTS];
+	int			scores[MAX_CLIENTS];
+	int			pings[MAX_CLIENTS];
+} statusCache_t;
+
+static statusCache_t	statusCache;
+
+static const char *statusProtocols[3] = { NULL, "70", "69" };
+
 /*
 ================
-SVC_Status
+SV_InvalidateStatusCache
+================
+*/
+void SV_InvalidateStatusCache( void ) {
+	statusCache.statusValid = qfalse;
+	statusCache.infoValid = qfalse;
+}
 
-Responds with all the info that qplug or qspy can see about the server
-and all connected players.  Used for getting detailed information after
-the simple info query.
+/*
+================
+SV_RecordStatusClients
 ================
 */
-static void SVC_Status( netadr_t from ) {
+static void SV_RecordStatusClients( void ) {
+	int		i;
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		statusCache.connected[i] = svs.clients[i].state >= CS_CONNECTED;
+		if ( statusCache.connected[i] ) {
+			statusCache.scores[i] = SV_GameClientNum( i )->persistant[PERS_SCORE];
+			statusCache.pings[i] = svs.clients[i].ping;
+		}
+	}
+}
+
+/*
+================
+SV_CheckStatusCache
+
+Called once per frame, drops the cached responses if a player
+connected, left, scored or changed ping
+================
+*/
+void SV_CheckStatusCache( void ) {
+	int		i;
+
+	if ( !statusCache.statusValid && !statusCache.infoValid ) {
+		return;
+	}
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		qboolean connected = svs.clients[i].state >= CS_CONNECTED;
+
+		if ( connected != statusCache.connected[i] ||
+			( connected && ( svs.clients[i].ping != statusCache.pings[i] ||
+			SV_GameClientNum( i )->persistant[PERS_SCORE] != statusCache.scores[i] ) ) ) {
+			SV_InvalidateStatusCache( );
+			return;
+		}
+	}
+}
+
+/*
+================
+SV_ChallengeSplicable
+
+Whether Info_SetValueForKey would store this challenge as is
+================
+*/
+static qboolean SV_ChallengeSplicable( const char *challenge ) {
+	return !strpbrk( challenge, "\\;\"" );
+}
+
+/*
+================
+SV_BuildStatusPlayers
+================
+*/
+static int SV_BuildStatusPlayers( char *status, int size ) {
 	char	player[1024];
-	char	status[MAX_MSGLEN];
 	int		i;
 	client_t	*cl;
 	playerState_t	*ps;
 	int		statusLength;
 	int		playerLength;
+
+	status[0] = 0;
+	statusLength = 0;
+
+	for (i=0 ; i < sv_maxclients->integer ; i++) {
+		cl = &svs.clients[i];
+		if ( cl->state >= CS_CONNECTED ) {
+			ps = SV_GameClientNum( i );
+			Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n",
+				ps->persistant[PERS_SCORE], cl->ping, cl->name_ansi);
+			playerLength = strlen(player);
+			if (statusLength + playerLength >= size ) {
+				break;		// can't hold any more
+			}
+			strcpy (status + statusLength, player);
+			statusLength += playerLength;
+		}
+	}
+
+	return statusLength;
+}
+
+/*
+================
+SV_BuildInfoString
+
+Everything SVC_Info sends except the challenge
+================
+*/
+static void SV_BuildInfoString( char *infostring, int alternateProtocol ) {
+	int		i, count;
+	char	*gamedir;
+
+	// don't count privateclients
+	count = 0;
+	for ( i = sv_privateClients->integer ; i < sv_maxclients->integer ; i++ ) {
+		if ( svs.clients[i].state >= CS_CONNECTED ) {
+			count++;
+		}
+	}
+
+	Info_SetValueForKey( infostring, "protocol", va("%i", alternateProtocol == 2 ? 69 : alternateProtocol == 1 ? 70 : PROTOCOL_VERSION) );
+	Info_SetValueForKey( infostring, "gamename", com_gamename->string );
+	Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
+	Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
+	Info_SetValueForKey( infostring, "clients", va("%i", count) );
+	Info_SetValueForKey( infostring, "sv_maxclients",
+		va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
+	Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
+
+#ifdef USE_VOIP
+	if (sv_voip->integer) {
+		Info_SetValueForKey( infostring, "voip", va("%i", sv_voip->integer ) );
+	}
+#endif
+
+	if( sv_minPing->integer ) {
+		Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
+	}
+	if( sv_maxPing->integer ) {
+		Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
+	}
+	gamedir = Cvar_VariableString( "fs_game" );
+	if( *gamedir ) {
+		Info_SetValueForKey( infostring, "game", gamedir );
+	}
+}
+
+/*
+================
+SV_UpdateStatusCache
+================
+*/
+static void SV_UpdateStatusCache( qboolean status ) {
+	int		i;
+
+	// serverinfo cvars changed since the last frame
+	if ( cvar_modifiedFlags & ( CVAR_SERVERINFO | CVAR_SYSTEMINFO ) ) {
+		SV_InvalidateStatusCache( );
+	}
+
+	if ( status && !statusCache.statusValid ) {
+		Q_strncpyz( statusCache.serverInfo, Cvar_InfoString( CVAR_SERVERINFO ), sizeof( statusCache.serverInfo ) );
+		Info_RemoveKey( statusCache.serverInfo, "challenge" );
+		statusCache.serverInfoLen = strlen( statusCache.serverInfo );
+
+		Q_strncpyz( statusCache.serverInfoNoProtocol, statusCache.serverInfo, sizeof( statusCache.serverInfoNoProtocol ) );
+		Info_RemoveKey( statusCache.serverInfoNoProtocol, "protocol" );
+		statusCache.serverInfoNoProtocolLen = strlen( statusCache.serverInfoNoProtocol );
+
+		statusCache.playersLen = SV_BuildStatusPlayers( statusCache.players, sizeof( statusCache.players ) );
+		statusCache.statusValid = qtrue;
+		SV_RecordStatusClients( );
+	}
+
+	if ( !status && !statusCache.infoValid ) {
+		for ( i = 0; i < 3; i++ ) {
+			statusCache.info[i][0] = 0;
+			SV_BuildInfoString( statusCache.info[i], i );
+			statusCache.infoLen[i] = strlen( statusCache.info[i] );
+		}
+		statusCache.infoValid = qtrue;
+		SV_RecordStatusClients( );
+	}
+}
+
+/*
+================
+SV_SendSpliced
+
+Sends head, part and tail as one out of band print, cut where
+NET_OutOfBandPrint would cut it
+================
+*/
+static void SV_SendSpliced( netadr_t to, const char *head, int headLen,
+	const char *part, int partLen, const char *tail, int tailLen ) {
+	char	string[MAX_MSGLEN];
+	int		len = 4;
+
+	string[0] = -1;
+	string[1] = -1;
+	string[2] = -1;
+	string[3] = -1;
+
+#define SPLICE( p, l ) \
+	do { \
+		int n = MIN( (l), (int)sizeof( string ) - 1 - len ); \
+		Com_Memcpy( string + len, (p), n ); \
+		len += n; \
+	} while ( 0 )
+
+	SPLICE( head, headLen );
+	SPLICE( part, partLen );
+	SPLICE( tail, tailLen );
+#undef SPLICE
+
+	NET_SendPacket( NS_SERVER, len, string, to );
+}
+
+/*
+================
+SVC_Status
+
+Responds with all the info that qplug or qspy can see about the server
+and all connected players.  Used for getting detailed information after
+the simple info query.
+================
+*/
+static void SVC_Status( netadr_t from ) {
+	char	status[MAX_MSGLEN];
 	char	infostring[MAX_INFO_STRING];
+	char	*challenge;
+	char	head[64];
+	char	challengePart[160];
+	int		headLen, challengeLen;
+	const char	*info;
+	int		infoLen;
+	int		p;
 
 	if (sv_protect->integer & SVP_IOQ3)
 	{
+		static attackLogLimit_t addressLimit, outboundLimit;
+
 		// Prevent using getstatus as an amplifier
 		if (SVC_RateLimitAddress(from, 10, 1000))
 		{
-			SV_WriteAttackLog(va("SVC_Status: rate limit from %s exceeded, dropping request\n",
-			                     NET_AdrToString(from)));
+			if (SV_AttackLogAllowed(&addressLimit))
+			{
+				SV_WriteAttackLog(va("SVC_Status: rate limit from %s exceeded, dropping request\n",
+				                     NET_AdrToString(from)));
+			}
 			return;
 		}
 
@@ -579,46 +939,75 @@ static void SVC_Status( netadr_t from ) {
 		// excess outbound bandwidth usage when being flooded inbound
 		if (SVC_RateLimit(&outboundLeakyBucket, 10, 100))
 		{
-			SV_WriteAttackLog("SVC_Status: rate limit exceeded, dropping request\n");
+			if (SV_AttackLogAllowed(&outboundLimit))
+			{
+				SV_WriteAttackLog("SVC_Status: rate limit exceeded, dropping request\n");
+			}
 			return;
 		}
 	}
 
+	challenge = Cmd_Argv(1);
+
 	// A maximum challenge length of 128 should be more than plenty.
-	if (strlen(Cmd_Argv(1)) > 128)
+	if (strlen(challenge) > 128)
 	{
 		SV_WriteAttackLog(va("SVC_Status: challenge length exceeded from %s, dropping request\n", NET_AdrToString(from)));
 		return;
 	}
 
-	strcpy( infostring, Cvar_InfoString( CVAR_SERVERINFO ) );
+	SV_UpdateStatusCache( qtrue );
 
-	// echo back the parameter to status. so master servers can use it as a challenge
-	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
+	p = from.alternateProtocol;
+	if ( p < 0 || p > 2 ) {
+		p = 0;
+	}
+	if ( p != 0 ) {
+		info = statusCache.serverInfoNoProtocol;
+		infoLen = statusCache.serverInfoNoProtocolLen;
+	} else {
+		info = statusCache.serverInfo;
+		infoLen = statusCache.serverInfoLen;
+	}
 
-	if ( from.alternateProtocol != 0 )
-		Info_SetValueForKey( infostring, "protocol", from.alternateProtocol == 2 ? "69" : "70" );
+	// Info_SetValueForKey prepends, so the reply is
+	// [\protocol\NN][\challenge\...]serverinfo
+	challengeLen = 0;
+	if ( *challenge && SV_ChallengeSplicable( challenge ) ) {
+		challengeLen = Com_sprintf( challengePart, sizeof( challengePart ), "\\challenge\\%s", challenge );
+	}
 
-	status[0] = 0;
-	statusLength = 0;
+	// anything that wouldn't fit goes the slow way, so it is refused
+	// exactly as Info_SetValueForKey refuses it
+	if ( ( *challenge && !challengeLen ) ||
+		challengeLen + statusCache.serverInfoLen >= MAX_INFO_STRING ||
+		( p != 0 && strlen( "\\protocol\\" ) + strlen( statusProtocols[p] ) + challengeLen + infoLen >= MAX_INFO_STRING ) ) {
+		strcpy( infostring, Cvar_InfoString( CVAR_SERVERINFO ) );
 
-	for (i=0 ; i < sv_maxclients->integer ; i++) {
-		cl = &svs.clients[i];
-		if ( cl->state >= CS_CONNECTED ) {
-			ps = SV_GameClientNum( i );
-			Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n",
-				ps->persistant[PERS_SCORE], cl->ping, cl->name_ansi);
-			playerLength = strlen(player);
-			if (statusLength + playerLength >= sizeof(status) ) {
-				break;		// can't hold any more
-			}
-			strcpy (status + statusLength, player);
-			statusLength += playerLength;
-		}
+		// echo back the parameter to status. so master servers can use it as a challenge
+		// to prevent timed spoofed reply packets that add ghost servers
+		Info_SetValueForKey( infostring, "challenge", challenge );
+
+		if ( from.alternateProtocol != 0 )
+			Info_SetValueForKey( infostring, "protocol", from.alternateProtocol == 2 ? "69" : "70" );
+
+		SV_BuildStatusPlayers( status, sizeof( status ) );
+		NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+		return;
+	}
+
+	headLen = Com_sprintf( head, sizeof( head ), "statusResponse\n" );
+	if ( p != 0 ) {
+		headLen += Com_sprintf( head + headLen, sizeof( head ) - headLen, "\\protocol\\%s", statusProtocols[p] );
 	}
 
-	NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+	// serverinfo, newline, player lines
+	Com_Memcpy( status, info, infoLen );
+	status[infoLen] = '\n';
+	Com_Memcpy( status + infoLen + 1, statusCache.players, statusCache.playersLen );
+
+	SV_SendSpliced( from, head, headLen, challengePart, challengeLen,
+		status, infoLen + 1 + statusCache.playersLen );
 }
 
 /*
@@ -630,17 +1019,24 @@ if a user is interested in a server to do a full status
 ================
 */
 void SVC_Info( netadr_t from ) {
-	int		i, count;
-	char	*gamedir;
+	char	*challenge;
 	char	infostring[MAX_INFO_STRING];
+	char	challengePart[160];
+	int		challengeLen;
+	int		p;
 
 	if (sv_protect->integer & SVP_IOQ3)
 	{
+		static attackLogLimit_t addressLimit, outboundLimit;
+
 		// Prevent using getinfo as an amplifier
 		if (SVC_RateLimitAddress(from, 10, 1000))
 		{
-			SV_WriteAttackLog(va("SVC_Info: rate limit from %s exceeded, dropping request\n",
-			                     NET_AdrToString(from)));
+			if (SV_AttackLogAllowed(&addressLimit))
+			{
+				SV_WriteAttackLog(va("SVC_Info: rate limit from %s exceeded, dropping request\n",
+				                     NET_AdrToString(from)));
+			}
 			return;
 		}
 
@@ -648,61 +1044,53 @@ void SVC_Info( netadr_t from ) {
 		// excess outbound bandwidth usage when being flooded inbound
 		if (SVC_RateLimit(&outboundLeakyBucket, 10, 100))
 		{
-			SV_WriteAttackLog("SVC_Info: rate limit exceeded, dropping request\n");
+			if (SV_AttackLogAllowed(&outboundLimit))
+			{
+				SV_WriteAttackLog("SVC_Info: rate limit exceeded, dropping request\n");
+			}
 			return;
 		}
 	}
 
+	challenge = Cmd_Argv(1);
+
 	// Check whether Cmd_Argv(1) has a sane length. This was not done in the original Quake3 version which led
 	// to the Infostring bug discovered by Luigi Auriemma. See http://aluigi.altervista.org/ for the advisory.
 	// A maximum challenge length of 128 should be more than plenty.
-	if (strlen(Cmd_Argv(1)) > 128)
+	if (strlen(challenge) > 128)
 	{
 		SV_WriteAttackLog(va("SVC_Info: challenge length from %s exceeded, dropping request\n", NET_AdrToString(from)));
 		return;
 	}
 
-	// don't count privateclients
-	count = 0;
-	for ( i = sv_privateClients->integer ; i < sv_maxclients->integer ; i++ ) {
-		if ( svs.clients[i].state >= CS_CONNECTED ) {
-			count++;
-		}
+	p = from.alternateProtocol;
+	if ( p < 0 || p > 2 ) {
+		p = 0;
 	}
 
-	infostring[0] = 0;
+	SV_UpdateStatusCache( qfalse );
 
-	// echo back the parameter to status. so servers can use it as a challenge
-	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
+	// the challenge is set first, so it ends up last; splice it on the
+	// end when everything still fits the way it would have
+	challengeLen = 0;
+	if ( *challenge && SV_ChallengeSplicable( challenge ) ) {
+		challengeLen = Com_sprintf( challengePart, sizeof( challengePart ), "\\challenge\\%s", challenge );
+	}
 
-	Info_SetValueForKey( infostring, "protocol", va("%i", from.alternateProtocol == 2 ? 69 : from.alternateProtocol == 1 ? 70 : PROTOCOL_VERSION) );
-	Info_SetValueForKey( infostring, "gamename", com_gamename->string );
-	Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
-	Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
-	Info_SetValueForKey( infostring, "clients", va("%i", count) );
-	Info_SetValueForKey( infostring, "sv_maxclients",
-		va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
-	Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
+	if ( ( *challenge && !challengeLen ) || statusCache.infoLen[p] + challengeLen >= MAX_INFO_STRING ) {
+		infostring[0] = 0;
 
-#ifdef USE_VOIP
-	if (sv_voip->integer) {
-		Info_SetValueForKey( infostring, "voip", va("%i", sv_voip->integer ) );
-	}
-#endif
+		// echo back the parameter to status. so servers can use it as a challenge
+		// to prevent timed spoofed reply packets that add ghost servers
+		Info_SetValueForKey( infostring, "challenge", challenge );
+		SV_BuildInfoString( infostring, p );
 
-	if( sv_minPing->integer ) {
-		Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
-	}
-	if( sv_maxPing->integer ) {
-		Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
-	}
-	gamedir = Cvar_VariableString( "fs_game" );
-	if( *gamedir ) {
-		Info_SetValueForKey( infostring, "game", gamedir );
+		NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
+		return;
 	}
 
-	NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
+	SV_SendSpliced( from, "infoResponse\n", strlen( "infoResponse\n" ),
+		statusCache.info[p], statusCache.infoLen[p], challengePart, challengeLen );
 }
 
 /*
@@ -729,13 +1117,11 @@ static void SV_FlushRedirect( char *outputbuf ) {
 qboolean SV_CheckDRDoS(netadr_t from)
 {
 	int        i;
-	int        globalCount;
 	int        specificCount;
 	int        timeNow;
 	receipt_t  *receipt;
 	netadr_t   exactFrom;
-	int        oldest;
-	int        oldestTime;
+	long       hash;
 	static int lastGlobalLogTime   = 0;
 	static int lastSpecificLogTime = 0;
 
@@ -765,6 +1151,19 @@ qboolean SV_CheckDRDoS(netadr_t from)
 				svs.infoReceipts[i].time = 1; // hack it so we count globalCount correctly
 			}
 		}
+
+		// recount the receipts in the window, the ones ever used are the newest
+		Com_Memset(svs.infoReceiptCounts, 0, sizeof(svs.infoReceiptCounts));
+		svs.infoReceiptsLive = 0;
+		for (i = 0; i < MAX_INFO_RECEIPTS; i++)
+		{
+			receipt = &svs.infoReceipts[(svs.infoReceiptHead + i) % MAX_INFO_RECEIPTS];
+			if (receipt->time)
+			{
+				svs.infoReceiptCounts[receipt->hash]++;
+				svs.infoReceiptsLive++;
+			}
+		}
 	}
 
 	if (from.type == NA_IP)
@@ -776,39 +1175,28 @@ qboolean SV_CheckDRDoS(netadr_t from)
 		from.ip6[15] = 0;
 	}
 
-	// Count receipts in last 2 seconds.
-	globalCount   = 0;
-	specificCount = 0;
-	receipt       = &svs.infoReceipts[0];
-	oldest        = 0;
-	oldestTime    = 0x7fffffff;
-	for (i = 0; i < MAX_INFO_RECEIPTS; i++, receipt++)
+	// The receipts form a ring in the order they were sent, so the ones
+	// of the last 2 seconds are the newest svs.infoReceiptsLive of them.
+	// Drop the ones that fell out of the window, oldest first.
+	while (svs.infoReceiptsLive > 0)
 	{
+		receipt = &svs.infoReceipts[(svs.infoReceiptHead - svs.infoReceiptsLive + MAX_INFO_RECEIPTS) % MAX_INFO_RECEIPTS];
 		if (receipt->time + 2000 > timeNow)
 		{
-			if (receipt->time)
-			{
-				// When the server starts, all receipt times are at zero.  Furthermore,
-				// svs.time is close to zero.  We check that the receipt time is already
-				// set so that during the first two seconds after server starts, queries
-				// from the master servers don't get ignored.  As a consequence a potentially
-				// unlimited number of getinfo+getstatus responses may be sent during the
-				// first frame of a server's life.
-				globalCount++;
-			}
-			if (NET_CompareBaseAdr(from, receipt->adr))
-			{
-				specificCount++;
-			}
-		}
-		if (receipt->time < oldestTime)
-		{
-			oldestTime = receipt->time;
-			oldest     = i;
+			break;
 		}
+
+		svs.infoReceiptCounts[receipt->hash]--;
+		svs.infoReceiptsLive--;
 	}
 
-	if (globalCount == MAX_INFO_RECEIPTS)   // All receipts happened in last 2 seconds.
+	// When the server starts, all receipt times are at zero.  Furthermore,
+	// svs.time is close to zero.  Unused receipts are never counted, so
+	// that during the first two seconds after server starts, queries
+	// from the master servers don't get ignored.  As a consequence a potentially
+	// unlimited number of getinfo+getstatus responses may be sent during the
+	// first frame of a server's life.
+	if (svs.infoReceiptsLive == MAX_INFO_RECEIPTS)   // All receipts happened in last 2 seconds.
 	{
 		if (lastGlobalLogTime + 1000 <= timeNow)  // Limit one log every second.
 		{
@@ -818,6 +1206,23 @@ qboolean SV_CheckDRDoS(netadr_t from)
 
 		return qtrue;
 	}
+
+	// the per hash count can only overestimate, only look closer when it
+	// could reach the limit
+	hash = SVC_HashForAddress(from) & (MAX_INFO_RECEIPT_HASHES - 1);
+	specificCount = 0;
+	if (svs.infoReceiptCounts[hash] >= 3)
+	{
+		for (i = 1; i <= svs.infoReceiptsLive; i++)
+		{
+			receipt = &svs.infoReceipts[(svs.infoReceiptHead - i + MAX_INFO_RECEIPTS) % MAX_INFO_RECEIPTS];
+			if (NET_CompareBaseAdr(from, receipt->adr))
+			{
+				specificCount++;
+			}
+		}
+	}
+
 	if (specificCount >= 3)   // Already sent 3 to this IP in last 2 seconds.
 	{
 		if (lastSpecificLogTime + 1000 <= timeNow)   // Limit one log every second.
@@ -830,9 +1235,14 @@ qboolean SV_CheckDRDoS(netadr_t from)
 		return qtrue;
 	}
 
-	receipt       = &svs.infoReceipts[oldest];
+	// the oldest receipt is out of the window, reuse it
+	receipt       = &svs.infoReceipts[svs.infoReceiptHead];
 	receipt->adr  = from;
 	receipt->time = timeNow;
+	receipt->hash = hash;
+	svs.infoReceiptCounts[hash]++;
+	svs.infoReceiptsLive++;
+	svs.infoReceiptHead = (svs.infoReceiptHead + 1) % MAX_INFO_RECEIPTS;
 	return qfalse;
 }
 
@@ -972,6 +1382,79 @@ static void SV_ConnectionlessPacket( netadr_t from, msg_t *msg ) {
 	}                                                                   // note: if protect log isn't set we do Com_Printf
 }
 
+/*
+=================
+SV_FloodBenchmark_f
+
+floodbench [packets] [sources]
+
+Replays spoofed getstatus and getchallenge packets from a pool of
+made up IPv4 sources through SV_ConnectionlessPacket, with replies
+thrown away, and reports the cost per packet
+=================
+*/
+void SV_FloodBenchmark_f( void ) {
+	static const char	*requests[ 2 ] = {
+		"\xff\xff\xff\xffgetstatus 2107428918",
+		"\xff\xff\xff\xffgetchallenge 1180291417 GPP-1"
+	};
+	byte		data[ 2 ][ 64 ];
+	msg_t		msg[ 2 ];
+	netadr_t	from;
+	int			packets, sources;
+	int			i, start, msec, replies;
+	unsigned int	ip;
+
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	packets = Cmd_Argc( ) > 1 ? atoi( Cmd_Argv( 1 ) ) : 2000000;
+	sources = Cmd_Argc( ) > 2 ? atoi( Cmd_Argv( 2 ) ) : 65536;
+	if ( packets <= 0 || sources <= 0 ) {
+		Com_Printf( "usage: floodbench [packets] [sources]\n" );
+		return;
+	}
+
+	for ( i = 0; i < 2; i++ ) {
+		MSG_InitOOB( &msg[ i ], data[ i ], sizeof( data[ i ] ) );
+		MSG_WriteData( &msg[ i ], requests[ i ], strlen( requests[ i ] ) );
+	}
+
+	Com_Memset( &from, 0, sizeof( from ) );
+	from.type = NA_IP;
+
+	SVC_ClearBuckets( );
+	NET_DiscardPackets( qtrue );
+	start = Sys_Milliseconds( );
+
+	for ( i = 0; i < packets; i++ ) {
+		// scatter the source numbers over the address space
+		ip = (unsigned int)( i % sources ) * 2654435761u;
+		from.ip[ 0 ] = ip >> 24;
+		from.ip[ 1 ] = ip >> 16;
+		from.ip[ 2 ] = ip >> 8;
+		from.ip[ 3 ] = ip;
+		from.port = BigShort( 27960 + ( i & 1023 ) );
+
+		SV_ConnectionlessPacket( from, &msg[ i & 1 ] );
+	}
+
+	msec = Sys_Milliseconds( ) - start;
+	replies = NET_DiscardPackets( qfalse );
+
+	// don't let the made up sources hold buckets or receipts
+	SVC_ClearBuckets( );
+	Com_Memset( &outboundLeakyBucket, 0, sizeof( outboundLeakyBucket ) );
+	Com_Memset( svs.infoReceipts, 0, sizeof( svs.infoReceipts ) );
+	Com_Memset( svs.infoReceiptCounts, 0, sizeof( svs.infoReceiptCounts ) );
+	svs.infoReceiptHead = svs.infoReceiptsLive = 0;
+
+	Com_Printf( "%i packets from %i sources in %i msec, %.1f ns per packet, %i replies\n",
+		packets, sources, msec, msec * 1000000.0 / packets, replies );
+}
+
 //============================================================================
 
 /*
@@ -1258,13 +1741,7 @@ void SV_Frame( int msec ) {
 	// 2giga-milliseconds = 23 days, so it won't be too often
 	if ( svs.time > 0x70000000 ) {
 		SV_Shutdown( "Restarting server due to time wrapping" );
-		Cbuf_AddText( va( "map \"%s\"\n", Cvar_VariableString( "mapname" ) ) );
-		return;
-	}
-	// this can happen considerably earlier when lots of clients play and the map doesn't change
-	if ( svs.nextSnapshotEntities >= 0x7FFFFFFE - svs.numSnapshotEntities ) {
-		SV_Shutdown( "Restarting server due to numSnapshotEntities wrapping" );
-		Cbuf_AddText( va( "map \"%s\"\n", Cvar_VariableString( "mapname" ) ) );
+		Cbuf_AddText( va( "map \"%s\"\n", sv_mapname->string ) );
 		return;
 	}
 
@@ -1274,6 +1751,9 @@ void SV_Frame( int msec ) {
 		return;
 	}
 
+	// start or restart the HTTP download listener
+	SV_HTTP_Frame();
+
 	// update infostrings if anything has been changed
 	if ( cvar_modifiedFlags & CVAR_SERVERINFO ) {
 		SV_SetConfigstring( CS_SERVERINFO, Cvar_InfoString( CVAR_SERVERINFO ) );
@@ -1310,9 +1790,15 @@ void SV_Frame( int msec ) {
 	// check timeouts
 	SV_CheckTimeouts();
 
+	// drop cached getstatus / getinfo replies that no longer match
+	SV_CheckStatusCache();
+
 	// send messages back to the clients
 	SV_SendClientMessages();
 
+	// record the frame after the snapshots shared its entities
+	SV_DemoFrame();
+
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_FOR_MASTER);
 
@@ -1406,23 +1892,14 @@ void SV_Frame( int msec ) {
 
 /*
 ====================
-SV_RateMsec
+SV_ClientRate
 
-Return the number of msec until another message can be sent to
-a client based on its rate settings
+The client's rate in bytes per second, within sv_minRate and sv_maxRate
 ====================
 */
-
-#define UDPIP_HEADER_SIZE 28
-#define UDPIP6_HEADER_SIZE 48
-
-int SV_RateMsec(client_t *client)
+int SV_ClientRate(client_t *client)
 {
-	int rate, rateMsec;
-	int messageSize;
-
-	messageSize = client->netchan.lastSentSize;
-	rate = client->rate;
+	int rate = client->rate;
 
 	if(sv_maxRate->integer)
 	{
@@ -1440,6 +1917,25 @@ int SV_RateMsec(client_t *client)
 			rate = sv_minRate->integer;
 	}
 
+	return rate;
+}
+
+/*
+====================
+SV_RateMsec
+
+Return the number of msec until another message can be sent to
+a client based on its rate settings
+====================
+*/
+int SV_RateMsec(client_t *client)
+{
+	int rate, rateMsec;
+	int messageSize;
+
+	messageSize = client->netchan.lastSentSize;
+	rate = SV_ClientRate(client);
+
 	if(client->netchan.remoteAddress.type == NA_IP6)
 		messageSize += UDPIP6_HEADER_SIZE;
 	else
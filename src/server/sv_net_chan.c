@@ -137,16 +137,18 @@ SV_Netchan_FreeQueue
 */
 void SV_Netchan_FreeQueue(client_t *client)
 {
-	netchan_buffer_t *netbuf, *next;
+	netBuffer_t *netbuf, *next;
 	
 	for(netbuf = client->netchan_start_queue; netbuf; netbuf = next)
 	{
 		next = netbuf->next;
-		Z_Free(netbuf);
+		NET_ReleaseBuffer(netbuf);
 	}
 	
 	client->netchan_start_queue = NULL;
 	client->netchan_end_queue = &client->netchan_start_queue;
+
+	Netchan_ReleaseBuffer(&client->netchan);
 }
 
 /*
@@ -156,12 +158,12 @@ SV_Netchan_TransmitNextInQueue
 */
 void SV_Netchan_TransmitNextInQueue(client_t *client)
 {
-	netchan_buffer_t *netbuf;
+	netBuffer_t *netbuf;
 		
 	Com_DPrintf("#462 Netchan_TransmitNextFragment: popping a queued message for transmit\n");
 	netbuf = client->netchan_start_queue;
 
-	Netchan_Transmit(&client->netchan, netbuf->msg.cursize, netbuf->msg.data);
+	Netchan_TransmitBuffer(&client->netchan, netbuf);
 
 	// pop from queue
 	client->netchan_start_queue = netbuf->next;
@@ -173,7 +175,7 @@ void SV_Netchan_TransmitNextInQueue(client_t *client)
 	else
 		Com_DPrintf("#462 Netchan_TransmitNextFragment: remaining queued message\n");
 
-	Z_Free(netbuf);
+	NET_ReleaseBuffer(netbuf);
 }
 
 /*
@@ -210,30 +212,31 @@ https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=462
 if there are some unsent fragments (which may happen if the snapshots
 and the gamestate are fragmenting, and collide on send for instance)
 then buffer them and make sure they get sent in correct order
+
+Takes over the caller's reference to buf, the message is queued and
+fragmented from there without being copied
 ================
 */
 
-void SV_Netchan_Transmit( client_t *client, msg_t *msg)
+void SV_Netchan_Transmit( client_t *client, netBuffer_t *buf )
 {
-	MSG_WriteByte( msg, svc_EOF );
+	MSG_WriteByte( &buf->msg, svc_EOF );
 
 	if(client->netchan.unsentFragments || client->netchan_start_queue)
 	{
-		netchan_buffer_t *netbuf;
 		Com_DPrintf("#462 SV_Netchan_Transmit: unsent fragments, stacked\n");
-		netbuf = (netchan_buffer_t *) Z_Malloc(sizeof(netchan_buffer_t));
 		// store the msg, we can't store it encoded, as the encoding depends on stuff we still have to finish sending
-		MSG_Copy(&netbuf->msg, netbuf->msgBuffer, sizeof( netbuf->msgBuffer ), msg);
-		netbuf->next = NULL;
+		buf->next = NULL;
 		// insert it in the queue, the message will be encoded and sent later
-		*client->netchan_end_queue = netbuf;
-		client->netchan_end_queue = &(*client->netchan_end_queue)->next;
+		*client->netchan_end_queue = buf;
+		client->netchan_end_queue = &buf->next;
 	}
 	else
 	{
 		if (client->netchan.alternateProtocol != 0)
-			SV_Netchan_Encode( client, msg );
-		Netchan_Transmit( &client->netchan, msg->cursize, msg->data );
+			SV_Netchan_Encode( client, &buf->msg );
+		Netchan_TransmitBuffer( &client->netchan, buf );
+		NET_ReleaseBuffer( buf );
 	}
 }
 
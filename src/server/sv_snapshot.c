@@ -25,6 +25,187 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "server.h"
 
 
+/*
+=============================================================================
+
+Shared snapshot entities
+
+Each entity state that goes into a client frame is stored once in
+svs.snapshotEntities and reference counted by the frames holding it.
+Clients that see the same state, in the same or a later server frame,
+share the copy, so the pool holds the distinct states still referenced
+instead of one copy per client and frame.
+
+=============================================================================
+*/
+
+/*
+=============
+SV_SnapshotEntitiesForClients
+
+Never more than the old per client ring needed, which makes running
+out impossible for small servers.  Every entity changing on every
+backup frame is what it takes to fill MAX_GENTITIES * PACKET_BACKUP.
+The server demo recorder holds on to one more copy of every entity.
+=============
+*/
+int SV_SnapshotEntitiesForClients( int maxclients ) {
+	int		perClient;
+
+	if ( com_dedicated->integer ) {
+		perClient = maxclients * PACKET_BACKUP * MAX_SNAPSHOT_ENTITIES;
+	} else {
+		// we don't need nearly as many when playing locally
+		perClient = maxclients * 4 * MAX_SNAPSHOT_ENTITIES;
+	}
+
+	return MIN( perClient, MAX_GENTITIES * PACKET_BACKUP ) + MAX_GENTITIES;
+}
+
+/*
+=============
+SV_InitSnapshotEntities
+
+Called after the pool has been allocated on the hunk
+=============
+*/
+void SV_InitSnapshotEntities( void ) {
+	int		i, j;
+
+	for ( i = 0; i < svs.numSnapshotEntities; i++ ) {
+		svs.snapshotEntities[i].refCount = 0;
+		svs.snapshotEntities[i].nextFree = i + 1 < svs.numSnapshotEntities ? i + 1 : -1;
+	}
+	svs.freeSnapshotEntities = svs.numSnapshotEntities > 0 ? 0 : -1;
+
+	// frames from the previous level point into the old pool
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		for ( j = 0; j < PACKET_BACKUP; j++ ) {
+			svs.clients[i].frames[j].num_entities = 0;
+		}
+	}
+}
+
+/*
+=============
+SV_ReleaseSnapshotEntity
+=============
+*/
+void SV_ReleaseSnapshotEntity( int index ) {
+	snapshotEntity_t	*se = &svs.snapshotEntities[ index ];
+
+	if ( --se->refCount == 0 ) {
+		se->nextFree = svs.freeSnapshotEntities;
+		svs.freeSnapshotEntities = index;
+	}
+}
+
+/*
+=============
+SV_ReleaseClientSnapshot
+=============
+*/
+static void SV_ReleaseClientSnapshot( clientSnapshot_t *frame ) {
+	int		i;
+
+	for ( i = 0; i < frame->num_entities; i++ ) {
+		SV_ReleaseSnapshotEntity( frame->entities[i] );
+	}
+
+	frame->num_entities = 0;
+}
+
+/*
+=============
+SV_ReleaseClientSnapshots
+
+Drops the client's hold on the shared entities, the frames can't
+be delta compressed against afterwards
+=============
+*/
+void SV_ReleaseClientSnapshots( client_t *client ) {
+	int		i;
+
+	for ( i = 0; i < PACKET_BACKUP; i++ ) {
+		SV_ReleaseClientSnapshot( &client->frames[i] );
+	}
+}
+
+/*
+=============
+SV_ReclaimSnapshotEntities
+
+The pool is full, give up the oldest frame of any client other than
+the one being built.  A client deltaing from it gets a full snapshot.
+=============
+*/
+static qboolean SV_ReclaimSnapshotEntities( clientSnapshot_t *building ) {
+	clientSnapshot_t	*frame, *oldest = NULL;
+	int					i, j;
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		for ( j = 0; j < PACKET_BACKUP; j++ ) {
+			frame = &svs.clients[i].frames[j];
+			if ( frame == building || frame->num_entities <= 0 ) {
+				continue;
+			}
+
+			if ( !oldest || frame->messageSent < oldest->messageSent ) {
+				oldest = frame;
+			}
+		}
+	}
+
+	if ( !oldest ) {
+		return qfalse;
+	}
+
+	Com_DPrintf( "SV_ReclaimSnapshotEntities: snapshot entities exhausted\n" );
+	SV_ReleaseClientSnapshot( oldest );
+	oldest->num_entities = -1;
+	return qtrue;
+}
+
+/*
+=============
+SV_ShareSnapshotEntity
+
+Returns the shared copy of the entity's current state, making one
+if the last copy is gone or out of date.  building is NULL when the
+server demo recorder takes a reference.
+=============
+*/
+int SV_ShareSnapshotEntity( clientSnapshot_t *building, int entnum ) {
+	sharedEntity_t		*ent = SV_GentityNum( entnum );
+	svEntity_t			*svEnt = &sv.svEntities[ entnum ];
+	snapshotEntity_t	*se;
+	int					index = svEnt->snapshotEntity;
+
+	if ( index >= 0 && index < svs.numSnapshotEntities ) {
+		se = &svs.snapshotEntities[ index ];
+		if ( se->refCount > 0 && !memcmp( &se->s, &ent->s, sizeof( entityState_t ) ) ) {
+			se->refCount++;
+			return index;
+		}
+	}
+
+	while ( svs.freeSnapshotEntities < 0 ) {
+		if ( !SV_ReclaimSnapshotEntities( building ) ) {
+			Com_Error( ERR_DROP, "SV_ShareSnapshotEntity: no free snapshot entities" );
+		}
+	}
+
+	index = svs.freeSnapshotEntities;
+	se = &svs.snapshotEntities[ index ];
+	svs.freeSnapshotEntities = se->nextFree;
+
+	se->s = ent->s;
+	se->refCount = 1;
+	svEnt->snapshotEntity = index;
+
+	return index;
+}
+
 /*
 =============================================================================
 
@@ -75,14 +256,14 @@ static void SV_EmitPacketEntities( client_t *client, int alternateProtocol, clie
 		if ( newindex >= to->num_entities ) {
 			newnum = 9999;
 		} else {
-			newent = &svs.snapshotEntities[(to->first_entity+newindex) % svs.numSnapshotEntities];
+			newent = &svs.snapshotEntities[to->entities[newindex]].s;
 			newnum = newent->number;
 		}
 
 		if ( oldindex >= from_num_entities ) {
 			oldnum = 9999;
 		} else {
-			oldent = &svs.snapshotEntities[(from->first_entity+oldindex) % svs.numSnapshotEntities];
+			oldent = &svs.snapshotEntities[from->entities[oldindex]].s;
 			oldnum = oldent->number;
 		}
 
@@ -116,6 +297,274 @@ static void SV_EmitPacketEntities( client_t *client, int alternateProtocol, clie
 
 
 
+/*
+=============================================================================
+
+Snapshot entity priorities
+
+When the entities of a snapshot don't fit what the client's rate allows
+per snapshot, or would overflow the message, the most important changes
+are sent and the rest are held back: an entity the client already has
+stays at the state it was last sent, a new one is left out until later.
+Either way the frame records what the client really got, so the next
+delta starts from the right place.  Entities gain priority for every
+snapshot they are held back from, so everything gets through eventually.
+
+=============================================================================
+*/
+
+// below this the rate delay in SV_SendClientMessages does the limiting
+#define SNAPSHOT_MIN_BUDGET		400
+// room left for VoIP and padding
+#define SNAPSHOT_MAX_BUDGET		( MAX_MSGLEN - 256 )
+
+typedef struct {
+	int		index;			// into the frame's entities
+	int		oldIndex;		// state the client has, -1 for a new entity
+	int		bits;			// cost of the update
+	float	priority;
+} snapshotCandidate_t;
+
+/*
+=============
+SV_SnapshotBudget
+
+Bytes a snapshot may take up
+=============
+*/
+static int SV_SnapshotBudget( client_t *client ) {
+	int		budget;
+
+	if ( client->netchan.remoteAddress.type == NA_LOOPBACK ||
+		( sv_lanForceRate->integer && Sys_IsLANAddress( client->netchan.remoteAddress ) ) ) {
+		return SNAPSHOT_MAX_BUDGET;
+	}
+
+	budget = SV_ClientRate( client ) * client->snapshotMsec / 1000;
+	budget -= client->netchan.remoteAddress.type == NA_IP6 ? UDPIP6_HEADER_SIZE : UDPIP_HEADER_SIZE;
+
+	if ( budget < SNAPSHOT_MIN_BUDGET ) {
+		return SNAPSHOT_MIN_BUDGET;
+	}
+	if ( budget > SNAPSHOT_MAX_BUDGET ) {
+		return SNAPSHOT_MAX_BUDGET;
+	}
+	return budget;
+}
+
+/*
+=============
+SV_SnapshotEntityPriority
+=============
+*/
+static float SV_SnapshotEntityPriority( client_t *client, clientSnapshot_t *frame, entityState_t *state ) {
+	vec3_t	delta;
+	float	distance, priority;
+
+	VectorSubtract( state->pos.trBase, frame->ps.origin, delta );
+	distance = VectorLength( delta );
+	priority = 1024.0f / ( 64.0f + distance );
+
+	if ( state->number == frame->ps.persistant[ PERS_ATTACKER ] ||
+		state->otherEntityNum == frame->ps.clientNum ) {
+		// whoever is shooting at us
+		priority *= 4.0f;
+	} else if ( state->eType == ET_PLAYER ) {
+		priority *= 2.0f;
+	} else if ( state->eType == ET_BUILDABLE && distance < 1000.0f ) {
+		priority *= 2.0f;
+	}
+
+	// events don't last long enough to wait for
+	if ( state->eType >= ET_EVENTS || state->event ) {
+		priority *= 2.0f;
+	}
+
+	return priority * ( 1 + client->snapshotDeferred[ state->number ] );
+}
+
+/*
+=============
+SV_SortSnapshotCandidates
+=============
+*/
+static int QDECL SV_SortSnapshotCandidates( const void *a, const void *b ) {
+	const snapshotCandidate_t	*ca = a, *cb = b;
+
+	if ( ca->priority > cb->priority ) {
+		return -1;
+	}
+	if ( ca->priority < cb->priority ) {
+		return 1;
+	}
+	return ca->index - cb->index;
+}
+
+/*
+=============
+SV_MeasureDeltaEntity
+
+Bits MSG_WriteDeltaEntity will take for this update
+=============
+*/
+static int SV_MeasureDeltaEntity( msg_t *scratch, int alternateProtocol,
+	entityState_t *from, entityState_t *to, qboolean force ) {
+	MSG_Clear( scratch );
+	MSG_WriteDeltaEntity( alternateProtocol, scratch, from, to, force );
+	return scratch->bit;
+}
+
+/*
+=============
+SV_PrioritizeSnapshotEntities
+
+Holds back entity updates of the frame until the rest fits in budgetBits,
+returns how many were held back.  The most important update goes out as
+long as it fits in roomBits, even when the server commands and the
+playerstate have used up the budget, so nothing waits forever.
+=============
+*/
+static int SV_PrioritizeSnapshotEntities( client_t *client, clientSnapshot_t *from,
+	clientSnapshot_t *to, int budgetBits, int roomBits ) {
+	static snapshotCandidate_t	candidates[ MAX_SNAPSHOT_ENTITIES ];
+	static byte		scratchBuf[ MAX_MSGLEN ];
+	msg_t			scratch;
+	int				alternateProtocol = client->netchan.alternateProtocol;
+	int				numCandidates = 0;
+	int				oldindex, newindex, oldnum, newnum;
+	int				from_num_entities = from ? from->num_entities : 0;
+	int				i, numEntities, deferred, fixedBits;
+	entityState_t	*oldent = NULL, *newent = NULL;
+	snapshotCandidate_t	*c;
+
+	MSG_Init( &scratch, scratchBuf, sizeof( scratchBuf ) );
+
+	// the end marker and the removals always go out
+	fixedBits = GENTITYNUM_BITS;
+
+	// the same walk as SV_EmitPacketEntities
+	newindex = 0;
+	oldindex = 0;
+	while ( newindex < to->num_entities || oldindex < from_num_entities ) {
+		if ( newindex >= to->num_entities ) {
+			newnum = 9999;
+		} else {
+			newent = &svs.snapshotEntities[to->entities[newindex]].s;
+			newnum = newent->number;
+		}
+
+		if ( oldindex >= from_num_entities ) {
+			oldnum = 9999;
+		} else {
+			oldent = &svs.snapshotEntities[from->entities[oldindex]].s;
+			oldnum = oldent->number;
+		}
+
+		if ( newnum == oldnum ) {
+			if ( to->entities[newindex] != from->entities[oldindex] ) {
+				c = &candidates[ numCandidates++ ];
+				c->index = newindex;
+				c->oldIndex = from->entities[oldindex];
+				c->bits = SV_MeasureDeltaEntity( &scratch, alternateProtocol, oldent, newent, qfalse );
+			}
+			oldindex++;
+			newindex++;
+		} else if ( newnum < oldnum ) {
+			c = &candidates[ numCandidates++ ];
+			c->index = newindex;
+			c->oldIndex = -1;
+			c->bits = SV_MeasureDeltaEntity( &scratch, alternateProtocol,
+				&sv.svEntities[newnum].baseline[client - svs.clients], newent, qtrue );
+			newindex++;
+		} else {
+			fixedBits += SV_MeasureDeltaEntity( &scratch, alternateProtocol, oldent, NULL, qtrue );
+			oldindex++;
+		}
+	}
+
+	for ( i = 0; i < numCandidates; i++ ) {
+		c = &candidates[ i ];
+		c->priority = SV_SnapshotEntityPriority( client, to, &svs.snapshotEntities[ to->entities[ c->index ] ].s );
+	}
+	qsort( candidates, numCandidates, sizeof( candidates[0] ), SV_SortSnapshotCandidates );
+
+	budgetBits -= fixedBits;
+	roomBits -= fixedBits;
+
+	// fill the budget by priority, smaller updates further down can
+	// still fit in after a big one didn't
+	deferred = 0;
+	for ( i = 0; i < numCandidates; i++ ) {
+		c = &candidates[ i ];
+		newent = &svs.snapshotEntities[ to->entities[ c->index ] ].s;
+
+		if ( c->bits <= budgetBits || ( i == 0 && c->bits <= roomBits ) ) {
+			budgetBits -= c->bits;
+			client->snapshotDeferred[ newent->number ] = 0;
+			continue;
+		}
+
+		if ( client->snapshotDeferred[ newent->number ] < 255 ) {
+			client->snapshotDeferred[ newent->number ]++;
+		}
+
+		// the client keeps what it has
+		SV_ReleaseSnapshotEntity( to->entities[ c->index ] );
+		if ( c->oldIndex >= 0 ) {
+			svs.snapshotEntities[ c->oldIndex ].refCount++;
+		}
+		to->entities[ c->index ] = c->oldIndex;
+		deferred++;
+	}
+
+	// drop the new entities that were held back, keeping the order
+	numEntities = 0;
+	for ( i = 0; i < to->num_entities; i++ ) {
+		if ( to->entities[i] >= 0 ) {
+			to->entities[ numEntities++ ] = to->entities[i];
+		}
+	}
+	to->num_entities = numEntities;
+
+	return deferred;
+}
+
+/*
+=============
+SV_EmitSnapshotEntities
+
+SV_EmitPacketEntities, holding back the least important entities if
+they don't fit
+=============
+*/
+static void SV_EmitSnapshotEntities( client_t *client, clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg ) {
+	int			markBit = msg->bit;
+	int			markSize = msg->cursize;
+	qboolean	markOverflowed = msg->overflowed;
+	int			budget;
+
+	SV_EmitPacketEntities( client, client->netchan.alternateProtocol, from, to, msg );
+
+	if ( !sv_snapshotPriority->integer || markOverflowed ) {
+		return;
+	}
+
+	budget = SV_SnapshotBudget( client );
+	if ( !msg->overflowed && msg->cursize <= budget ) {
+		return;
+	}
+
+	// take the entities back out and write only what fits
+	msg->bit = markBit;
+	msg->cursize = markSize;
+	msg->overflowed = qfalse;
+	msg->data[ markBit >> 3 ] &= ( 1 << ( markBit & 7 ) ) - 1;
+
+	SV_PrioritizeSnapshotEntities( client, from, to, ( budget - markSize ) * 8,
+		( SNAPSHOT_MAX_BUDGET - markSize ) * 8 );
+	SV_EmitPacketEntities( client, client->netchan.alternateProtocol, from, to, msg );
+}
+
 /*
 ==================
 SV_WriteSnapshotToClient
@@ -146,8 +595,8 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 		oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
 		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
-		// the snapshot's entities may still have rolled off the buffer, though
-		if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		// the snapshot's entities may still have been reclaimed, though
+		if ( oldframe->num_entities < 0 ) {
 			Com_DPrintf ("%s: Delta request from out of date entities.\n", client->name);
 			oldframe = NULL;
 			lastframe = 0;
@@ -199,7 +648,7 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 
 	// delta encode the entities
-	SV_EmitPacketEntities (client, client->netchan.alternateProtocol, oldframe, frame, msg);
+	SV_EmitSnapshotEntities (client, oldframe, frame, msg);
 
 	// padding for rate debugging
 	if ( sv_padPackets->integer ) {
@@ -465,8 +914,6 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	clientSnapshot_t			*frame;
 	snapshotEntityNumbers_t		entityNumbers;
 	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
 	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	int							clientNum;
@@ -483,7 +930,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
   // https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=62
-	frame->num_entities = 0;
+	SV_ReleaseClientSnapshot( frame );
 
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
@@ -525,18 +972,10 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
+	// share the entity states out
 	frame->num_entities = 0;
-	frame->first_entity = svs.nextSnapshotEntities;
 	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
-		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
-		*state = ent->s;
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
-			Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
-		}
+		frame->entities[i] = SV_ShareSnapshotEntity( frame, entityNumbers.snapshotEntities[i] );
 		frame->num_entities++;
 	}
 }
@@ -600,58 +1039,100 @@ SV_SendMessageToClient
 Called by SV_SendClientSnapshot and SV_SendClientGameState
 =======================
 */
-void SV_SendMessageToClient(msg_t *msg, client_t *client)
+void SV_SendMessageToClient(netBuffer_t *buf, client_t *client)
 {
 	// record information about the message
-	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = msg->cursize;
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = buf->msg.cursize;
 	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSent = svs.time;
 	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageAcked = -1;
 
 	// send the datagram
-	SV_Netchan_Transmit(client, msg);
+	SV_Netchan_Transmit(client, buf);
 }
 
 
 /*
 =======================
-SV_SendClientSnapshot
-
-Also called by SV_FinalMessage
+SV_TransmitClientSnapshot
 
+Encodes and sends the frame SV_BuildClientSnapshot made
 =======================
 */
-void SV_SendClientSnapshot( client_t *client ) {
-	byte		msg_buf[MAX_MSGLEN];
-	msg_t		msg;
-
-	// build the snapshot
-	SV_BuildClientSnapshot( client );
+static void SV_TransmitClientSnapshot( client_t *client ) {
+	netBuffer_t	*buf;
+	msg_t		*msg;
 
-	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
-	msg.allowoverflow = qtrue;
+	buf = NET_AllocBuffer( );
+	msg = &buf->msg;
+	msg->allowoverflow = qtrue;
 
 	// NOTE, MRE: all server->client messages now acknowledge
 	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	MSG_WriteLong( msg, client->lastClientCommand );
 
 	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_UpdateServerCommandsToClient( client, msg );
 
 	// send over all the relevant entityState_t
 	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+	SV_WriteSnapshotToClient( client, msg );
 
 #ifdef USE_VOIP
-	SV_WriteVoipToClient( client, &msg );
+	SV_WriteVoipToClient( client, msg );
 #endif
 
 	// check for overflow
-	if ( msg.overflowed ) {
+	if ( msg->overflowed ) {
 		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
-		MSG_Clear (&msg);
+		MSG_Clear (msg);
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	SV_SendMessageToClient( buf, client );
+}
+
+/*
+=======================
+SV_SendClientSnapshot
+
+Also called by SV_FinalMessage
+
+=======================
+*/
+void SV_SendClientSnapshot( client_t *client ) {
+	// build the snapshot
+	SV_BuildClientSnapshot( client );
+
+	SV_TransmitClientSnapshot( client );
+}
+
+/*
+=======================
+SV_SendBenchmarkSnapshot
+
+SV_SendClientSnapshot for snapbench, which decides what is visible
+instead of the PVS.  entityNums must be sorted.
+=======================
+*/
+void SV_SendBenchmarkSnapshot( client_t *client, const int *entityNums, int numEntities ) {
+	clientSnapshot_t	*frame;
+	int					i;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+	SV_ReleaseClientSnapshot( frame );
+
+	frame->ps = *SV_GameClientNum( client - svs.clients );
+
+	// everything visible
+	frame->areabytes = MAX_MAP_AREA_BYTES;
+	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
+
+	frame->num_entities = 0;
+	for ( i = 0; i < numEntities && i < MAX_SNAPSHOT_ENTITIES; i++ ) {
+		frame->entities[i] = SV_ShareSnapshotEntity( frame, entityNums[i] );
+		frame->num_entities++;
+	}
+
+	SV_TransmitClientSnapshot( client );
 }
 
 
@@ -662,8 +1143,10 @@ SV_SendClientMessages
 */
 void SV_SendClientMessages(void)
 {
-	int		i;
+	int		i, start;
 	client_t	*c;
+	clientSnapshot_t	*frame;
+	svProtocolStats_t	*stats;
 
 	// send a message to each connected client
 	for(i=0; i < sv_maxclients->integer; i++)
@@ -699,7 +1182,13 @@ void SV_SendClientMessages(void)
 		}
 
 		// generate and send a new message
+		stats = &svs.protocolStats[ c->netchan.alternateProtocol ];
+		frame = &c->frames[ c->netchan.outgoingSequence & PACKET_MASK ];
+		start = Sys_Milliseconds( );
 		SV_SendClientSnapshot(c);
+		stats->snapshotMsec += Sys_Milliseconds( ) - start;
+		stats->snapshotBytes += frame->messageSize;
+		stats->snapshots++;
 		c->lastSnapshotTime = svs.time;
 		c->rateDelayed = qfalse;
 	}
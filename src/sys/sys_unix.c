@@ -40,6 +40,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <fcntl.h>
 #include <fenv.h>
 #include <sys/wait.h>
+#include <pthread.h>
 
 qboolean stdinIsATTY;
 
@@ -191,6 +192,76 @@ qboolean Sys_Mkdir( const char *path )
 	return qtrue;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, returns NULL on failure
+==================
+*/
+void *Sys_MapFile( const char *ospath, int *size )
+{
+	struct stat	buf;
+	void		*base;
+	int			fd;
+
+	fd = open( ospath, O_RDONLY );
+	if( fd < 0 )
+		return NULL;
+
+	if( fstat( fd, &buf ) || !S_ISREG( buf.st_mode ) || buf.st_size <= 0 || buf.st_size > INT_MAX )
+	{
+		close( fd );
+		return NULL;
+	}
+
+	base = mmap( NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+
+	if( base == MAP_FAILED )
+		return NULL;
+
+	*size = (int)buf.st_size;
+	return base;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *base, int size )
+{
+	munmap( base, size );
+}
+
+/*
+==================
+Sys_FileStat
+==================
+*/
+qboolean Sys_FileStat( const char *ospath, int64_t *size, int64_t *mtime )
+{
+	struct stat buf;
+
+	if( stat( ospath, &buf ) || !S_ISREG( buf.st_mode ) )
+		return qfalse;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return qtrue;
+}
+
+/*
+==================
+Sys_PID
+==================
+*/
+int Sys_PID( void )
+{
+	return getpid( );
+}
+
 /*
 ==================
 Sys_Mkfifo
@@ -408,6 +479,131 @@ void Sys_FreeFileList( char **list )
 	Z_Free( list );
 }
 
+typedef struct
+{
+	pthread_t		thread;
+	sysThreadFunc_t	func;
+	void			*arg;
+} sysThread_t;
+
+/*
+==================
+Sys_ThreadMain
+==================
+*/
+static void *Sys_ThreadMain( void *arg )
+{
+	sysThread_t *thread = arg;
+
+	thread->func( thread->arg );
+	return NULL;
+}
+
+/*
+==================
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==================
+*/
+void *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->arg = arg;
+
+	if( pthread_create( &thread->thread, NULL, Sys_ThreadMain, thread ) )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==================
+Sys_JoinThread
+==================
+*/
+void Sys_JoinThread( void *thread )
+{
+	pthread_join( ( (sysThread_t *)thread )->thread, NULL );
+	free( thread );
+}
+
+/*
+==================
+Sys_ProcessorCount
+==================
+*/
+int Sys_ProcessorCount( void )
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+	return count > 0 ? (int)count : 1;
+}
+
+/*
+==================
+Sys_CreateMutex
+
+Returns NULL if the mutex could not be created
+==================
+*/
+void *Sys_CreateMutex( void )
+{
+	pthread_mutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if( !mutex )
+		return NULL;
+
+	if( pthread_mutex_init( mutex, NULL ) )
+	{
+		free( mutex );
+		return NULL;
+	}
+
+	return mutex;
+}
+
+/*
+==================
+Sys_DestroyMutex
+==================
+*/
+void Sys_DestroyMutex( void *mutex )
+{
+	pthread_mutex_destroy( mutex );
+	free( mutex );
+}
+
+/*
+==================
+Sys_LockMutex
+==================
+*/
+void Sys_LockMutex( void *mutex )
+{
+	pthread_mutex_lock( mutex );
+}
+
+/*
+==================
+Sys_UnlockMutex
+==================
+*/
+void Sys_UnlockMutex( void *mutex )
+{
+	pthread_mutex_unlock( mutex );
+}
+
 /*
 ==================
 Sys_Sleep
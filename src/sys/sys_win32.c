@@ -41,6 +41,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <shlobj.h>
 #include <psapi.h>
 #include <float.h>
+#include <sys/stat.h>
 
 // Used to determine where to store user-specific files
 static char homePath[ MAX_OSPATH ] = { 0 };
@@ -262,6 +263,33 @@ qboolean Sys_Mkdir( const char *path )
 	return qtrue;
 }
 
+/*
+==================
+Sys_FileStat
+==================
+*/
+qboolean Sys_FileStat( const char *ospath, int64_t *size, int64_t *mtime )
+{
+	struct __stat64 buf;
+
+	if( _stat64( ospath, &buf ) || !( buf.st_mode & _S_IFREG ) )
+		return qfalse;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return qtrue;
+}
+
+/*
+==================
+Sys_PID
+==================
+*/
+int Sys_PID( void )
+{
+	return GetCurrentProcessId( );
+}
+
 /*
 ==================
 Sys_Mkfifo
@@ -273,6 +301,56 @@ FILE *Sys_Mkfifo( const char *ospath )
 	return NULL;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, returns NULL on failure
+==================
+*/
+void *Sys_MapFile( const char *ospath, int *size )
+{
+	HANDLE			file, mapping;
+	LARGE_INTEGER	fileSize;
+	void			*base;
+
+	file = CreateFile( ospath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+		return NULL;
+
+	if( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart <= 0 || fileSize.QuadPart > INT_MAX )
+	{
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if( !mapping )
+		return NULL;
+
+	// the view keeps the mapping alive
+	base = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+
+	if( !base )
+		return NULL;
+
+	*size = (int)fileSize.QuadPart;
+	return base;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *base, int size )
+{
+	UnmapViewOfFile( base );
+}
+
 /*
 ==============================================================
 
@@ -485,6 +563,129 @@ void Sys_FreeFileList( char **list )
 }
 
 
+typedef struct
+{
+	HANDLE			thread;
+	sysThreadFunc_t	func;
+	void			*arg;
+} sysThread_t;
+
+/*
+==============
+Sys_ThreadMain
+==============
+*/
+static DWORD WINAPI Sys_ThreadMain( LPVOID arg )
+{
+	sysThread_t *thread = arg;
+
+	thread->func( thread->arg );
+	return 0;
+}
+
+/*
+==============
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==============
+*/
+void *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->arg = arg;
+	thread->thread = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, NULL );
+
+	if( !thread->thread )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==============
+Sys_JoinThread
+==============
+*/
+void Sys_JoinThread( void *thread )
+{
+	WaitForSingleObject( ( (sysThread_t *)thread )->thread, INFINITE );
+	CloseHandle( ( (sysThread_t *)thread )->thread );
+	free( thread );
+}
+
+/*
+==============
+Sys_ProcessorCount
+==============
+*/
+int Sys_ProcessorCount( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+/*
+==============
+Sys_CreateMutex
+
+Returns NULL if the mutex could not be created
+==============
+*/
+void *Sys_CreateMutex( void )
+{
+	CRITICAL_SECTION *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if( !mutex )
+		return NULL;
+
+	InitializeCriticalSection( mutex );
+	return mutex;
+}
+
+/*
+==============
+Sys_DestroyMutex
+==============
+*/
+void Sys_DestroyMutex( void *mutex )
+{
+	DeleteCriticalSection( mutex );
+	free( mutex );
+}
+
+/*
+==============
+Sys_LockMutex
+==============
+*/
+void Sys_LockMutex( void *mutex )
+{
+	EnterCriticalSection( mutex );
+}
+
+/*
+==============
+Sys_UnlockMutex
+==============
+*/
+void Sys_UnlockMutex( void *mutex )
+{
+	LeaveCriticalSection( mutex );
+}
+
 /*
 ==============
 Sys_Sleep